@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+
+"""
+compare_results.py
+
+Compara dos conjuntos de resultados (base y candidato), p. ej. antes y
+después de actualizar el kernel, el sistema de archivos o el firmware, y
+sirve de control de regresiones: termina con código 1 si alguna
+configuración empeora más allá del umbral.
+
+Las configuraciones se emparejan por mecanismo, tamaño de archivo, tamaño de
+búfer y modo de sincronización. Para cada una se comparan, ejecución a
+ejecución, el rendimiento (MB/s) y la CPU por byte (ns de usuario + sistema
+medidos por el propio programa), con la prueba t de Welch al 95%. Una
+diferencia cuenta como regresión solo si supera el umbral y es
+estadísticamente significativa, para no fallar por el ruido entre ejecuciones.
+
+El control también falla (código 1) si una configuración de la base no
+aparece en el candidato (un mecanismo que deja de funcionar tras la
+actualización no produce filas), salvo con --allow-missing, y si alguna
+configuración tiene menos de --min-runs ejecuciones en uno de los dos
+conjuntos, porque entonces la prueba no puede detectar una regresión.
+
+Cada conjunto puede ser un directorio de resultados (results/ o results/raw)
+o un archivo .jsonl. De un directorio se leen los runs*.jsonl (--json-out)
+y, si no hay, los app.log del árbol <mecanismo>/<tamaño>/<buf>KB/<sync>/run_<n>.
+Solo se usa la biblioteca estándar, para poder ejecutarlo en cualquier
+máquina de la flota sin pandas.
+
+Uso:
+  scripts/compare_results.py BASE CANDIDATO [--threshold 5] [--cpu-threshold 10]
+                             [--min-runs 2] [--allow-missing] [--filter REGEX] [--csv salida.csv]
+"""
+
+import argparse
+import csv
+import glob
+import json
+import math
+import os
+import re
+import statistics
+import sys
+
+# Valores críticos de la t de Student (dos colas, 95%) para 1..30 grados de libertad
+T_CRITICAL_95 = [12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042]
+
+CONFIG_KEYS = ('mechanism', 'file_size', 'buffer_size_kb', 'sync_mode')
+
+# --- Carga de las ejecuciones ---
+
+def get_file_size_bytes(size_str):
+    """Convierte un string como '10M' a bytes."""
+    size_map = {'K': 1024, 'M': 1024**2, 'G': 1024**3}
+    match = re.match(r'(\d+)', size_str)
+    if not match:
+        return 0
+    num = int(match.group(1))
+    unit = size_str[-1].upper()
+    return num * size_map.get(unit, 1)
+
+
+def parse_app_log(file_path):
+    """Lee las líneas Clave: valor de un app.log."""
+    metrics = {}
+    with open(file_path, 'r') as f:
+        for line in f:
+            if ':' in line:
+                key, value = line.split(':', 1)
+                metrics[key.strip()] = value.strip()
+    return metrics
+
+
+def load_rows(path):
+    """Devuelve las ejecuciones de un conjunto como diccionarios con los parámetros y las claves."""
+    if os.path.isfile(path):
+        files = [path]
+    else:
+        if os.path.isdir(os.path.join(path, 'raw')):
+            path = os.path.join(path, 'raw')
+        files = sorted(glob.glob(os.path.join(path, 'runs*.jsonl')))
+
+    rows = []
+    for file_path in files:
+        with open(file_path, 'r') as f:
+            rows.extend(json.loads(line) for line in f if line.strip())
+    if files:
+        return rows
+
+    for root, _, names in os.walk(path):
+        if 'app.log' not in names:
+            continue
+        parts = root.replace(path, '').strip(os.sep).split(os.sep)
+        if len(parts) != 5:
+            continue
+        mechanism, file_size, buffer_size, sync_mode, run_id = parts
+        row = parse_app_log(os.path.join(root, 'app.log'))
+        row.update({'mechanism': mechanism, 'file_size': file_size,
+                    'buffer_size_kb': int(buffer_size.replace('KB', '')),
+                    'sync_mode': sync_mode, 'run': int(run_id.replace('run_', ''))})
+        rows.append(row)
+    return rows
+
+
+def number(row, *keys):
+    """Primer valor numérico entre las claves dadas, o None."""
+    for key in keys:
+        try:
+            return float(row[key])
+        except (KeyError, TypeError, ValueError):
+            continue
+    return None
+
+
+def collect(rows, pattern):
+    """Agrupa por configuración las listas de rendimiento (MB/s) y de CPU (ns/byte)."""
+    configs = {}
+    for row in rows:
+        # iobench hace su propio barrido: los parámetros salen de cada bloque
+        if row.get('Binary') == 'iobench' or 'Engine' in row:
+            if 'Repetition' not in row:
+                continue  # Bloque de resumen de la combinación
+            row.setdefault('mechanism', f"iobench_{row['Engine']}")
+            row.setdefault('buffer_size_kb', int(row['BufferSize']) // 1024)
+        if row.get('side') == 'server':
+            continue
+        if not all(k in row for k in CONFIG_KEYS):
+            continue
+        if pattern and not re.search(pattern, row['mechanism']):
+            continue
+
+        size_bytes = get_file_size_bytes(str(row['file_size']))
+        time_s = number(row, 'TimeTaken', 'TimeTakenClient')
+        throughput = number(row, 'AggregateThroughputMBs')
+        if throughput is None and time_s:
+            throughput = size_bytes / (1024**2) / time_s
+        if throughput is None:
+            continue
+        cpu_s = None
+        user, system = number(row, 'RusageUserTime', 'UserTime'), number(row, 'RusageSysTime', 'SysTime')
+        if user is not None and system is not None and size_bytes > 0:
+            cpu_s = (user + system) * 1e9 / size_bytes
+
+        key = (row['mechanism'], str(row['file_size']), int(row['buffer_size_kb']), row['sync_mode'])
+        entry = configs.setdefault(key, {'throughput': [], 'cpu': []})
+        entry['throughput'].append(throughput)
+        if cpu_s is not None:
+            entry['cpu'].append(cpu_s)
+    return configs
+
+# --- Estadística ---
+
+def t_critical_95(df):
+    if df <= 30:
+        return T_CRITICAL_95[max(int(df), 1) - 1]
+    return 1.96 + 2.4 / df
+
+
+def welch(base, cand):
+    """Medias, diferencia relativa (%) y si es significativa (t de Welch, 95%)."""
+    if not base or not cand:
+        return None
+    mb, mc = statistics.mean(base), statistics.mean(cand)
+    delta = 100.0 * (mc - mb) / mb if mb else math.nan
+    if len(base) < 2 or len(cand) < 2:
+        return mb, mc, delta, False
+    vb, vc = statistics.variance(base) / len(base), statistics.variance(cand) / len(cand)
+    if vb + vc == 0:
+        return mb, mc, delta, mb != mc
+    t = (mc - mb) / math.sqrt(vb + vc)
+    df = (vb + vc) ** 2 / (vb ** 2 / (len(base) - 1) + vc ** 2 / (len(cand) - 1))
+    return mb, mc, delta, abs(t) > t_critical_95(df)
+
+# --- Proceso Principal ---
+
+def main():
+    parser = argparse.ArgumentParser(description='Compara dos conjuntos de resultados y detecta regresiones.')
+    parser.add_argument('baseline', help='Resultados de referencia (directorio o .jsonl)')
+    parser.add_argument('candidate', help='Resultados a evaluar (directorio o .jsonl)')
+    parser.add_argument('--threshold', type=float, default=5.0,
+                        help='Caída de rendimiento (%%) a partir de la cual hay regresión (por defecto 5)')
+    parser.add_argument('--cpu-threshold', type=float, default=10.0,
+                        help='Aumento de CPU por byte (%%) a partir del cual hay regresión (por defecto 10)')
+    parser.add_argument('--min-runs', type=int, default=2,
+                        help='Ejecuciones mínimas por configuración en cada conjunto (por defecto 2)')
+    parser.add_argument('--allow-missing', action='store_true',
+                        help='No fallar por configuraciones de la base ausentes en el candidato')
+    parser.add_argument('--filter', help='Solo los mecanismos que coincidan con esta expresión regular')
+    parser.add_argument('--csv', help='Guardar la comparación en este CSV')
+    args = parser.parse_args()
+    if args.min_runs < 2:
+        parser.error('--min-runs debe ser al menos 2 (la prueba t necesita la varianza)')
+
+    base = collect(load_rows(args.baseline), args.filter)
+    cand = collect(load_rows(args.candidate), args.filter)
+    if not base or not cand:
+        print(f"ERROR: No se encontraron ejecuciones en '{args.baseline if not base else args.candidate}'.")
+        sys.exit(2)
+
+    common = sorted(set(base) & set(cand))
+    results = []
+    for key in common:
+        tput = welch(base[key]['throughput'], cand[key]['throughput'])
+        cpu = welch(base[key]['cpu'], cand[key]['cpu'])
+        regression = tput[2] < -args.threshold and tput[3]
+        if cpu is not None:
+            regression = regression or (cpu[2] > args.cpu_threshold and cpu[3])
+        runs = min(len(base[key]['throughput']), len(cand[key]['throughput']))
+        if runs < args.min_runs:
+            verdict = 'INSUFICIENTE'
+        elif regression:
+            verdict = 'REGRESION'
+        elif tput[2] > args.threshold and tput[3]:
+            verdict = 'MEJORA'
+        else:
+            verdict = '='
+        results.append({
+            'mechanism': key[0], 'file_size': key[1], 'buffer_size_kb': key[2], 'sync_mode': key[3],
+            'runs_base': len(base[key]['throughput']), 'runs_cand': len(cand[key]['throughput']),
+            'base_mb_s': tput[0], 'cand_mb_s': tput[1], 'delta_pct': tput[2], 'significant': tput[3],
+            'base_cpu_ns_per_byte': cpu[0] if cpu else math.nan,
+            'cand_cpu_ns_per_byte': cpu[1] if cpu else math.nan,
+            'cpu_delta_pct': cpu[2] if cpu else math.nan,
+            'cpu_significant': cpu[3] if cpu else False,
+            'verdict': verdict,
+        })
+
+    header = (f"{'Mecanismo':<24} {'Tamaño':>6} {'Buf':>7} {'Sync':>6} {'N':>5} "
+              f"{'Base MB/s':>10} {'Cand MB/s':>10} {'Δ%':>7} {'CPU Δ%':>7}  Veredicto")
+    print(header)
+    print('-' * len(header))
+    for r in results:
+        print(f"{r['mechanism']:<24} {r['file_size']:>6} {str(r['buffer_size_kb']) + 'KB':>7} {r['sync_mode']:>6} "
+              f"{str(r['runs_base']) + '/' + str(r['runs_cand']):>5} "
+              f"{r['base_mb_s']:>10.2f} {r['cand_mb_s']:>10.2f} "
+              f"{r['delta_pct']:>+6.1f}{'*' if r['significant'] else ' '} "
+              f"{r['cpu_delta_pct']:>+6.1f}{'*' if r['cpu_significant'] else ' '}  {r['verdict']}")
+    print("(*: diferencia significativa, t de Welch al 95%)")
+
+    only_base = sorted(set(base) - set(cand))
+    only_cand = sorted(set(cand) - set(base))
+    if only_base:
+        print(f"\nFaltan en el candidato {len(only_base)} configuraciones de la base:")
+        for key in only_base:
+            print(f"  {key[0]} {key[1]} {key[2]}KB {key[3]}")
+    if only_cand:
+        print(f"\nSolo en el candidato (no se comparan): {len(only_cand)} configuraciones.")
+
+    if args.csv:
+        with open(args.csv, 'w', newline='') as f:
+            writer = csv.DictWriter(f, fieldnames=list(results[0].keys()) if results else ['mechanism'])
+            writer.writeheader()
+            writer.writerows(results)
+        print(f"Comparación guardada en: {args.csv}")
+
+    regressions = [r for r in results if r['verdict'] == 'REGRESION']
+    insufficient = [r for r in results if r['verdict'] == 'INSUFICIENTE']
+    print(f"\n{len(common)} configuraciones comparadas, {len(regressions)} regresiones "
+          f"(rendimiento -{args.threshold:g}%, CPU +{args.cpu_threshold:g}%), "
+          f"{len(insufficient)} con menos de {args.min_runs} ejecuciones, {len(only_base)} ausentes en el candidato"
+          f"{' (permitido con --allow-missing)' if args.allow_missing and only_base else ''}.")
+    failed = regressions or insufficient or (only_base and not args.allow_missing)
+    sys.exit(1 if failed else 0)
+
+if __name__ == '__main__':
+    main()
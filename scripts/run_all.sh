@@ -6,7 +6,10 @@
 # Este script ejecuta una batería de pruebas para comparar el rendimiento de
 # diferentes mecanismos de E/S en Linux. Automatiza la ejecución de cada
 # prueba bajo varias condiciones (tamaño de archivo, tamaño de buffer, modo sync)
-# y recopila métricas de rendimiento usando 'time' y 'strace'.
+# y recopila métricas de rendimiento usando 'time' y la instrumentación de
+# los propios programas (claves Sys*/Rusage* de app.log, ver
+# src/common/io_trace.h). No se usa strace: su coste por llamada distorsiona
+# justo los casos con búferes pequeños.
 #
 # ¡ADVERTENCIA! La ejecución completa de este script puede tardar mucho tiempo
 # y ejerce una carga significativa en el sistema.
@@ -20,6 +23,54 @@ REPETITIONS=10
 FILE_SIZES_STR=("10M" "100M" "1G")
 BUFFER_SIZES_KB=(4 64 1024) # en Kilobytes
 SYNC_MODES=("nosync" "sync")
+RING_BUFFERS=4 # Búferes del anillo para file_buffered --buffers
+URING_QUEUE_DEPTH=8 # Búferes en vuelo para file_uring
+PARALLEL_THREADS=(2 4 8) # Hilos para file_parallel
+AIO_QUEUE_DEPTHS=(4 16 32) # Bloques en vuelo de file_direct --aio
+IOBENCH_CI_TARGET=5 # iobench repite cada combinación hasta que el IC95 sea <= 5% de la media...
+IOBENCH_MAX_REPETITIONS=30 # ...o hasta este máximo (mínimo: 3 ejecuciones)
+IOBENCH_WARMUP=1 # Ejecuciones sin medir de cada combinación antes del barrido
+SAMPLE_MS=100 # Intervalo de --sample-ms (serie de MB/s) en las pruebas básicas de copia y sockets
+# Reserva y volcado del destino (--prealloc/--fsync), "nombre:opciones" para
+# file_buffered y file_direct (resultados en buffered_<nombre> y direct_<nombre>).
+# Las variantes con --fsync solo se ejecutan en modo sync.
+WRITE_LAYOUT_VARIANTS=(
+    "falloc:--prealloc=fallocate"
+    "keepsize:--prealloc=keep-size"
+    "fdatasync:--fsync=fdatasync"
+    "periodic:--prealloc=fallocate --fsync=periodic:67108864"
+    "sfr:--prealloc=fallocate --fsync=sync_file_range:8388608"
+)
+# Pistas al cache de página de file_buffered, "nombre:opciones" (resultados en buffered_<nombre>)
+CACHE_HINT_VARIANTS=(
+    "fadv_seq:--fadvise sequential"
+    "readahead:--readahead 8388608"
+    "dropbehind:--drop-behind 8388608"
+    "ra_dropbehind:--fadvise sequential --readahead 8388608 --drop-behind 8388608"
+)
+# Variantes de file_mmap, "nombre:opciones" (resultados en mmap_<nombre>)
+MMAP_VARIANTS=(
+    "memcpy:--method memcpy"
+    "write:--method write"
+    "populate:--method memcpy --populate"
+    "seq_dontneed:--method memcpy --sequential --dontneed"
+    "hugepage:--method memcpy --hugepage"
+)
+ZEROCOPY_MODES=("sendfile" "splice" "msg_zerocopy") # Modos --zerocopy de los clientes
+RECV_MODES=("splice" "direct") # Modos --recv de los servidores
+FD_METHODS=("reflink" "copy_file_range" "sendfile") # --fd-method del servidor UNIX con descriptores pasados
+CONCURRENCY_LEVELS=(4 16) # Conexiones simultáneas contra los servidores --epoll
+REUSEPORT_WORKERS=(1 2 4) # Hilos SO_REUSEPORT de tcp_server --workers
+REUSEPORT_CONNECTIONS=16 # Conexiones del cliente en las pruebas --workers
+STRIPE_COUNTS=(2 4 8) # Flujos paralelos de la transferencia TCP repartida
+PINGPONG_TRANSPORTS=("unix" "tcp" "socketpair" "pipe") # Transportes del benchmark de latencia
+PINGPONG_MSG_SIZES=(1 64 1024 16384 65536) # Tamaños de mensaje (bytes) de pingpong_client
+PINGPONG_ITERATIONS=100000 # Idas y vueltas medidas por prueba
+# Estado del cache de la entrada antes de cada prueba:
+#  - drop: vaciar el cache de todo el sistema (drop_caches, requiere sudo)
+#  - cold: cada programa desaloja solo su archivo de entrada (--cold)
+#  - warm: cada programa precarga su archivo de entrada (--warm)
+CACHE_MODE="${CACHE_MODE:-drop}"
 
 # Rutas y Comandos
 BASE_DIR=$(pwd)
@@ -27,6 +78,8 @@ SRC_DIR="$BASE_DIR"
 BIN_DIR="$SRC_DIR/bin"
 TEST_DATA_DIR="$SRC_DIR/test_data"
 RESULTS_DIR="$SRC_DIR/results/raw"
+# Todas las ejecuciones del barrido, un objeto JSON por línea (--json-out)
+RESULTS_JSONL="$RESULTS_DIR/runs.jsonl"
 SCRIPTS_DIR="$SRC_DIR/scripts"
 
 # ¡CRÍTICO! Directorio de prueba en un FS ext4 limpio.
@@ -42,11 +95,26 @@ fi
 TCP_SERVER_IP="127.0.0.1" # Cambiar si el servidor está en otra máquina
 TCP_PORT=12345
 UNIX_SOCKET_PATH="$TEST_MOUNT/test_socket.sock"
+SHM_RING_NAME="/io_experiment_ring" # Segmento POSIX de shm_ring_server
+
+case "$CACHE_MODE" in
+    drop) CACHE_FLAG="" ;;
+    cold) CACHE_FLAG="--cold" ;;
+    warm) CACHE_FLAG="--warm" ;;
+    *)
+        echo "ERROR: CACHE_MODE desconocido '$CACHE_MODE' (drop, cold o warm)."
+        exit 1
+        ;;
+esac
 
 # --- Funciones Auxiliares ---
 
 # Función para limpiar la caché de disco. Requiere configuración de sudo sin contraseña.
 drop_caches() {
+    # Con --cold/--warm cada programa prepara solo su entrada
+    if [ "$CACHE_MODE" != "drop" ]; then
+        return
+    fi
     echo "--- Limpiando cachés de disco ---"
     # sync para asegurar que todo se escriba en disco
     sync
@@ -59,6 +127,17 @@ drop_caches() {
     sleep 1 # Darle un segundo al sistema para que se estabilice
 }
 
+# Opciones --json-out/--tag de la ejecución cuyo directorio es $LOG_DIR
+# (<mecanismo>/<tamaño>/<buf>KB/<sync>/run_<n>). Con "server" se marca como
+# la línea del servidor, que stats_parser.py une a la del cliente.
+report_flags() {
+    local mech size buf sync run
+    IFS=/ read -r mech size buf sync run <<< "${LOG_DIR#"$RESULTS_DIR"/}"
+    echo "--json-out $RESULTS_JSONL --tag mechanism=$mech --tag file_size=$size" \
+         "--tag buffer_size_kb=${buf%KB} --tag sync_mode=$sync --tag run=${run#run_}" \
+         "${1:+--tag side=$1}"
+}
+
 # --- Lógica Principal del Experimento ---
 
 echo "==============================================="
@@ -75,6 +154,10 @@ if [ ! -f "$BIN_DIR/file_buffered" ]; then
     exit 1
 fi
 
+# El archivo JSONL corresponde a un único barrido
+mkdir -p "$RESULTS_DIR"
+: > "$RESULTS_JSONL"
+
 # Bucle principal de repeticiones
 for (( i=1; i<=REPETITIONS; i++ )); do
     echo "********** INICIANDO REPETICIÓN $i/$REPETITIONS **********"
@@ -105,11 +188,55 @@ for (( i=1; i<=REPETITIONS; i++ )); do
                 
                 echo "-> Test: buffered | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: $sync_mode | Rep: $i"
                 drop_caches
-                ( /usr/bin/time -v strace -c -o "$LOG_DIR/strace.log" \
-                    "$BIN_DIR/file_buffered" "$INPUT_FILE" "$OUTPUT_FILE" "$BSIZE_BYTES" $SYNC_FLAG > "$LOG_DIR/app.log" ) \
+                ( /usr/bin/time -v \
+                    "$BIN_DIR/file_buffered" "$INPUT_FILE" "$OUTPUT_FILE" "$BSIZE_BYTES" $SYNC_FLAG $CACHE_FLAG --sample-ms "$SAMPLE_MS" $(report_flags) > "$LOG_DIR/app.log" ) \
                     2> "$LOG_DIR/time.log"
                 rm -f "$OUTPUT_FILE"
 
+                # --- 1b. Prueba: file_buffered con anillo de búferes (lector/escritor) ---
+                LOG_DIR="$RESULTS_DIR/buffered_ring/$size_str/${bsize_kb}KB/$sync_mode/run_$i"
+                mkdir -p "$LOG_DIR"
+                OUTPUT_FILE="$TEST_MOUNT/output.dat"
+
+                echo "-> Test: ring     | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: $sync_mode | Rep: $i"
+                drop_caches
+                ( /usr/bin/time -v \
+                    "$BIN_DIR/file_buffered" "$INPUT_FILE" "$OUTPUT_FILE" "$BSIZE_BYTES" --buffers "$RING_BUFFERS" $SYNC_FLAG $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                    2> "$LOG_DIR/time.log"
+                rm -f "$OUTPUT_FILE"
+
+                # --- 1b2. Prueba: file_buffered con pistas al cache de página ---
+                for variant in "${CACHE_HINT_VARIANTS[@]}"; do
+                    VARIANT_NAME="${variant%%:*}"
+                    read -r -a HINT_ARGS <<< "${variant#*:}"
+                    LOG_DIR="$RESULTS_DIR/buffered_${VARIANT_NAME}/$size_str/${bsize_kb}KB/$sync_mode/run_$i"
+                    mkdir -p "$LOG_DIR"
+                    OUTPUT_FILE="$TEST_MOUNT/output.dat"
+
+                    echo "-> Test: buffered+${VARIANT_NAME} | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: $sync_mode | Rep: $i"
+                    drop_caches
+                    ( /usr/bin/time -v \
+                        "$BIN_DIR/file_buffered" "$INPUT_FILE" "$OUTPUT_FILE" "$BSIZE_BYTES" "${HINT_ARGS[@]}" $SYNC_FLAG $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                        2> "$LOG_DIR/time.log"
+                    rm -f "$OUTPUT_FILE"
+                done
+
+                # --- 1c. Prueba: file_mmap (copia por fallos de página) ---
+                for variant in "${MMAP_VARIANTS[@]}"; do
+                    VARIANT_NAME="${variant%%:*}"
+                    read -r -a MMAP_ARGS <<< "${variant#*:}"
+                    LOG_DIR="$RESULTS_DIR/mmap_${VARIANT_NAME}/$size_str/${bsize_kb}KB/$sync_mode/run_$i"
+                    mkdir -p "$LOG_DIR"
+                    OUTPUT_FILE="$TEST_MOUNT/output.dat"
+
+                    echo "-> Test: mmap+${VARIANT_NAME} | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: $sync_mode | Rep: $i"
+                    drop_caches
+                    ( /usr/bin/time -v \
+                        "$BIN_DIR/file_mmap" "$INPUT_FILE" "$OUTPUT_FILE" "$BSIZE_BYTES" "${MMAP_ARGS[@]}" $SYNC_FLAG $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                        2> "$LOG_DIR/time.log"
+                    rm -f "$OUTPUT_FILE"
+                done
+
                 # --- 2. Prueba: file_direct ---
                 # O_DIRECT requiere que el tamaño del buffer sea múltiplo de 512
                 if (( BSIZE_BYTES % 512 == 0 )); then
@@ -119,10 +246,23 @@ for (( i=1; i<=REPETITIONS; i++ )); do
                     
                     echo "-> Test: direct   | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: $sync_mode | Rep: $i"
                     drop_caches
-                    ( /usr/bin/time -v strace -c -o "$LOG_DIR/strace.log" \
-                        "$BIN_DIR/file_direct" "$INPUT_FILE" "$OUTPUT_FILE" "$BSIZE_BYTES" $SYNC_FLAG > "$LOG_DIR/app.log" ) \
+                    ( /usr/bin/time -v \
+                        "$BIN_DIR/file_direct" "$INPUT_FILE" "$OUTPUT_FILE" "$BSIZE_BYTES" $SYNC_FLAG $CACHE_FLAG --sample-ms "$SAMPLE_MS" $(report_flags) > "$LOG_DIR/app.log" ) \
                         2> "$LOG_DIR/time.log"
                     rm -f "$OUTPUT_FILE"
+
+                    # --- 2b. Prueba: file_direct --aio (varios bloques en vuelo) ---
+                    for qd in "${AIO_QUEUE_DEPTHS[@]}"; do
+                        LOG_DIR="$RESULTS_DIR/direct_aio_qd${qd}/$size_str/${bsize_kb}KB/$sync_mode/run_$i"
+                        mkdir -p "$LOG_DIR"
+
+                        echo "-> Test: direct+aio qd=$qd | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: $sync_mode | Rep: $i"
+                        drop_caches
+                        ( /usr/bin/time -v \
+                            "$BIN_DIR/file_direct" "$INPUT_FILE" "$OUTPUT_FILE" "$BSIZE_BYTES" --aio --qd "$qd" $SYNC_FLAG $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                            2> "$LOG_DIR/time.log"
+                        rm -f "$OUTPUT_FILE"
+                    done
                 fi
 
                 # --- 3. Prueba: file_sendfile (no usa buffer, se ejecuta una vez por sync_mode) ---
@@ -133,11 +273,85 @@ for (( i=1; i<=REPETITIONS; i++ )); do
 
                     echo "-> Test: sendfile | Archivo: $size_str | Buffer: N/A | Sync: $sync_mode | Rep: $i"
                     drop_caches
-                    ( /usr/bin/time -v strace -c -o "$LOG_DIR/strace.log" \
-                        "$BIN_DIR/file_sendfile" "$INPUT_FILE" "$OUTPUT_FILE" $SYNC_FLAG > "$LOG_DIR/app.log" ) \
+                    ( /usr/bin/time -v \
+                        "$BIN_DIR/file_sendfile" "$INPUT_FILE" "$OUTPUT_FILE" $SYNC_FLAG $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                        2> "$LOG_DIR/time.log"
+                    rm -f "$OUTPUT_FILE"
+
+                    # Los otros dos caminos zero-copy del mismo binario
+                    for zc_method in copy_file_range splice; do
+                        LOG_DIR="$RESULTS_DIR/$zc_method/$size_str/0KB/$sync_mode/run_$i"
+                        mkdir -p "$LOG_DIR"
+                        OUTPUT_FILE="$TEST_MOUNT/output.dat"
+
+                        echo "-> Test: $zc_method | Archivo: $size_str | Buffer: N/A | Sync: $sync_mode | Rep: $i"
+                        drop_caches
+                        ( /usr/bin/time -v \
+                            "$BIN_DIR/file_sendfile" "$INPUT_FILE" "$OUTPUT_FILE" --method "$zc_method" $SYNC_FLAG $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                            2> "$LOG_DIR/time.log"
+                        rm -f "$OUTPUT_FILE"
+                    done
+                fi
+
+                # --- 3b. Prueba: file_uring (page cache y O_DIRECT) ---
+                LOG_DIR="$RESULTS_DIR/uring/$size_str/${bsize_kb}KB/$sync_mode/run_$i"
+                mkdir -p "$LOG_DIR"
+                OUTPUT_FILE="$TEST_MOUNT/output.dat"
+
+                echo "-> Test: uring    | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: $sync_mode | Rep: $i"
+                drop_caches
+                ( /usr/bin/time -v \
+                    "$BIN_DIR/file_uring" "$INPUT_FILE" "$OUTPUT_FILE" "$BSIZE_BYTES" --qd "$URING_QUEUE_DEPTH" $SYNC_FLAG $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                    2> "$LOG_DIR/time.log"
+                rm -f "$OUTPUT_FILE"
+
+                if (( BSIZE_BYTES % 4096 == 0 )); then
+                    LOG_DIR="$RESULTS_DIR/uring_direct/$size_str/${bsize_kb}KB/$sync_mode/run_$i"
+                    mkdir -p "$LOG_DIR"
+                    OUTPUT_FILE="$TEST_MOUNT/output.dat"
+
+                    echo "-> Test: uring_d  | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: $sync_mode | Rep: $i"
+                    drop_caches
+                    ( /usr/bin/time -v \
+                        "$BIN_DIR/file_uring" "$INPUT_FILE" "$OUTPUT_FILE" "$BSIZE_BYTES" --qd "$URING_QUEUE_DEPTH" --direct $SYNC_FLAG $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
                         2> "$LOG_DIR/time.log"
                     rm -f "$OUTPUT_FILE"
                 fi
+
+                # --- 3c. Prueba: file_parallel (rangos copiados por N hilos) ---
+                for nthreads in "${PARALLEL_THREADS[@]}"; do
+                    LOG_DIR="$RESULTS_DIR/parallel_${nthreads}t/$size_str/${bsize_kb}KB/$sync_mode/run_$i"
+                    mkdir -p "$LOG_DIR"
+                    OUTPUT_FILE="$TEST_MOUNT/output.dat"
+
+                    echo "-> Test: par(${nthreads}t)  | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: $sync_mode | Rep: $i"
+                    drop_caches
+                    ( /usr/bin/time -v \
+                        "$BIN_DIR/file_parallel" "$INPUT_FILE" "$OUTPUT_FILE" "$BSIZE_BYTES" --threads "$nthreads" $SYNC_FLAG $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                        2> "$LOG_DIR/time.log"
+                    rm -f "$OUTPUT_FILE"
+                done
+
+                # --- 3d. Prueba: reserva y volcado del destino (file_buffered, file_direct) ---
+                for v in "${WRITE_LAYOUT_VARIANTS[@]}"; do
+                    VARIANT_NAME="${v%%:*}"
+                    read -r -a LAYOUT_ARGS <<< "${v#*:}"
+                    if [[ "${v#*:}" == *--fsync* && "$sync_mode" != "sync" ]]; then
+                        continue
+                    fi
+                    for layout_bin in buffered direct; do
+                        LOG_DIR="$RESULTS_DIR/${layout_bin}_${VARIANT_NAME}/$size_str/${bsize_kb}KB/$sync_mode/run_$i"
+                        mkdir -p "$LOG_DIR"
+                        OUTPUT_FILE="$TEST_MOUNT/output.dat"
+
+                        echo "-> Test: ${layout_bin}+${VARIANT_NAME} | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: $sync_mode | Rep: $i"
+                        drop_caches
+                        ( /usr/bin/time -v \
+                            "$BIN_DIR/file_${layout_bin}" "$INPUT_FILE" "$OUTPUT_FILE" "$BSIZE_BYTES" $SYNC_FLAG "${LAYOUT_ARGS[@]}" $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                            2> "$LOG_DIR/time.log"
+                        rm -f "$OUTPUT_FILE"
+                    done
+                done
             done # Fin sync_modes
             
             # --- 4. Prueba: UNIX Sockets (no usa --sync) ---
@@ -148,17 +362,33 @@ for (( i=1; i<=REPETITIONS; i++ )); do
             echo "-> Test: unix     | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: N/A | Rep: $i"
             drop_caches
             # Iniciar servidor en segundo plano
-            ( "$BIN_DIR/unix_socket_server" "$UNIX_SOCKET_PATH" "$OUTPUT_FILE" "$BSIZE_BYTES" > "$LOG_DIR/app_server.log" ) &
+            ( "$BIN_DIR/unix_socket_server" "$UNIX_SOCKET_PATH" "$OUTPUT_FILE" "$BSIZE_BYTES" --sample-ms "$SAMPLE_MS" $(report_flags server) > "$LOG_DIR/app_server.log" ) &
             SERVER_PID=$!
             sleep 1 # Dar tiempo al servidor para que inicie
             # Ejecutar cliente
-            ( /usr/bin/time -v strace -c -o "$LOG_DIR/strace.log" \
-                "$BIN_DIR/unix_socket_client" "$UNIX_SOCKET_PATH" "$INPUT_FILE" "$BSIZE_BYTES" > "$LOG_DIR/app.log" ) \
+            ( /usr/bin/time -v \
+                "$BIN_DIR/unix_socket_client" "$UNIX_SOCKET_PATH" "$INPUT_FILE" "$BSIZE_BYTES" $CACHE_FLAG --sample-ms "$SAMPLE_MS" $(report_flags) > "$LOG_DIR/app.log" ) \
                 2> "$LOG_DIR/time.log"
             # Esperar y matar al servidor
             wait $SERVER_PID || true # 'true' para no fallar si ya terminó
             rm -f "$OUTPUT_FILE"
 
+            # --- 4b. Prueba: anillo en memoria compartida (límite inferior de IPC local) ---
+            LOG_DIR="$RESULTS_DIR/shm_ring/$size_str/${bsize_kb}KB/nosync/run_$i"
+            mkdir -p "$LOG_DIR"
+            OUTPUT_FILE="$TEST_MOUNT/output.dat"
+
+            echo "-> Test: shm_ring | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: N/A | Rep: $i"
+            drop_caches
+            ( "$BIN_DIR/shm_ring_server" "$SHM_RING_NAME" "$OUTPUT_FILE" "$BSIZE_BYTES" $(report_flags server) > "$LOG_DIR/app_server.log" ) &
+            SERVER_PID=$!
+            sleep 1
+            ( /usr/bin/time -v \
+                "$BIN_DIR/shm_ring_client" "$SHM_RING_NAME" "$INPUT_FILE" "$BSIZE_BYTES" $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                2> "$LOG_DIR/time.log"
+            wait $SERVER_PID || true
+            rm -f "$OUTPUT_FILE"
+
             # --- 5. Prueba: TCP Sockets (no usa --sync) ---
             LOG_DIR="$RESULTS_DIR/tcp_socket/$size_str/${bsize_kb}KB/nosync/run_$i"
             mkdir -p "$LOG_DIR"
@@ -167,20 +397,241 @@ for (( i=1; i<=REPETITIONS; i++ )); do
             echo "-> Test: tcp      | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: N/A | Rep: $i"
             drop_caches
             # Iniciar servidor
-            ( "$BIN_DIR/tcp_server" "$TCP_PORT" "$OUTPUT_FILE" "$BSIZE_BYTES" > "$LOG_DIR/app_server.log" ) &
+            ( "$BIN_DIR/tcp_server" "$TCP_PORT" "$OUTPUT_FILE" "$BSIZE_BYTES" --sample-ms "$SAMPLE_MS" $(report_flags server) > "$LOG_DIR/app_server.log" ) &
             SERVER_PID=$!
             sleep 1
             # Ejecutar cliente
-            ( /usr/bin/time -v strace -c -o "$LOG_DIR/strace.log" \
-                "$BIN_DIR/tcp_client" "$TCP_SERVER_IP" "$TCP_PORT" "$INPUT_FILE" "$BSIZE_BYTES" > "$LOG_DIR/app.log" ) \
+            ( /usr/bin/time -v \
+                "$BIN_DIR/tcp_client" "$TCP_SERVER_IP" "$TCP_PORT" "$INPUT_FILE" "$BSIZE_BYTES" $CACHE_FLAG --sample-ms "$SAMPLE_MS" $(report_flags) > "$LOG_DIR/app.log" ) \
                 2> "$LOG_DIR/time.log"
             wait $SERVER_PID || true
             rm -f "$OUTPUT_FILE"
-            
+
+            # --- 6. Prueba: envío zero-copy en los clientes UNIX y TCP ---
+            # MSG_ZEROCOPY solo existe para TCP, por eso se omite en UNIX.
+            for zc_mode in "${ZEROCOPY_MODES[@]}"; do
+                for transport in unix tcp; do
+                    if [ "$transport" == "unix" ] && [ "$zc_mode" == "msg_zerocopy" ]; then
+                        continue
+                    fi
+                    LOG_DIR="$RESULTS_DIR/${transport}_socket_zc_${zc_mode}/$size_str/${bsize_kb}KB/nosync/run_$i"
+                    mkdir -p "$LOG_DIR"
+                    OUTPUT_FILE="$TEST_MOUNT/output.dat"
+
+                    echo "-> Test: ${transport}+${zc_mode} | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: N/A | Rep: $i"
+                    drop_caches
+                    if [ "$transport" == "unix" ]; then
+                        ( "$BIN_DIR/unix_socket_server" "$UNIX_SOCKET_PATH" "$OUTPUT_FILE" "$BSIZE_BYTES" $(report_flags server) > "$LOG_DIR/app_server.log" ) &
+                        SERVER_PID=$!
+                        sleep 1
+                        ( /usr/bin/time -v \
+                            "$BIN_DIR/unix_socket_client" "$UNIX_SOCKET_PATH" "$INPUT_FILE" "$BSIZE_BYTES" --zerocopy="$zc_mode" $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                            2> "$LOG_DIR/time.log"
+                    else
+                        ( "$BIN_DIR/tcp_server" "$TCP_PORT" "$OUTPUT_FILE" "$BSIZE_BYTES" $(report_flags server) > "$LOG_DIR/app_server.log" ) &
+                        SERVER_PID=$!
+                        sleep 1
+                        ( /usr/bin/time -v \
+                            "$BIN_DIR/tcp_client" "$TCP_SERVER_IP" "$TCP_PORT" "$INPUT_FILE" "$BSIZE_BYTES" --zerocopy="$zc_mode" $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                            2> "$LOG_DIR/time.log"
+                    fi
+                    wait $SERVER_PID || true
+                    rm -f "$OUTPUT_FILE"
+                done
+            done
+
+            # --- 7. Prueba: recepción zero-copy / O_DIRECT en los servidores ---
+            for recv_mode in "${RECV_MODES[@]}"; do
+                if [ "$recv_mode" == "direct" ] && (( BSIZE_BYTES % 4096 != 0 )); then
+                    continue
+                fi
+                for transport in unix tcp; do
+                    LOG_DIR="$RESULTS_DIR/${transport}_socket_recv_${recv_mode}/$size_str/${bsize_kb}KB/nosync/run_$i"
+                    mkdir -p "$LOG_DIR"
+                    OUTPUT_FILE="$TEST_MOUNT/output.dat"
+
+                    echo "-> Test: ${transport}<-${recv_mode} | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: N/A | Rep: $i"
+                    drop_caches
+                    if [ "$transport" == "unix" ]; then
+                        ( "$BIN_DIR/unix_socket_server" "$UNIX_SOCKET_PATH" "$OUTPUT_FILE" "$BSIZE_BYTES" --recv="$recv_mode" $(report_flags server) > "$LOG_DIR/app_server.log" ) &
+                        SERVER_PID=$!
+                        sleep 1
+                        ( /usr/bin/time -v \
+                            "$BIN_DIR/unix_socket_client" "$UNIX_SOCKET_PATH" "$INPUT_FILE" "$BSIZE_BYTES" $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                            2> "$LOG_DIR/time.log"
+                    else
+                        ( "$BIN_DIR/tcp_server" "$TCP_PORT" "$OUTPUT_FILE" "$BSIZE_BYTES" --recv="$recv_mode" $(report_flags server) > "$LOG_DIR/app_server.log" ) &
+                        SERVER_PID=$!
+                        sleep 1
+                        ( /usr/bin/time -v \
+                            "$BIN_DIR/tcp_client" "$TCP_SERVER_IP" "$TCP_PORT" "$INPUT_FILE" "$BSIZE_BYTES" $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                            2> "$LOG_DIR/time.log"
+                    fi
+                    wait $SERVER_PID || true
+                    rm -f "$OUTPUT_FILE"
+                done
+            done
+
+            # --- 7b. Prueba: paso del descriptor por SCM_RIGHTS en lugar de los bytes ---
+            for fd_method in "${FD_METHODS[@]}"; do
+                LOG_DIR="$RESULTS_DIR/unix_socket_fdpass_${fd_method}/$size_str/${bsize_kb}KB/nosync/run_$i"
+                mkdir -p "$LOG_DIR"
+                OUTPUT_FILE="$TEST_MOUNT/output.dat"
+
+                echo "-> Test: unix fdpass+${fd_method} | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: N/A | Rep: $i"
+                drop_caches
+                ( "$BIN_DIR/unix_socket_server" "$UNIX_SOCKET_PATH" "$OUTPUT_FILE" "$BSIZE_BYTES" --recv=fd --fd-method "$fd_method" $(report_flags server) > "$LOG_DIR/app_server.log" ) &
+                SERVER_PID=$!
+                sleep 1
+                ( /usr/bin/time -v \
+                    "$BIN_DIR/unix_socket_client" "$UNIX_SOCKET_PATH" "$INPUT_FILE" "$BSIZE_BYTES" --zerocopy=fdpass $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                    2> "$LOG_DIR/time.log"
+                wait $SERVER_PID || true
+                rm -f "$OUTPUT_FILE"
+            done
+
+            # --- 8. Prueba: servidores epoll con varias conexiones simultáneas ---
+            # Cada conexión envía el archivo completo a su propio <salida>.<n>.
+            for conns in "${CONCURRENCY_LEVELS[@]}"; do
+                for transport in unix tcp; do
+                    LOG_DIR="$RESULTS_DIR/${transport}_socket_epoll_${conns}c/$size_str/${bsize_kb}KB/nosync/run_$i"
+                    mkdir -p "$LOG_DIR"
+                    OUTPUT_FILE="$TEST_MOUNT/output.dat"
+
+                    echo "-> Test: ${transport}+epoll x${conns} | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: N/A | Rep: $i"
+                    drop_caches
+                    if [ "$transport" == "unix" ]; then
+                        ( "$BIN_DIR/unix_socket_server" "$UNIX_SOCKET_PATH" "$OUTPUT_FILE" "$BSIZE_BYTES" --epoll --max-conns "$conns" $(report_flags server) > "$LOG_DIR/app_server.log" ) &
+                        SERVER_PID=$!
+                        sleep 1
+                        ( /usr/bin/time -v \
+                            "$BIN_DIR/unix_socket_client" "$UNIX_SOCKET_PATH" "$INPUT_FILE" "$BSIZE_BYTES" --connections "$conns" $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                            2> "$LOG_DIR/time.log"
+                    else
+                        ( "$BIN_DIR/tcp_server" "$TCP_PORT" "$OUTPUT_FILE" "$BSIZE_BYTES" --epoll --max-conns "$conns" $(report_flags server) > "$LOG_DIR/app_server.log" ) &
+                        SERVER_PID=$!
+                        sleep 1
+                        ( /usr/bin/time -v \
+                            "$BIN_DIR/tcp_client" "$TCP_SERVER_IP" "$TCP_PORT" "$INPUT_FILE" "$BSIZE_BYTES" --connections "$conns" $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                            2> "$LOG_DIR/time.log"
+                    fi
+                    wait $SERVER_PID || true
+                    rm -f "$OUTPUT_FILE".*
+                done
+            done
+
+            # --- 9. Prueba: tcp_server con N hilos SO_REUSEPORT fijados a CPUs ---
+            for workers in "${REUSEPORT_WORKERS[@]}"; do
+                LOG_DIR="$RESULTS_DIR/tcp_socket_reuseport_${workers}w/$size_str/${bsize_kb}KB/nosync/run_$i"
+                mkdir -p "$LOG_DIR"
+                OUTPUT_FILE="$TEST_MOUNT/output.dat"
+
+                echo "-> Test: tcp+reuseport x${workers} | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: N/A | Rep: $i"
+                drop_caches
+                ( "$BIN_DIR/tcp_server" "$TCP_PORT" "$OUTPUT_FILE" "$BSIZE_BYTES" --workers "$workers" --max-conns "$REUSEPORT_CONNECTIONS" $(report_flags server) > "$LOG_DIR/app_server.log" ) &
+                SERVER_PID=$!
+                sleep 1
+                ( /usr/bin/time -v \
+                    "$BIN_DIR/tcp_client" "$TCP_SERVER_IP" "$TCP_PORT" "$INPUT_FILE" "$BSIZE_BYTES" --connections "$REUSEPORT_CONNECTIONS" $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                    2> "$LOG_DIR/time.log"
+                wait $SERVER_PID || true
+                rm -f "$OUTPUT_FILE".*
+            done
+
+            # --- 10. Prueba: un archivo repartido en K flujos TCP paralelos ---
+            for stripes in "${STRIPE_COUNTS[@]}"; do
+                LOG_DIR="$RESULTS_DIR/tcp_socket_striped_${stripes}s/$size_str/${bsize_kb}KB/nosync/run_$i"
+                mkdir -p "$LOG_DIR"
+                OUTPUT_FILE="$TEST_MOUNT/output.dat"
+
+                echo "-> Test: tcp striped x${stripes} | Archivo: $size_str | Buffer: ${bsize_kb}KB | Sync: N/A | Rep: $i"
+                drop_caches
+                ( "$BIN_DIR/tcp_server" "$TCP_PORT" "$OUTPUT_FILE" "$BSIZE_BYTES" --stripes "$stripes" $(report_flags server) > "$LOG_DIR/app_server.log" ) &
+                SERVER_PID=$!
+                sleep 1
+                ( /usr/bin/time -v \
+                    "$BIN_DIR/tcp_client" "$TCP_SERVER_IP" "$TCP_PORT" "$INPUT_FILE" "$BSIZE_BYTES" --stripes "$stripes" $CACHE_FLAG $(report_flags) > "$LOG_DIR/app.log" ) \
+                    2> "$LOG_DIR/time.log"
+                wait $SERVER_PID || true
+                rm -f "$OUTPUT_FILE"
+            done
+
         done # Fin buffer_sizes
     done # Fin file_sizes
+
+    # --- 11. Prueba: latencia petición/respuesta con mensajes pequeños ---
+    # No depende del archivo de entrada ni del buffer; el tamaño es el del
+    # mensaje. Sin strace, que añadiría su propio coste a cada llamada.
+    for transport in "${PINGPONG_TRANSPORTS[@]}"; do
+        for msg_size in "${PINGPONG_MSG_SIZES[@]}"; do
+            LOG_DIR="$RESULTS_DIR/pingpong_${transport}/${msg_size}B/0KB/nosync/run_$i"
+            mkdir -p "$LOG_DIR"
+
+            echo "-> Test: pingpong ($transport) | Mensaje: ${msg_size}B | Rep: $i"
+            SERVER_PID=""
+            case "$transport" in
+                unix)
+                    ( "$BIN_DIR/pingpong_server" unix "$UNIX_SOCKET_PATH" $(report_flags server) > "$LOG_DIR/app_server.log" ) &
+                    SERVER_PID=$!
+                    ENDPOINT="$UNIX_SOCKET_PATH"
+                    ;;
+                tcp)
+                    ( "$BIN_DIR/pingpong_server" tcp "$TCP_PORT" $(report_flags server) > "$LOG_DIR/app_server.log" ) &
+                    SERVER_PID=$!
+                    ENDPOINT="$TCP_SERVER_IP:$TCP_PORT"
+                    ;;
+                *)
+                    ENDPOINT="-"
+                    ;;
+            esac
+            if [ -n "$SERVER_PID" ]; then
+                sleep 1
+            fi
+            ( /usr/bin/time -v \
+                "$BIN_DIR/pingpong_client" "$transport" "$ENDPOINT" "$msg_size" --iterations "$PINGPONG_ITERATIONS" $(report_flags) > "$LOG_DIR/app.log" ) \
+                2> "$LOG_DIR/time.log"
+            if [ -n "$SERVER_PID" ]; then
+                wait $SERVER_PID || true
+            fi
+        done
+    done
 done # Fin repetitions
 
+# --- 12. Barrido en un solo proceso: iobench ---
+# iobench recorre motores x búferes x repeticiones sin lanzar un proceso por
+# prueba y guarda cada bloque en $RESULTS_DIR/iobench_<motor>/... (sin
+# time.log). Entre ejecuciones no hay drop_caches: con
+# CACHE_MODE=drop se usa --cold, que desaloja solo el archivo de entrada.
+# En lugar de REPETITIONS fijas, repite cada combinación hasta que el IC95
+# del rendimiento baje de IOBENCH_CI_TARGET% y deja un summary.log por
+# combinación con mediana, IQR, IC y valores atípicos.
+IOBENCH_CACHE_FLAG="$CACHE_FLAG"
+if [ "$CACHE_MODE" == "drop" ]; then
+    IOBENCH_CACHE_FLAG="--cold"
+fi
+IOBENCH_BUFFER_SIZES=$(printf "%sK," "${BUFFER_SIZES_KB[@]}")
+for size_str in "${FILE_SIZES_STR[@]}"; do
+    INPUT_FILE="$TEST_DATA_DIR/file_${size_str}.dat"
+    if [ ! -f "$INPUT_FILE" ]; then
+        continue
+    fi
+    for sync_mode in "${SYNC_MODES[@]}"; do
+        SYNC_FLAG=""
+        if [ "$sync_mode" == "sync" ]; then
+            SYNC_FLAG="--sync"
+        fi
+        OUTPUT_FILE="$TEST_MOUNT/output.dat"
+
+        echo "-> Test: iobench  | Archivo: $size_str | Buffers: ${IOBENCH_BUFFER_SIZES%,} | Sync: $sync_mode | IC95 <= ${IOBENCH_CI_TARGET}%"
+        "$BIN_DIR/iobench" "$INPUT_FILE" "$OUTPUT_FILE" --buffer-sizes "${IOBENCH_BUFFER_SIZES%,}" \
+            --ci-target "$IOBENCH_CI_TARGET" --max-repetitions "$IOBENCH_MAX_REPETITIONS" --warmup "$IOBENCH_WARMUP" \
+            --results-dir "$RESULTS_DIR" --size-label "$size_str" \
+            --json-out "$RESULTS_JSONL" --tag file_size="$size_str" --tag sync_mode="$sync_mode" \
+            $SYNC_FLAG $IOBENCH_CACHE_FLAG > /dev/null
+        rm -f "$OUTPUT_FILE"
+    done
+done
+
 echo "==============================================="
 echo "       EXPERIMENTO COMPLETADO CON ÉXITO        "
 echo "==============================================="
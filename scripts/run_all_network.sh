@@ -28,16 +28,51 @@ DEFAULT_SERVER_IP="192.168.1.100" # Cambiar por la IP real del servidor
 REPETITIONS=10
 FILE_SIZES_STR=("10M" "100M" "1G")
 BUFFER_SIZES_KB=(4 64 1024)
+# Perfiles de ajuste TCP: "nombre:opciones". Las opciones se pasan igual al
+# servidor y al cliente; "default" deja los valores del kernel. Los resultados
+# de cada perfil van a results/raw/tcp_socket_<nombre> (tcp_socket si es default).
+TUNING_PROFILES=(
+    "default:"
+    "nodelay:--nodelay"
+    "bigbuf:--sndbuf 4194304 --rcvbuf 4194304"
+    "lowat:--notsent-lowat 131072"
+    "bbr:--cc bbr"
+)
+
+# Estado del cache de la entrada del cliente: drop (drop_caches), cold o warm
+CACHE_MODE="${CACHE_MODE:-drop}"
+case "$CACHE_MODE" in
+    drop) CACHE_FLAG="" ;;
+    cold) CACHE_FLAG="--cold" ;;
+    warm) CACHE_FLAG="--warm" ;;
+    *)
+        echo "ERROR: CACHE_MODE desconocido '$CACHE_MODE' (drop, cold o warm)."
+        exit 1
+        ;;
+esac
 
 # --- Funciones ---
 
 drop_caches() {
+    if [ "$CACHE_MODE" != "drop" ]; then
+        return
+    fi
     echo "--- Limpiando cachés de disco ---"
     sync
     echo 3 | sudo tee /proc/sys/vm/drop_caches > /dev/null
     sleep 1
 }
 
+# Opciones --json-out/--tag de la ejecución cuyo directorio es $LOG_DIR. Cada
+# máquina escribe su propio archivo (runs_server.jsonl, runs_client.jsonl);
+# stats_parser_network.py lee todos los runs*.jsonl de results/raw.
+report_flags() {
+    local side=$1 mech size buf sync run
+    IFS=/ read -r mech size buf sync run <<< "${LOG_DIR#"$RESULTS_DIR"/}"
+    echo "--json-out $RESULTS_DIR/runs_${side}.jsonl --tag side=$side --tag mechanism=$mech" \
+         "--tag file_size=$size --tag buffer_size_kb=${buf%KB} --tag sync_mode=$sync --tag run=${run#run_}"
+}
+
 run_server_tests() {
     echo "=== EJECUTANDO COMO SERVIDOR ==="
     echo "Esperando conexiones en puerto $TCP_PORT..."
@@ -48,58 +83,67 @@ run_server_tests() {
         echo "********** REPETICIÓN $i/$REPETITIONS **********"
         
         for size_str in "${FILE_SIZES_STR[@]}"; do
-            for bsize_kb in "${BUFFER_SIZES_KB[@]}"; do
-                BSIZE_BYTES=$((bsize_kb * 1024))
-                
-                LOG_DIR="$RESULTS_DIR/tcp_socket/$size_str/${bsize_kb}KB/nosync/run_$i"
-                mkdir -p "$LOG_DIR"
-                OUTPUT_FILE="$TEST_MOUNT/output.dat"
-                
-                echo "-> Servidor TCP | Archivo: $size_str | Buffer: ${bsize_kb}KB | Rep: $i"
-                drop_caches
-                
-                # Limpiar cualquier proceso anterior que pueda estar usando el puerto
-                pkill -f "tcp_server.*$TCP_PORT" 2>/dev/null || true
-                sleep 1
-                
-                # Ejecutar servidor y capturar logs
-                echo "Iniciando servidor TCP en puerto $TCP_PORT..."
-                ( nohup /usr/bin/time -v strace -c -o "$LOG_DIR/strace_server.log" \
-                    "$BIN_DIR/tcp_server" "$TCP_PORT" "$OUTPUT_FILE" "$BSIZE_BYTES" > "$LOG_DIR/app_server.log" ) \
-                    2> "$LOG_DIR/time_server.log" &
-                SERVER_PID=$!
-                
-                echo "Servidor iniciado con PID: $SERVER_PID"
-                
-                # Verificar que el proceso realmente se inició
-                if ! kill -0 $SERVER_PID 2>/dev/null; then
-                    echo "ERROR: El servidor no se inició correctamente"
-                    echo "Logs del servidor:"
-                    cat "$LOG_DIR/app_server.log" 2>/dev/null || echo "No hay logs disponibles"
-                    continue
+            for profile in "${TUNING_PROFILES[@]}"; do
+                PROFILE_NAME="${profile%%:*}"
+                read -r -a TUNING_ARGS <<< "${profile#*:}"
+                MECH_DIR="tcp_socket"
+                if [ "$PROFILE_NAME" != "default" ]; then
+                    MECH_DIR="tcp_socket_$PROFILE_NAME"
                 fi
+
+                for bsize_kb in "${BUFFER_SIZES_KB[@]}"; do
+                    BSIZE_BYTES=$((bsize_kb * 1024))
                 
-                echo "Esperando conexión del cliente..."
-                echo "El servidor está ejecutándose en segundo plano. Puedes ejecutar el cliente ahora."
+                    LOG_DIR="$RESULTS_DIR/$MECH_DIR/$size_str/${bsize_kb}KB/nosync/run_$i"
+                    mkdir -p "$LOG_DIR"
+                    OUTPUT_FILE="$TEST_MOUNT/output.dat"
                 
-                # Esperar a que el servidor termine (cuando el cliente se desconecte)
-                wait $SERVER_PID
-                SERVER_EXIT_CODE=$?
+                    echo "-> Servidor TCP | Archivo: $size_str | Buffer: ${bsize_kb}KB | Perfil: $PROFILE_NAME | Rep: $i"
+                    drop_caches
                 
-                if [ $SERVER_EXIT_CODE -eq 0 ]; then
-                    echo "Transferencia completada exitosamente."
-                else
-                    echo "ERROR: El servidor terminó con código de salida $SERVER_EXIT_CODE"
-                    echo "Logs del servidor:"
-                    cat "$LOG_DIR/app_server.log" 2>/dev/null || echo "No hay logs disponibles"
-                fi
+                    # Limpiar cualquier proceso anterior que pueda estar usando el puerto
+                    pkill -f "tcp_server.*$TCP_PORT" 2>/dev/null || true
+                    sleep 1
+                
+                    # Ejecutar servidor y capturar logs
+                    echo "Iniciando servidor TCP en puerto $TCP_PORT..."
+                    ( nohup /usr/bin/time -v \
+                        "$BIN_DIR/tcp_server" "$TCP_PORT" "$OUTPUT_FILE" "$BSIZE_BYTES" "${TUNING_ARGS[@]}" $(report_flags server) > "$LOG_DIR/app_server.log" ) \
+                        2> "$LOG_DIR/time_server.log" &
+                    SERVER_PID=$!
                 
-                echo "Limpiando archivo de salida..."
-                rm -f "$OUTPUT_FILE"
-                echo "---"
+                    echo "Servidor iniciado con PID: $SERVER_PID"
                 
-                # Pequeña pausa entre pruebas para evitar problemas de puerto en uso
-                sleep 3
+                    # Verificar que el proceso realmente se inició
+                    if ! kill -0 $SERVER_PID 2>/dev/null; then
+                        echo "ERROR: El servidor no se inició correctamente"
+                        echo "Logs del servidor:"
+                        cat "$LOG_DIR/app_server.log" 2>/dev/null || echo "No hay logs disponibles"
+                        continue
+                    fi
+                
+                    echo "Esperando conexión del cliente..."
+                    echo "El servidor está ejecutándose en segundo plano. Puedes ejecutar el cliente ahora."
+                
+                    # Esperar a que el servidor termine (cuando el cliente se desconecte)
+                    wait $SERVER_PID
+                    SERVER_EXIT_CODE=$?
+                
+                    if [ $SERVER_EXIT_CODE -eq 0 ]; then
+                        echo "Transferencia completada exitosamente."
+                    else
+                        echo "ERROR: El servidor terminó con código de salida $SERVER_EXIT_CODE"
+                        echo "Logs del servidor:"
+                        cat "$LOG_DIR/app_server.log" 2>/dev/null || echo "No hay logs disponibles"
+                    fi
+                
+                    echo "Limpiando archivo de salida..."
+                    rm -f "$OUTPUT_FILE"
+                    echo "---"
+                
+                    # Pequeña pausa entre pruebas para evitar problemas de puerto en uso
+                    sleep 3
+                done
             done
         done
     done
@@ -124,32 +168,41 @@ run_client_tests() {
                 continue
             fi
             
-            for bsize_kb in "${BUFFER_SIZES_KB[@]}"; do
-                BSIZE_BYTES=$((bsize_kb * 1024))
-                
-                LOG_DIR="$RESULTS_DIR/tcp_socket/$size_str/${bsize_kb}KB/nosync/run_$i"
-                mkdir -p "$LOG_DIR"
-                
-                echo "-> Cliente TCP | Archivo: $size_str | Buffer: ${bsize_kb}KB | Rep: $i"
-                drop_caches
-                
-                echo "Conectando al servidor $SERVER_IP:$TCP_PORT..."
-                # Ejecutar cliente
-                ( /usr/bin/time -v strace -c -o "$LOG_DIR/strace_client.log" \
-                    "$BIN_DIR/tcp_client" "$SERVER_IP" "$TCP_PORT" "$INPUT_FILE" "$BSIZE_BYTES" > "$LOG_DIR/app_client.log" ) \
-                    2> "$LOG_DIR/time_client.log"
-                CLIENT_EXIT_CODE=$?
-                
-                if [ $CLIENT_EXIT_CODE -eq 0 ]; then
-                    echo "Transferencia completada exitosamente."
-                else
-                    echo "ERROR: El cliente terminó con código de salida $CLIENT_EXIT_CODE"
+            for profile in "${TUNING_PROFILES[@]}"; do
+                PROFILE_NAME="${profile%%:*}"
+                read -r -a TUNING_ARGS <<< "${profile#*:}"
+                MECH_DIR="tcp_socket"
+                if [ "$PROFILE_NAME" != "default" ]; then
+                    MECH_DIR="tcp_socket_$PROFILE_NAME"
                 fi
+
+                for bsize_kb in "${BUFFER_SIZES_KB[@]}"; do
+                    BSIZE_BYTES=$((bsize_kb * 1024))
+                
+                    LOG_DIR="$RESULTS_DIR/$MECH_DIR/$size_str/${bsize_kb}KB/nosync/run_$i"
+                    mkdir -p "$LOG_DIR"
+                
+                    echo "-> Cliente TCP | Archivo: $size_str | Buffer: ${bsize_kb}KB | Perfil: $PROFILE_NAME | Rep: $i"
+                    drop_caches
+                
+                    echo "Conectando al servidor $SERVER_IP:$TCP_PORT..."
+                    # Ejecutar cliente
+                    ( /usr/bin/time -v \
+                        "$BIN_DIR/tcp_client" "$SERVER_IP" "$TCP_PORT" "$INPUT_FILE" "$BSIZE_BYTES" "${TUNING_ARGS[@]}" $CACHE_FLAG $(report_flags client) > "$LOG_DIR/app_client.log" ) \
+                        2> "$LOG_DIR/time_client.log"
+                    CLIENT_EXIT_CODE=$?
+                
+                    if [ $CLIENT_EXIT_CODE -eq 0 ]; then
+                        echo "Transferencia completada exitosamente."
+                    else
+                        echo "ERROR: El cliente terminó con código de salida $CLIENT_EXIT_CODE"
+                    fi
                 
-                echo "---"
+                    echo "---"
                 
-                # Pequeña pausa entre pruebas
-                sleep 1
+                    # Pequeña pausa entre pruebas
+                    sleep 1
+                done
             done
         done
     done
@@ -185,8 +238,11 @@ if [ ! -d "$TEST_MOUNT" ] || [ ! -w "$TEST_MOUNT" ]; then
     exit 1
 fi
 
+# Cada invocación es un barrido nuevo de esta máquina
+mkdir -p "$RESULTS_DIR"
 case $MODE in
     "server")
+        : > "$RESULTS_DIR/runs_server.jsonl"
         run_server_tests
         ;;
     "client")
@@ -195,6 +251,7 @@ case $MODE in
             echo "Uso: $0 client [IP_DEL_PC1]"
             exit 1
         fi
+        : > "$RESULTS_DIR/runs_client.jsonl"
         run_client_tests "$SERVER_IP"
         ;;
     *)
@@ -28,6 +28,16 @@ DEFAULT_SERVER_IP="192.168.1.100"
 REPETITIONS=10
 FILE_SIZES_STR=("10M" "100M" "1G")
 BUFFER_SIZES_KB=(4 64 1024)
+# Perfiles de ajuste TCP: "nombre:opciones". Las opciones se pasan igual al
+# servidor y al cliente; "default" deja los valores del kernel. Los resultados
+# de cada perfil van a results/raw/tcp_socket_<nombre> (tcp_socket si es default).
+TUNING_PROFILES=(
+    "default:"
+    "nodelay:--nodelay"
+    "bigbuf:--sndbuf 4194304 --rcvbuf 4194304"
+    "lowat:--notsent-lowat 131072"
+    "bbr:--cc bbr"
+)
 
 # --- Funciones ---
 
@@ -48,63 +58,72 @@ run_server_tests() {
         echo "********** REPETICIÓN $i/$REPETITIONS **********"
         
         for size_str in "${FILE_SIZES_STR[@]}"; do
-            for bsize_kb in "${BUFFER_SIZES_KB[@]}"; do
-                BSIZE_BYTES=$((bsize_kb * 1024))
-                
-                LOG_DIR="$RESULTS_DIR/tcp_socket/$size_str/${bsize_kb}KB/nosync/run_$i"
-                mkdir -p "$LOG_DIR"
-                OUTPUT_FILE="$TEST_MOUNT/output.dat"
-                
-                echo "-> Servidor TCP | Archivo: $size_str | Buffer: ${bsize_kb}KB | Rep: $i"
-                drop_caches
-                
-                # Limpiar procesos anteriores
-                pkill -f "tcp_server" 2>/dev/null || true
-                sleep 3
-                
-                echo "Iniciando servidor TCP en puerto $TCP_PORT..."
-                echo "Ejecutando: $BIN_DIR/tcp_server $TCP_PORT $OUTPUT_FILE $BSIZE_BYTES"
-                
-                # Ejecutar servidor directamente (sin time/strace para simplificar)
-                "$BIN_DIR/tcp_server" "$TCP_PORT" "$OUTPUT_FILE" "$BSIZE_BYTES" > "$LOG_DIR/app_server.log" 2>&1 &
-                SERVER_PID=$!
-                
-                echo "Servidor iniciado con PID: $SERVER_PID"
-                
-                # Verificar que el proceso se inició y esperar más tiempo
-                sleep 3
-                if ! kill -0 $SERVER_PID 2>/dev/null; then
-                    echo "ERROR: El servidor no se inició correctamente"
-                    echo "Logs del servidor:"
-                    cat "$LOG_DIR/app_server.log" 2>/dev/null || echo "No hay logs disponibles"
-                    echo "Continuando con la siguiente prueba..."
-                    continue
+            for profile in "${TUNING_PROFILES[@]}"; do
+                PROFILE_NAME="${profile%%:*}"
+                read -r -a TUNING_ARGS <<< "${profile#*:}"
+                MECH_DIR="tcp_socket"
+                if [ "$PROFILE_NAME" != "default" ]; then
+                    MECH_DIR="tcp_socket_$PROFILE_NAME"
                 fi
-                
-                echo "Servidor está ejecutándose correctamente"
-                echo "Esperando conexión del cliente..."
-                echo "El servidor está ejecutándose. Puedes ejecutar el cliente ahora."
-                echo "Para verificar que el servidor está vivo: ps aux | grep tcp_server"
-                
-                # Esperar a que el servidor termine (cuando el cliente se desconecte)
-                # Sin timeout para que realmente espere la conexión
-                wait $SERVER_PID 2>/dev/null || true
-                SERVER_EXIT_CODE=$?
-                
-                if [ $SERVER_EXIT_CODE -eq 0 ]; then
-                    echo "Transferencia completada exitosamente."
-                else
-                    echo "ERROR: El servidor terminó con código de salida $SERVER_EXIT_CODE"
-                    echo "Logs del servidor:"
-                    cat "$LOG_DIR/app_server.log" 2>/dev/null || echo "No hay logs disponibles"
-                fi
-                
-                echo "Limpiando archivo de salida..."
-                rm -f "$OUTPUT_FILE"
-                echo "---"
-                
-                # Pausa entre pruebas
-                sleep 3
+
+                for bsize_kb in "${BUFFER_SIZES_KB[@]}"; do
+                    BSIZE_BYTES=$((bsize_kb * 1024))
+                
+                    LOG_DIR="$RESULTS_DIR/$MECH_DIR/$size_str/${bsize_kb}KB/nosync/run_$i"
+                    mkdir -p "$LOG_DIR"
+                    OUTPUT_FILE="$TEST_MOUNT/output.dat"
+                
+                    echo "-> Servidor TCP | Archivo: $size_str | Buffer: ${bsize_kb}KB | Perfil: $PROFILE_NAME | Rep: $i"
+                    drop_caches
+                
+                    # Limpiar procesos anteriores
+                    pkill -f "tcp_server" 2>/dev/null || true
+                    sleep 3
+                
+                    echo "Iniciando servidor TCP en puerto $TCP_PORT..."
+                    echo "Ejecutando: $BIN_DIR/tcp_server $TCP_PORT $OUTPUT_FILE $BSIZE_BYTES ${TUNING_ARGS[*]}"
+                
+                    # Ejecutar servidor directamente (sin time/strace para simplificar)
+                    "$BIN_DIR/tcp_server" "$TCP_PORT" "$OUTPUT_FILE" "$BSIZE_BYTES" "${TUNING_ARGS[@]}" > "$LOG_DIR/app_server.log" 2>&1 &
+                    SERVER_PID=$!
+                
+                    echo "Servidor iniciado con PID: $SERVER_PID"
+                
+                    # Verificar que el proceso se inició y esperar más tiempo
+                    sleep 3
+                    if ! kill -0 $SERVER_PID 2>/dev/null; then
+                        echo "ERROR: El servidor no se inició correctamente"
+                        echo "Logs del servidor:"
+                        cat "$LOG_DIR/app_server.log" 2>/dev/null || echo "No hay logs disponibles"
+                        echo "Continuando con la siguiente prueba..."
+                        continue
+                    fi
+                
+                    echo "Servidor está ejecutándose correctamente"
+                    echo "Esperando conexión del cliente..."
+                    echo "El servidor está ejecutándose. Puedes ejecutar el cliente ahora."
+                    echo "Para verificar que el servidor está vivo: ps aux | grep tcp_server"
+                
+                    # Esperar a que el servidor termine (cuando el cliente se desconecte)
+                    # Sin timeout para que realmente espere la conexión
+                    wait $SERVER_PID 2>/dev/null || true
+                    SERVER_EXIT_CODE=$?
+                
+                    if [ $SERVER_EXIT_CODE -eq 0 ]; then
+                        echo "Transferencia completada exitosamente."
+                    else
+                        echo "ERROR: El servidor terminó con código de salida $SERVER_EXIT_CODE"
+                        echo "Logs del servidor:"
+                        cat "$LOG_DIR/app_server.log" 2>/dev/null || echo "No hay logs disponibles"
+                    fi
+                
+                    echo "Limpiando archivo de salida..."
+                    rm -f "$OUTPUT_FILE"
+                    echo "---"
+                
+                    # Pausa entre pruebas
+                    sleep 3
+                done
             done
         done
     done
@@ -129,37 +148,46 @@ run_client_tests() {
                 continue
             fi
             
-            for bsize_kb in "${BUFFER_SIZES_KB[@]}"; do
-                BSIZE_BYTES=$((bsize_kb * 1024))
+            for profile in "${TUNING_PROFILES[@]}"; do
+                PROFILE_NAME="${profile%%:*}"
+                read -r -a TUNING_ARGS <<< "${profile#*:}"
+                MECH_DIR="tcp_socket"
+                if [ "$PROFILE_NAME" != "default" ]; then
+                    MECH_DIR="tcp_socket_$PROFILE_NAME"
+                fi
+
+                for bsize_kb in "${BUFFER_SIZES_KB[@]}"; do
+                    BSIZE_BYTES=$((bsize_kb * 1024))
                 
-                LOG_DIR="$RESULTS_DIR/tcp_socket/$size_str/${bsize_kb}KB/nosync/run_$i"
-                mkdir -p "$LOG_DIR"
+                    LOG_DIR="$RESULTS_DIR/$MECH_DIR/$size_str/${bsize_kb}KB/nosync/run_$i"
+                    mkdir -p "$LOG_DIR"
                 
-                echo "-> Cliente TCP | Archivo: $size_str | Buffer: ${bsize_kb}KB | Rep: $i"
-                drop_caches
+                    echo "-> Cliente TCP | Archivo: $size_str | Buffer: ${bsize_kb}KB | Perfil: $PROFILE_NAME | Rep: $i"
+                    drop_caches
                 
-                echo "Esperando 5 segundos para que el servidor esté listo..."
-                sleep 5
+                    echo "Esperando 5 segundos para que el servidor esté listo..."
+                    sleep 5
                 
-                echo "Conectando al servidor $SERVER_IP:$TCP_PORT..."
-                echo "Ejecutando: $BIN_DIR/tcp_client $SERVER_IP $TCP_PORT $INPUT_FILE $BSIZE_BYTES"
+                    echo "Conectando al servidor $SERVER_IP:$TCP_PORT..."
+                    echo "Ejecutando: $BIN_DIR/tcp_client $SERVER_IP $TCP_PORT $INPUT_FILE $BSIZE_BYTES"
                 
-                # Ejecutar cliente directamente sin timeout
-                "$BIN_DIR/tcp_client" "$SERVER_IP" "$TCP_PORT" "$INPUT_FILE" "$BSIZE_BYTES" > "$LOG_DIR/app_client.log" 2>&1
-                CLIENT_EXIT_CODE=$?
+                    # Ejecutar cliente directamente sin timeout
+                    "$BIN_DIR/tcp_client" "$SERVER_IP" "$TCP_PORT" "$INPUT_FILE" "$BSIZE_BYTES" "${TUNING_ARGS[@]}" > "$LOG_DIR/app_client.log" 2>&1
+                    CLIENT_EXIT_CODE=$?
                 
-                if [ $CLIENT_EXIT_CODE -eq 0 ]; then
-                    echo "Transferencia completada exitosamente."
-                else
-                    echo "ERROR: El cliente terminó con código de salida $CLIENT_EXIT_CODE"
-                    echo "Logs del cliente:"
-                    cat "$LOG_DIR/app_client.log" 2>/dev/null || echo "No hay logs disponibles"
-                fi
+                    if [ $CLIENT_EXIT_CODE -eq 0 ]; then
+                        echo "Transferencia completada exitosamente."
+                    else
+                        echo "ERROR: El cliente terminó con código de salida $CLIENT_EXIT_CODE"
+                        echo "Logs del cliente:"
+                        cat "$LOG_DIR/app_client.log" 2>/dev/null || echo "No hay logs disponibles"
+                    fi
                 
-                echo "---"
+                    echo "---"
                 
-                # Pausa entre pruebas
-                sleep 2
+                    # Pausa entre pruebas
+                    sleep 2
+                done
             done
         done
     done
@@ -8,10 +8,16 @@ y genera un resumen en CSV junto con gráficos comparativos.
 
 Este script es el paso final del experimento, transformando los logs en
 datos estructurados y visualizaciones para el análisis de rendimiento.
+
+Si results/raw contiene runs*.jsonl (los programas con --json-out, que
+run_all.sh usa por defecto) se lee solo ese archivo, en una pasada. Si no,
+se recorre el árbol de directorios y se analizan los logs de cada ejecución.
 """
 
 import os
 import re
+import glob
+import json
 import pandas as pd
 import numpy as np
 import matplotlib.pyplot as plt
@@ -25,6 +31,12 @@ FINAL_RESULTS_DIR = os.path.join(BASE_DIR, "results")
 CHARTS_DIR = os.path.join(FINAL_RESULTS_DIR, "charts")
 SUMMARY_CSV_PATH = os.path.join(FINAL_RESULTS_DIR, "summary.csv")
 
+# Orden de los mecanismos en los gráficos. Los mecanismos que no aparezcan
+# aquí (p. ej. 'parallel_4t') se añaden al final en orden alfabético.
+MECHANISM_ORDER = ['buffered', 'buffered_ring', 'mmap_memcpy', 'mmap_write', 'direct', 'direct_aio_qd4', 'direct_aio_qd16', 'direct_aio_qd32', 'sendfile', 'copy_file_range', 'splice', 'uring', 'uring_direct', 'shm_ring', 'unix_socket', 'tcp_socket',
+                   'unix_socket_epoll_4c', 'tcp_socket_epoll_4c', 'unix_socket_epoll_16c', 'tcp_socket_epoll_16c',
+                   'iobench_buffered', 'iobench_direct', 'iobench_mmap', 'iobench_sendfile', 'iobench_copy_file_range']
+
 # Asegurarse de que el directorio de gráficos exista
 os.makedirs(CHARTS_DIR, exist_ok=True)
 
@@ -62,26 +74,18 @@ def parse_time_log(file_path):
         pass
     return metrics
 
-def parse_strace_log(file_path):
-    """Parsea el output de strace -c."""
+def parse_syscalls(app_metrics):
+    """Llamadas al sistema contadas por los propios programas (claves Sys<Llamada>Calls).
+
+    Se devuelven como columnas syscall_<llamada> (SysCopyFileRangeCalls ->
+    syscall_copy_file_range), los mismos nombres que usaba strace -c.
+    """
     syscalls = {}
-    try:
-        with open(file_path, 'r') as f:
-            lines = f.readlines()
-            # Buscar la línea de cabecera para empezar a parsear desde ahí
-            header_found = False
-            for line in lines:
-                if 'calls' in line and 'syscall' in line:
-                    header_found = True
-                    continue
-                if header_found and '---' not in line and line.strip():
-                    parts = line.split()
-                    if len(parts) >= 5:
-                        syscall_name = parts[-1]
-                        calls = int(parts[-2])
-                        syscalls[f'syscall_{syscall_name}'] = calls
-    except (IOError, IndexError):
-        pass
+    for key, value in app_metrics.items():
+        match = re.fullmatch(r'Sys(\w+)Calls', key)
+        if match:
+            name = re.sub(r'(?<!^)(?=[A-Z])', '_', match.group(1)).lower()
+            syscalls[f'syscall_{name}'] = int(value)
     return syscalls
 
 def parse_app_log(file_path):
@@ -107,25 +111,30 @@ def get_file_size_bytes(size_str):
     unit = size_str[-1].upper()
     return num * size_map.get(unit, 1)
 
+# Valores críticos de la t de Student (dos colas, 95%) para 1..30 grados de libertad
+T_CRITICAL_95 = [12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042]
 
-# --- Proceso Principal ---
+def t_critical_95(n):
+    """Valor crítico para un IC del 95% con n ejecuciones (igual que iobench)."""
+    if n < 2:
+        return np.nan
+    df = n - 1
+    return T_CRITICAL_95[df - 1] if df <= 30 else 1.96 + 2.4 / df
 
-def main():
-    """Función principal que orquesta el parsing, análisis y generación de output."""
-    print("Iniciando análisis de resultados...")
-    
-    all_data = []
 
-    if not os.path.exists(RAW_RESULTS_DIR):
-        print(f"ERROR: El directorio de resultados crudos '{RAW_RESULTS_DIR}' no existe.")
-        print("Asegúrate de haber ejecutado 'scripts/run_all.sh' primero.")
-        sys.exit(1)
+# --- Carga de las ejecuciones ---
 
-    # Recorrer el árbol de directorios de resultados
-    for root, _, files in os.walk(RAW_RESULTS_DIR):
-        if 'time.log' in files:
+def load_log_tree(raw_dir):
+    """Recorre <mecanismo>/<tamaño>/<buf>KB/<sync>/run_<n> y analiza los logs de cada ejecución."""
+    all_data = []
+    # Recorrer el árbol de directorios de resultados. Las ejecuciones de
+    # iobench solo dejan app.log (no hay /usr/bin/time por prueba).
+    for root, _, files in os.walk(raw_dir):
+        if 'time.log' in files or 'app.log' in files:
             # Extraer parámetros desde la ruta
-            path_parts = root.replace(RAW_RESULTS_DIR, '').strip(os.sep).split(os.sep)
+            path_parts = root.replace(raw_dir, '').strip(os.sep).split(os.sep)
             if len(path_parts) != 5: continue
             
             mechanism, file_size_str, buffer_size_str, sync_mode, run_id = path_parts
@@ -140,10 +149,74 @@ def main():
             
             # Parsear todos los logs para esta ejecución
             run_data.update(parse_time_log(os.path.join(root, 'time.log')))
-            run_data.update(parse_strace_log(os.path.join(root, 'strace.log')))
-            run_data.update(parse_app_log(os.path.join(root, 'app.log')))
+            app_metrics = parse_app_log(os.path.join(root, 'app.log'))
+            run_data.update(app_metrics)
+            run_data.update(parse_syscalls(app_metrics))
+            # Métricas del servidor en las pruebas de sockets, con prefijo 'Server'
+            server_metrics = parse_app_log(os.path.join(root, 'app_server.log'))
+            run_data.update({f'Server{k}': v for k, v in server_metrics.items()})
+            # Sin time.log, el tiempo de CPU es el que mide el propio programa
+            if 'time_user_s' not in run_data and 'UserTime' in run_data:
+                run_data['time_user_s'] = float(run_data['UserTime'])
+                run_data['time_system_s'] = float(run_data['SysTime'])
             
             all_data.append(run_data)
+    return all_data
+
+
+def load_jsonl(raw_dir):
+    """Lee las ejecuciones de los runs*.jsonl (una por línea) con las mismas columnas que load_log_tree()."""
+    rows = []
+    for path in sorted(glob.glob(os.path.join(raw_dir, 'runs*.jsonl'))):
+        with open(path, 'r') as f:
+            rows.extend(json.loads(line) for line in f if line.strip())
+
+    all_data = []
+    servers = {}
+    for row in rows:
+        # iobench hace su propio barrido: los parámetros salen de cada bloque
+        if row.get('Binary') == 'iobench':
+            if 'Repetition' not in row:
+                continue  # Bloque de resumen de la combinación, no una ejecución
+            row.setdefault('mechanism', f"iobench_{row['Engine']}")
+            row.setdefault('buffer_size_kb', int(row['BufferSize']) // 1024)
+            row.setdefault('run', row['Repetition'])
+        if not all(k in row for k in ('mechanism', 'file_size', 'buffer_size_kb', 'sync_mode', 'run')):
+            continue
+        row['file_size'] = str(row['file_size'])
+        key = (row['mechanism'], row['file_size'], row['buffer_size_kb'], row['sync_mode'], row['run'])
+        if row.get('side') == 'server':
+            servers[key] = row
+            continue
+        row.update(parse_syscalls(row))
+        # No hay time.log: el tiempo de CPU es el que mide el propio programa
+        user_time = row.get('UserTime', row.get('RusageUserTime'))
+        sys_time = row.get('SysTime', row.get('RusageSysTime'))
+        if user_time is not None and sys_time is not None:
+            row['time_user_s'] = float(user_time)
+            row['time_system_s'] = float(sys_time)
+        row['_key'] = key
+        all_data.append(row)
+
+    # Métricas del servidor en las pruebas de sockets, con prefijo 'Server'
+    for row in all_data:
+        server = servers.get(row.pop('_key'), {})
+        row.update({f'Server{k}': v for k, v in server.items() if k[0].isupper()})
+    return all_data
+
+
+# --- Proceso Principal ---
+
+def main():
+    """Función principal que orquesta el parsing, análisis y generación de output."""
+    print("Iniciando análisis de resultados...")
+    
+    if not os.path.exists(RAW_RESULTS_DIR):
+        print(f"ERROR: El directorio de resultados crudos '{RAW_RESULTS_DIR}' no existe.")
+        print("Asegúrate de haber ejecutado 'scripts/run_all.sh' primero.")
+        sys.exit(1)
+
+    all_data = load_jsonl(RAW_RESULTS_DIR) or load_log_tree(RAW_RESULTS_DIR)
 
     if not all_data:
         print("No se encontraron datos de logs para analizar.")
@@ -157,31 +230,112 @@ def main():
     
     # El tiempo medido por nuestra app es más preciso que el wall-clock de 'time'
     # Usamos el tiempo de la app si está disponible, si no, el de 'time'
-    df['TimeTaken'] = pd.to_numeric(df['TimeTaken'], errors='coerce')
-    df['TimeTakenClient'] = pd.to_numeric(df['TimeTakenClient'], errors='coerce')
-    df['time_s'] = df['TimeTaken'].fillna(df['TimeTakenClient']).fillna(df['time_elapsed_s'])
+    # (las ejecuciones leídas de runs.jsonl no tienen time.log)
+    df['time_s'] = np.nan
+    for col in ['TimeTaken', 'TimeTakenClient', 'time_elapsed_s']:
+        if col in df.columns:
+            df[col] = pd.to_numeric(df[col], errors='coerce')
+            df['time_s'] = df['time_s'].fillna(df[col])
     
     # Calcular Throughput (MB/s)
     df['throughput_mb_s'] = df['file_size_bytes'] / (1024**2) / df['time_s']
+    # Con varias conexiones simultáneas (--connections) cada una envía el archivo
+    # completo: se usa el rendimiento agregado que informa el cliente.
+    if 'AggregateThroughputMBs' in df.columns:
+        aggregate = pd.to_numeric(df['AggregateThroughputMBs'], errors='coerce')
+        df['throughput_mb_s'] = aggregate.fillna(df['throughput_mb_s'])
+    # Sin time.log, el % de CPU sale del tiempo de CPU que mide el propio programa
+    for col in ['cpu_percent', 'time_user_s', 'time_system_s']:
+        if col not in df.columns:
+            df[col] = np.nan
+    df['cpu_percent'] = df['cpu_percent'].fillna((df['time_user_s'] + df['time_system_s']) / df['time_s'] * 100)
+    if 'ConnLatencyP99' in df.columns:
+        df['conn_latency_p99_s'] = pd.to_numeric(df['ConnLatencyP99'], errors='coerce')
+    else:
+        df['conn_latency_p99_s'] = np.nan
+
+    # CPU por byte enviado (clientes de socket): ns de CPU de usuario+sistema
+    if 'CpuNsPerByte' in df.columns:
+        df['cpu_ns_per_byte'] = pd.to_numeric(df['CpuNsPerByte'], errors='coerce')
+    else:
+        df['cpu_ns_per_byte'] = np.nan
+    if 'ServerCpuNsPerByte' in df.columns:
+        df['server_cpu_ns_per_byte'] = pd.to_numeric(df['ServerCpuNsPerByte'], errors='coerce')
+    else:
+        df['server_cpu_ns_per_byte'] = np.nan
+    # Fallos de página del intervalo medido (file_buffered, file_mmap)
+    # y ocupación del cache de página que dejó la copia (file_buffered)
+    for key, col in [('MajorFaults', 'major_faults'), ('MinorFaults', 'minor_faults'),
+                     ('PageCacheDeltaKB', 'page_cache_delta_kb'),
+                     ('OutputResidentBytes', 'output_resident_bytes')]:
+        df[col] = pd.to_numeric(df[key], errors='coerce') if key in df.columns else np.nan
+    # Extents del destino (FIEMAP) y volcados emitidos (--prealloc/--fsync)
+    for key, col in [('Extents', 'extents'), ('FlushCalls', 'flush_calls')]:
+        df[col] = pd.to_numeric(df[key], errors='coerce') if key in df.columns else np.nan
+    # Porcentaje de la entrada residente en el cache antes de medir (--cold/--warm)
+    if 'InputResidentPctBefore' in df.columns:
+        df['input_resident_pct_before'] = pd.to_numeric(df['InputResidentPctBefore'], errors='coerce')
+    else:
+        df['input_resident_pct_before'] = np.nan
+    # Instrumentación de los programas (io_trace): latencia por llamada y
+    # cambios de contexto del intervalo medido
+    for key, col in [('SysReadLatP99Ns', 'read_lat_p99_ns'), ('SysWriteLatP99Ns', 'write_lat_p99_ns'),
+                     ('RusageVolCtxSwitches', 'vol_ctx_switches'),
+                     ('RusageInvolCtxSwitches', 'invol_ctx_switches')]:
+        df[col] = pd.to_numeric(df[key], errors='coerce') if key in df.columns else np.nan
+    # Muestreo del rendimiento durante la copia (--sample-ms)
+    for key, col in [('MaxStallMs', 'max_stall_ms'), ('SampleThroughputCvPct', 'sample_cv_pct'),
+                     ('ServerMaxStallMs', 'server_max_stall_ms')]:
+        df[col] = pd.to_numeric(df[key], errors='coerce') if key in df.columns else np.nan
+    # Latencia de ida y vuelta (pingpong_client), en microsegundos
+    for key, col in [('LatencyP50Us', 'latency_p50_us'), ('LatencyP99Us', 'latency_p99_us'),
+                     ('LatencyP999Us', 'latency_p999_us'), ('LatencyMaxUs', 'latency_max_us')]:
+        df[col] = pd.to_numeric(df[key], errors='coerce') if key in df.columns else np.nan
     df.replace([np.inf, -np.inf], np.nan, inplace=True) # Reemplazar infinitos por NaN
 
     print(f"Se procesaron {len(df)} registros de experimentos.")
 
+    present = set(df['mechanism'])
+    mechanism_order = [m for m in MECHANISM_ORDER if m in present]
+    mechanism_order += sorted(present - set(MECHANISM_ORDER))
+
     # --- Análisis Estadístico ---
     # Agrupar por parámetros de experimento y calcular media y desviación estándar
     stats_df = df.groupby(['mechanism', 'file_size', 'buffer_size_kb', 'sync_mode']).agg(
         mean_throughput_mb_s=('throughput_mb_s', 'mean'),
         std_throughput_mb_s=('throughput_mb_s', 'std'),
+        median_throughput_mb_s=('throughput_mb_s', 'median'),
+        iqr_throughput_mb_s=('throughput_mb_s', lambda x: x.quantile(0.75) - x.quantile(0.25)),
         mean_time_s=('time_s', 'mean'),
         std_time_s=('time_s', 'std'),
         mean_cpu_percent=('cpu_percent', 'mean'),
         mean_user_time_s=('time_user_s', 'mean'),
         mean_system_time_s=('time_system_s', 'mean'),
+        mean_cpu_ns_per_byte=('cpu_ns_per_byte', 'mean'),
+        mean_server_cpu_ns_per_byte=('server_cpu_ns_per_byte', 'mean'),
+        mean_conn_latency_p99_s=('conn_latency_p99_s', 'mean'),
+        mean_major_faults=('major_faults', 'mean'),
+        mean_minor_faults=('minor_faults', 'mean'),
+        mean_page_cache_delta_kb=('page_cache_delta_kb', 'mean'),
+        mean_output_resident_bytes=('output_resident_bytes', 'mean'),
+        mean_input_resident_pct_before=('input_resident_pct_before', 'mean'),
+        mean_extents=('extents', 'mean'),
+        mean_flush_calls=('flush_calls', 'mean'),
+        mean_latency_p50_us=('latency_p50_us', 'mean'),
+        mean_latency_p99_us=('latency_p99_us', 'mean'),
+        mean_latency_p999_us=('latency_p999_us', 'mean'),
+        mean_latency_max_us=('latency_max_us', 'mean'),
+        mean_max_stall_ms=('max_stall_ms', 'mean'),
+        max_max_stall_ms=('max_stall_ms', 'max'),
+        mean_server_max_stall_ms=('server_max_stall_ms', 'mean'),
+        mean_sample_cv_pct=('sample_cv_pct', 'mean'),
         count=('run', 'count')
     ).reset_index()
 
-    # Calcular intervalo de confianza del 95% para el throughput
-    stats_df['ci95_throughput'] = 1.96 * stats_df['std_throughput_mb_s'] / np.sqrt(stats_df['count'])
+    # Calcular intervalo de confianza del 95% para el throughput (t de Student:
+    # con 10 ejecuciones 1.96 lo estrecharía un 13%)
+    stats_df['ci95_throughput'] = (stats_df['count'].apply(t_critical_95) *
+                                   stats_df['std_throughput_mb_s'] / np.sqrt(stats_df['count']))
     
     # Guardar el resumen estadístico
     stats_df.to_csv(SUMMARY_CSV_PATH, index=False)
@@ -194,7 +348,7 @@ def main():
     # 1. Boxplot de Throughput por Mecanismo
     plt.figure(figsize=(15, 8))
     g = sns.boxplot(data=df, x='mechanism', y='throughput_mb_s', hue='file_size',
-                    order=['buffered', 'direct', 'sendfile', 'unix_socket', 'tcp_socket'],
+                    order=mechanism_order,
                     hue_order=['10M', '100M', '1G'])
     g.set_title('Rendimiento (Throughput) por Mecanismo de E/S y Tamaño de Archivo', fontsize=16)
     g.set_xlabel('Mecanismo', fontsize=12)
@@ -213,7 +367,7 @@ def main():
     
     plt.figure(figsize=(12, 7))
     g = sns.barplot(data=cpu_stats_melted, x='mechanism', y='time_s', hue='cpu_type',
-                    order=['buffered', 'direct', 'sendfile', 'unix_socket', 'tcp_socket'])
+                    order=mechanism_order)
     g.set_title('Tiempo de CPU (User vs System) para Archivo de 100M y Buffer de 64KB', fontsize=16)
     g.set_xlabel('Mecanismo', fontsize=12)
     g.set_ylabel('Tiempo Promedio (s)', fontsize=12)
@@ -228,14 +382,14 @@ def main():
     syscall_stats = syscall_df.groupby('mechanism')[syscall_cols].sum().reset_index()
     
     # Seleccionar solo las llamadas más relevantes
-    relevant_syscalls = ['syscall_read', 'syscall_write', 'syscall_sendfile', 'syscall_sendto', 'syscall_recvfrom']
+    relevant_syscalls = ['syscall_read', 'syscall_write', 'syscall_sendfile', 'syscall_copy_file_range', 'syscall_splice', 'syscall_io_uring_enter', 'syscall_io_submit', 'syscall_send', 'syscall_recv']
     relevant_cols = [c for c in syscall_stats.columns if c in relevant_syscalls or c == 'mechanism']
     syscall_stats_melted = syscall_stats[relevant_cols].melt(id_vars='mechanism', var_name='syscall', value_name='count')
     syscall_stats_melted = syscall_stats_melted[syscall_stats_melted['count'] > 0] # Filtrar las que no se llamaron
     
     plt.figure(figsize=(14, 8))
     g = sns.barplot(data=syscall_stats_melted, x='mechanism', y='count', hue='syscall',
-                    order=['buffered', 'direct', 'sendfile', 'unix_socket', 'tcp_socket'])
+                    order=mechanism_order)
     g.set_title('Total de Llamadas al Sistema (Archivo 100M, Buffer 64KB)', fontsize=16)
     g.set_xlabel('Mecanismo', fontsize=12)
     g.set_ylabel('Número Total de Llamadas (escala log)', fontsize=12)
@@ -244,6 +398,43 @@ def main():
     plt.tight_layout()
     plt.savefig(os.path.join(CHARTS_DIR, 'syscall_comparison.png'))
 
+    # 4. Latencia de ida y vuelta por tamaño de mensaje (pingpong)
+    pingpong_df = df[df['mechanism'].str.startswith('pingpong_')]
+    if not pingpong_df.empty:
+        latency_stats = pingpong_df.groupby(['mechanism', 'file_size_bytes'])[
+            ['latency_p50_us', 'latency_p99_us', 'latency_p999_us']].mean().reset_index()
+        latency_melted = latency_stats.melt(id_vars=['mechanism', 'file_size_bytes'],
+                                            var_name='percentile', value_name='latency_us')
+        g = sns.relplot(data=latency_melted, x='file_size_bytes', y='latency_us', hue='mechanism',
+                        col='percentile', kind='line', marker='o', height=5, aspect=1)
+        g.set(xscale='log', yscale='log')
+        g.set_axis_labels('Tamaño de mensaje (bytes)', 'Latencia de ida y vuelta (µs)')
+        g.fig.suptitle('Latencia Petición/Respuesta por Transporte', fontsize=16)
+        plt.tight_layout()
+        plt.savefig(os.path.join(CHARTS_DIR, 'pingpong_latency.png'))
+
+    # 5. Serie temporal del rendimiento (--sample-ms) en el archivo más grande:
+    # una línea por ejecución, para ver parones y dónde empieza el frenado
+    if 'SampleThroughputMBs' in df.columns:
+        series_df = df[df['SampleThroughputMBs'].notna()]
+        series_df = series_df[series_df['file_size_bytes'] == series_df['file_size_bytes'].max()]
+        if not series_df.empty:
+            mechanisms = sorted(series_df['mechanism'].unique(), key=mechanism_order.index)
+            fig, axes = plt.subplots(len(mechanisms), 1, figsize=(15, 3 * len(mechanisms)), squeeze=False)
+            for ax, mech in zip(axes[:, 0], mechanisms):
+                for _, row in series_df[series_df['mechanism'] == mech].iterrows():
+                    values = [float(v) for v in str(row['SampleThroughputMBs']).split(',') if v]
+                    t = np.arange(1, len(values) + 1) * float(row['SampleIntervalMs']) / 1000.0
+                    ax.plot(t, values, alpha=0.5,
+                            label=f"{row['buffer_size_kb']}KB {row['sync_mode']}" if row['run'] == 1 else None)
+                ax.set_title(mech)
+                ax.set_ylabel('MB/s')
+                ax.legend(fontsize=8, loc='upper right')
+            axes[-1, 0].set_xlabel('Tiempo (s)')
+            fig.suptitle(f"Rendimiento durante la copia ({series_df['file_size'].iloc[0]})", fontsize=16)
+            plt.tight_layout()
+            plt.savefig(os.path.join(CHARTS_DIR, 'throughput_timeseries.png'))
+
     print("Gráficos generados y guardados en:", CHARTS_DIR)
     print("\nAnálisis completado exitosamente.")
 
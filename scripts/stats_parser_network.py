@@ -6,10 +6,15 @@ stats_parser_network.py
 Versión especializada del parser para experimentos de red TCP/IP entre 2 PCs.
 Maneja los logs separados del servidor y cliente, y combina las métricas
 para obtener una visión completa del rendimiento de red.
+
+Si results/raw contiene runs_server.jsonl o runs_client.jsonl (los escribe
+run_all_network.sh con --json-out) se leen esos archivos; si no, se recorre
+el árbol de logs.
 """
 
 import os
 import re
+import json
 import pandas as pd
 import numpy as np
 import matplotlib.pyplot as plt
@@ -23,6 +28,16 @@ FINAL_RESULTS_DIR = os.path.join(BASE_DIR, "results")
 CHARTS_DIR = os.path.join(FINAL_RESULTS_DIR, "charts")
 SUMMARY_CSV_PATH = os.path.join(FINAL_RESULTS_DIR, "summary_network.csv")
 
+# Ajustes TCP efectivos que imprimen tcp_server/tcp_client (leídos con getsockopt)
+TUNING_KEYS = {
+    'SockSndBuf': 'eff_sndbuf',
+    'SockRcvBuf': 'eff_rcvbuf',
+    'TcpNoDelay': 'eff_nodelay',
+    'TcpCork': 'eff_cork',
+    'TcpNotSentLowat': 'eff_notsent_lowat',
+    'TcpQuickAck': 'eff_quickack',
+}
+
 # Asegurarse de que el directorio de gráficos exista
 os.makedirs(CHARTS_DIR, exist_ok=True)
 
@@ -59,25 +74,18 @@ def parse_time_log(file_path):
         pass
     return metrics
 
-def parse_strace_log(file_path):
-    """Parsea el output de strace -c."""
+def parse_syscalls(app_metrics):
+    """Llamadas al sistema contadas por los propios programas (claves Sys<Llamada>Calls).
+
+    Se devuelven como columnas syscall_<llamada> (SysCopyFileRangeCalls ->
+    syscall_copy_file_range), los mismos nombres que usaba strace -c.
+    """
     syscalls = {}
-    try:
-        with open(file_path, 'r') as f:
-            lines = f.readlines()
-            header_found = False
-            for line in lines:
-                if 'calls' in line and 'syscall' in line:
-                    header_found = True
-                    continue
-                if header_found and '---' not in line and line.strip():
-                    parts = line.split()
-                    if len(parts) >= 5:
-                        syscall_name = parts[-1]
-                        calls = int(parts[-2])
-                        syscalls[f'syscall_{syscall_name}'] = calls
-    except (IOError, IndexError):
-        pass
+    for key, value in app_metrics.items():
+        match = re.fullmatch(r'Sys(\w+)Calls', key)
+        if match:
+            name = re.sub(r'(?<!^)(?=[A-Z])', '_', match.group(1)).lower()
+            syscalls[f'syscall_{name}'] = int(value)
     return syscalls
 
 def parse_app_log(file_path):
@@ -103,33 +111,36 @@ def get_file_size_bytes(size_str):
     unit = size_str[-1].upper()
     return num * size_map.get(unit, 1)
 
-# --- Proceso Principal para Red ---
+# --- Carga de las ejecuciones ---
 
-def main():
-    """Función principal para análisis de experimentos de red."""
-    print("Iniciando análisis de resultados de red...")
-    
-    all_data = []
+def profile_of(mechanism):
+    """Solo interesa TCP. Cada perfil de ajuste se guarda como tcp_socket_<perfil>;
+    tcp_socket es el de por defecto. Devuelve None para el resto de mecanismos."""
+    if mechanism == 'tcp_socket':
+        return 'default'
+    if mechanism.startswith('tcp_socket_'):
+        return mechanism[len('tcp_socket_'):]
+    return None
 
-    if not os.path.exists(RAW_RESULTS_DIR):
-        print(f"ERROR: El directorio de resultados crudos '{RAW_RESULTS_DIR}' no existe.")
-        sys.exit(1)
 
+def load_log_tree(raw_dir):
+    """Recorre el árbol de resultados y analiza los logs de cliente y servidor."""
+    all_data = []
     # Recorrer el árbol de directorios de resultados
-    for root, _, files in os.walk(RAW_RESULTS_DIR):
+    for root, _, files in os.walk(raw_dir):
         if 'time_client.log' in files or 'time_server.log' in files:
             # Extraer parámetros desde la ruta
-            path_parts = root.replace(RAW_RESULTS_DIR, '').strip(os.sep).split(os.sep)
+            path_parts = root.replace(raw_dir, '').strip(os.sep).split(os.sep)
             if len(path_parts) != 5: continue
             
             mechanism, file_size_str, buffer_size_str, sync_mode, run_id = path_parts
             
-            # Solo procesar TCP para experimentos de red
-            if mechanism != 'tcp_socket':
+            if profile_of(mechanism) is None:
                 continue
                 
             run_data = {
                 'mechanism': mechanism,
+                'profile': profile_of(mechanism),
                 'file_size': file_size_str,
                 'buffer_size_kb': int(buffer_size_str.replace('KB', '')),
                 'sync_mode': sync_mode,
@@ -137,21 +148,63 @@ def main():
             }
             
             # Parsear logs del cliente (si existen)
+            base_data = run_data.copy()
             if 'time_client.log' in files:
                 run_data.update(parse_time_log(os.path.join(root, 'time_client.log')))
-                run_data.update(parse_strace_log(os.path.join(root, 'strace_client.log')))
-                run_data.update(parse_app_log(os.path.join(root, 'app_client.log')))
+                app_metrics = parse_app_log(os.path.join(root, 'app_client.log'))
+                run_data.update(app_metrics)
+                run_data.update(parse_syscalls(app_metrics))
                 run_data['side'] = 'client'
                 all_data.append(run_data.copy())
             
             # Parsear logs del servidor (si existen)
             if 'time_server.log' in files:
-                server_data = run_data.copy()
+                server_data = base_data.copy()
                 server_data.update(parse_time_log(os.path.join(root, 'time_server.log')))
-                server_data.update(parse_strace_log(os.path.join(root, 'strace_server.log')))
-                server_data.update(parse_app_log(os.path.join(root, 'app_server.log')))
+                app_metrics = parse_app_log(os.path.join(root, 'app_server.log'))
+                server_data.update(app_metrics)
+                server_data.update(parse_syscalls(app_metrics))
                 server_data['side'] = 'server'
                 all_data.append(server_data)
+    return all_data
+
+
+def load_jsonl(raw_dir):
+    """Lee runs_server.jsonl y runs_client.jsonl: una fila por ejecución y lado."""
+    all_data = []
+    for side in ('client', 'server'):
+        path = os.path.join(raw_dir, f'runs_{side}.jsonl')
+        if not os.path.exists(path):
+            continue
+        with open(path, 'r') as f:
+            for line in f:
+                if not line.strip():
+                    continue
+                row = json.loads(line)
+                if profile_of(row.get('mechanism', '')) is None:
+                    continue
+                row['profile'] = profile_of(row['mechanism'])
+                row['file_size'] = str(row['file_size'])
+                row['side'] = side
+                row.update(parse_syscalls(row))
+                # Sin time.log, el tiempo de CPU es el que mide el propio programa
+                if 'RusageUserTime' in row:
+                    row['time_user_s'] = float(row['RusageUserTime'])
+                    row['time_system_s'] = float(row['RusageSysTime'])
+                all_data.append(row)
+    return all_data
+
+# --- Proceso Principal para Red ---
+
+def main():
+    """Función principal para análisis de experimentos de red."""
+    print("Iniciando análisis de resultados de red...")
+    
+    if not os.path.exists(RAW_RESULTS_DIR):
+        print(f"ERROR: El directorio de resultados crudos '{RAW_RESULTS_DIR}' no existe.")
+        sys.exit(1)
+
+    all_data = load_jsonl(RAW_RESULTS_DIR) or load_log_tree(RAW_RESULTS_DIR)
 
     if not all_data:
         print("No se encontraron datos de logs de red para analizar.")
@@ -177,11 +230,22 @@ def main():
     df['throughput_mb_s'] = df['file_size_bytes'] / (1024**2) / df['time_s']
     df.replace([np.inf, -np.inf], np.nan, inplace=True)
 
+    # Ajustes efectivos; faltan en logs de versiones anteriores
+    for key, column in TUNING_KEYS.items():
+        if key in df.columns:
+            df[column] = pd.to_numeric(df[key], errors='coerce')
+        else:
+            df[column] = np.nan
+    if 'TcpCongestion' in df.columns:
+        df['eff_congestion'] = df['TcpCongestion'].fillna('')
+    else:
+        df['eff_congestion'] = ''
+
     print(f"Se procesaron {len(df)} registros de experimentos de red.")
 
     # --- Análisis Estadístico ---
     # Agrupar por parámetros del experimento y lado (cliente/servidor)
-    stats_df = df.groupby(['mechanism', 'file_size', 'buffer_size_kb', 'sync_mode', 'side']).agg(
+    stats_df = df.groupby(['mechanism', 'profile', 'file_size', 'buffer_size_kb', 'sync_mode', 'side']).agg(
         mean_throughput_mb_s=('throughput_mb_s', 'mean'),
         std_throughput_mb_s=('throughput_mb_s', 'std'),
         mean_time_s=('time_s', 'mean'),
@@ -189,6 +253,13 @@ def main():
         mean_cpu_percent=('cpu_percent', 'mean'),
         mean_user_time_s=('time_user_s', 'mean'),
         mean_system_time_s=('time_system_s', 'mean'),
+        eff_sndbuf=('eff_sndbuf', 'median'),
+        eff_rcvbuf=('eff_rcvbuf', 'median'),
+        eff_nodelay=('eff_nodelay', 'max'),
+        eff_cork=('eff_cork', 'max'),
+        eff_notsent_lowat=('eff_notsent_lowat', 'median'),
+        eff_quickack=('eff_quickack', 'max'),
+        eff_congestion=('eff_congestion', 'first'),
         count=('run', 'count')
     ).reset_index()
 
@@ -222,7 +293,7 @@ def main():
         syscall_stats = syscall_df.groupby('side')[syscall_cols].mean().reset_index()
         
         # Seleccionar llamadas relevantes
-        relevant_syscalls = ['syscall_read', 'syscall_write', 'syscall_sendto', 'syscall_recvfrom']
+        relevant_syscalls = ['syscall_read', 'syscall_write', 'syscall_send', 'syscall_recv', 'syscall_sendfile', 'syscall_splice']
         relevant_cols = [c for c in syscall_stats.columns if c in relevant_syscalls or c == 'side']
         syscall_stats_melted = syscall_stats[relevant_cols].melt(id_vars='side', var_name='syscall', value_name='count')
         syscall_stats_melted = syscall_stats_melted[syscall_stats_melted['count'] > 0]
@@ -248,6 +319,19 @@ def main():
     plt.tight_layout()
     plt.savefig(os.path.join(CHARTS_DIR, 'tcp_cpu_time_by_side.png'))
 
+    # 4. Rendimiento por perfil de ajuste TCP (lado servidor, buffer 64KB)
+    profile_df = df[(df['side'] == 'server') & (df['buffer_size_kb'] == 64)]
+    if profile_df['profile'].nunique() > 1:
+        plt.figure(figsize=(12, 7))
+        g = sns.barplot(data=profile_df, x='profile', y='throughput_mb_s', hue='file_size',
+                        hue_order=['10M', '100M', '1G'])
+        g.set_title('Rendimiento TCP por Perfil de Ajuste (Servidor, Buffer 64KB)', fontsize=16)
+        g.set_xlabel('Perfil', fontsize=12)
+        g.set_ylabel('Rendimiento (MB/s)', fontsize=12)
+        g.legend(title='Tamaño Archivo')
+        plt.tight_layout()
+        plt.savefig(os.path.join(CHARTS_DIR, 'tcp_throughput_by_profile.png'))
+
     print("Gráficos de red generados y guardados en:", CHARTS_DIR)
     print("\nAnálisis de red completado exitosamente.")
 
@@ -0,0 +1,49 @@
+#ifndef CACHE_STATE_H
+#define CACHE_STATE_H
+
+#include <getopt.h>
+
+/**
+ * cache_state.h
+ *
+ * Estado del cache de página del archivo de entrada antes del intervalo
+ * medido, sin vaciar el cache de todo el sistema (drop_caches necesita root
+ * y afecta a todo lo demás que corre en la máquina):
+ *  - --cold: desaloja solo las páginas del archivo de entrada
+ *            (fdatasync + POSIX_FADV_DONTNEED) y lo verifica con mincore.
+ *  - --warm: lee el archivo completo para dejarlo residente.
+ * Los archivos de salida se abren con O_TRUNC, que ya descarta sus páginas.
+ * En los tres casos (también sin opción) se mide y se informa la
+ * residencia de la entrada justo antes de empezar a medir.
+ */
+
+// Códigos de getopt, fuera del rango de los de tcp_tuning.h
+enum {
+    CACHE_OPT_COLD = 0x200,
+    CACHE_OPT_WARM,
+};
+
+#define CACHE_STATE_LONG_OPTIONS \
+    {"cold", no_argument, NULL, CACHE_OPT_COLD}, \
+    {"warm", no_argument, NULL, CACHE_OPT_WARM}
+
+#define CACHE_STATE_USAGE "[--cold|--warm]"
+
+enum cache_state { CACHE_STATE_DEFAULT, CACHE_STATE_COLD, CACHE_STATE_WARM };
+
+struct cache_report {
+    enum cache_state state;
+    long long input_size;
+    long long resident_before;    // Bytes residentes antes de medir (-1 = desconocido)
+};
+
+// Devuelve 1 si opt era --cold/--warm (y actualiza *state), 0 si no.
+int cache_state_parse_option(int opt, enum cache_state *state);
+
+// Prepara el estado pedido para el archivo de entrada y mide su residencia.
+// Devuelve 0, o -1 si el archivo no se puede abrir.
+int cache_state_prepare(enum cache_state state, const char *input_path, struct cache_report *rep);
+
+void cache_state_print(const struct cache_report *rep);
+
+#endif
@@ -0,0 +1,43 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "dio_align.h"
+
+/**
+ * dio_align.c
+ *
+ * Implementación de la consulta de alineación O_DIRECT (ver dio_align.h).
+ */
+
+int dio_align_probe(int fd, struct dio_align *al) {
+    al->mem_align = DIO_ALIGN_FALLBACK;
+    al->offset_align = DIO_ALIGN_FALLBACK;
+    al->from_statx = 0;
+
+#ifdef STATX_DIOALIGN
+    struct statx stx;
+    if (statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 && (stx.stx_mask & STATX_DIOALIGN)) {
+        // Ambos a cero: el archivo no admite O_DIRECT
+        if (stx.stx_dio_offset_align == 0) {
+            return -1;
+        }
+        al->mem_align = stx.stx_dio_mem_align;
+        al->offset_align = stx.stx_dio_offset_align;
+        al->from_statx = 1;
+    }
+#endif
+    // posix_memalign() exige al menos el tamaño de un puntero
+    if (al->mem_align < sizeof(void *)) {
+        al->mem_align = sizeof(void *);
+    }
+    return 0;
+}
+
+void dio_align_merge(struct dio_align *dst, const struct dio_align *src) {
+    if (src->mem_align > dst->mem_align) dst->mem_align = src->mem_align;
+    if (src->offset_align > dst->offset_align) dst->offset_align = src->offset_align;
+    dst->from_statx = dst->from_statx && src->from_statx;
+}
@@ -0,0 +1,28 @@
+#ifndef DIO_ALIGN_H
+#define DIO_ALIGN_H
+
+/**
+ * dio_align.h
+ *
+ * Alineación que exige O_DIRECT para un archivo concreto. Se consulta con
+ * statx(STATX_DIOALIGN) (Linux 6.1+, por ahora ext4, xfs, f2fs y
+ * dispositivos de bloque). Si el kernel o el sistema de archivos no la
+ * informan, se usa DIO_ALIGN_FALLBACK, que vale en casi todos los discos.
+ */
+
+#define DIO_ALIGN_FALLBACK 4096
+
+struct dio_align {
+    unsigned int mem_align;       // Alineación de la dirección del búfer
+    unsigned int offset_align;    // Alineación de desplazamientos y longitudes
+    int from_statx;               // 1 si los valores vienen de STATX_DIOALIGN
+};
+
+// Alineación O_DIRECT del archivo abierto en fd. Devuelve -1 si statx()
+// informa que el archivo no admite E/S directa; 0 en los demás casos.
+int dio_align_probe(int fd, struct dio_align *al);
+
+// Combina dos alineaciones (p. ej. origen y destino) quedándose con la mayor
+void dio_align_merge(struct dio_align *dst, const struct dio_align *src);
+
+#endif
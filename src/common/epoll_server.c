@@ -0,0 +1,272 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "epoll_server.h"
+#include "io_trace.h"
+#include "sampler.h"
+#include "stats.h"
+
+/**
+ * epoll_server.c
+ *
+ * Implementación del modo persistente (ver epoll_server.h). Cada hilo que
+ * ejecuta el bucle tiene su propio epoll y su propio búfer; la numeración
+ * de los archivos de salida y la cuenta de conexiones completadas son
+ * globales al proceso.
+ */
+
+#define EPOLL_MAX_EVENTS 64
+#define EPOLL_TIMEOUT_MS 200 // Para revisar periódicamente las condiciones de parada
+
+// Estado de una conexión
+struct connection {
+    int sock;
+    int fd_out;
+    long long bytes;
+    struct timespec accepted;
+};
+
+static long next_connection_id = 0;   // Numeración global de los archivos de salida
+static long completed_connections = 0;
+
+static double timespec_diff(const struct timespec *a, const struct timespec *b) {
+    return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) / 1e9;
+}
+
+// Cierra una conexión y registra su duración
+static void finish_connection(struct connection *c, const struct epoll_server *srv, struct epoll_stats *st) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (st->connections == (long)st->latencies_cap) {
+        size_t cap = st->latencies_cap ? st->latencies_cap * 2 : 64;
+        double *grown = realloc(st->latencies, cap * sizeof(double));
+        if (grown != NULL) {
+            st->latencies = grown;
+            st->latencies_cap = cap;
+        }
+    }
+    if (st->connections < (long)st->latencies_cap) {
+        st->latencies[st->connections] = timespec_diff(&c->accepted, &now);
+    }
+    st->connections++;
+    st->bytes += c->bytes;
+    st->last_close = now;
+    __atomic_add_fetch(&completed_connections, 1, __ATOMIC_SEQ_CST);
+    if (srv->hooks != NULL && srv->hooks->finish != NULL) {
+        srv->hooks->finish(c->sock, srv->hook_arg);
+    }
+
+    close(c->fd_out);
+    close(c->sock); // También lo elimina del conjunto epoll
+    free(c);
+}
+
+// Acepta todas las conexiones pendientes (el socket de escucha es edge-triggered)
+static int accept_pending(int epfd, int listen_sock, const struct epoll_server *srv, struct epoll_stats *st) {
+    for (;;) {
+        int sock = accept4(listen_sock, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (sock == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            perror("Error en accept");
+            return -1;
+        }
+
+        struct connection *c = calloc(1, sizeof(*c));
+        if (c == NULL) {
+            perror("Error al asignar memoria para la conexión");
+            close(sock);
+            continue;
+        }
+        c->sock = sock;
+        if (srv->hooks != NULL && srv->hooks->setup != NULL) {
+            srv->hooks->setup(sock, srv->hook_arg);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &c->accepted);
+        if (!st->started) {
+            st->first_accept = c->accepted;
+            st->started = 1;
+        }
+
+        char path[4096];
+        long id = __atomic_fetch_add(&next_connection_id, 1, __ATOMIC_SEQ_CST);
+        snprintf(path, sizeof(path), "%s.%ld", srv->output_path, id);
+        c->fd_out = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (c->fd_out == -1) {
+            perror("Error al abrir el archivo de salida");
+            close(sock);
+            free(c);
+            continue;
+        }
+
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP | EPOLLET, .data.ptr = c };
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, sock, &ev) == -1) {
+            perror("Error en epoll_ctl");
+            close(c->fd_out);
+            close(sock);
+            free(c);
+        }
+    }
+}
+
+// Lee todo lo disponible en una conexión. Devuelve 1 si la conexión terminó.
+static int drain_connection(struct connection *c, char *buffer, const struct epoll_server *srv,
+                            struct epoll_stats *st) {
+    for (;;) {
+        ssize_t n = IO_TRACE(IO_OP_RECV, recv(c->sock, buffer, srv->buffer_size, 0));
+        if (n > 0) {
+            st->recv_calls++;
+            if (srv->hooks != NULL && srv->hooks->rearm != NULL) {
+                srv->hooks->rearm(c->sock, srv->hook_arg);
+            }
+            ssize_t bytes_written = IO_TRACE(IO_OP_WRITE, write(c->fd_out, buffer, n));
+            st->write_calls++;
+            if (bytes_written != n) {
+                perror("Error de escritura incompleta en el servidor");
+                return 1;
+            }
+            c->bytes += n;
+            sampler_add(n);
+            continue;
+        }
+        if (n == 0) {
+            return 1; // El cliente cerró la conexión
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        perror("Error en recv del servidor");
+        return 1;
+    }
+}
+
+int epoll_server_run(int listen_sock, const struct epoll_server *srv, struct epoll_stats *st) {
+    int flags = fcntl(listen_sock, F_GETFL, 0);
+    if (flags == -1 || fcntl(listen_sock, F_SETFL, flags | O_NONBLOCK) == -1) {
+        perror("Error al poner el socket de escucha en modo no bloqueante");
+        return -1;
+    }
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd == -1) {
+        perror("Error en epoll_create1");
+        return -1;
+    }
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLET, .data.ptr = NULL };
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, listen_sock, &ev) == -1) {
+        perror("Error en epoll_ctl");
+        close(epfd);
+        return -1;
+    }
+
+    // Un único búfer basta: cada bloque recibido se escribe antes del siguiente recv
+    char *buffer = malloc(srv->buffer_size);
+    if (buffer == NULL) {
+        perror("Error al asignar memoria para el buffer");
+        close(epfd);
+        return -1;
+    }
+
+    struct epoll_event events[EPOLL_MAX_EVENTS];
+    int ret = 0;
+    while (!*srv->stop) {
+        if (srv->max_conns > 0 && __atomic_load_n(&completed_connections, __ATOMIC_SEQ_CST) >= srv->max_conns) {
+            break;
+        }
+
+        int n = epoll_wait(epfd, events, EPOLL_MAX_EVENTS, EPOLL_TIMEOUT_MS);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            perror("Error en epoll_wait");
+            ret = -1;
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            struct connection *c = events[i].data.ptr;
+            if (c == NULL) {
+                if (accept_pending(epfd, listen_sock, srv, st) == -1) {
+                    ret = -1;
+                }
+                continue;
+            }
+            if (drain_connection(c, buffer, srv, st)) {
+                finish_connection(c, srv, st);
+            }
+        }
+        if (ret == -1) {
+            break;
+        }
+    }
+
+    // Las conexiones que sigan abiertas al parar se cierran con el proceso
+    free(buffer);
+    close(epfd);
+    return ret;
+}
+
+void epoll_stats_merge(struct epoll_stats *dst, const struct epoll_stats *src) {
+    size_t n = src->connections < (long)src->latencies_cap ? (size_t)src->connections : src->latencies_cap;
+    if (n > 0) {
+        double *grown = realloc(dst->latencies, (dst->latencies_cap + n) * sizeof(double));
+        if (grown != NULL) {
+            // Las latencias válidas de dst ocupan las primeras min(connections, cap) posiciones
+            size_t used = dst->connections < (long)dst->latencies_cap ? (size_t)dst->connections : dst->latencies_cap;
+            memcpy(grown + used, src->latencies, n * sizeof(double));
+            dst->latencies = grown;
+            dst->latencies_cap = used + n;
+        }
+    }
+    dst->connections += src->connections;
+    dst->bytes += src->bytes;
+    dst->recv_calls += src->recv_calls;
+    dst->write_calls += src->write_calls;
+    if (src->started) {
+        if (!dst->started || timespec_diff(&src->first_accept, &dst->first_accept) > 0) {
+            dst->first_accept = src->first_accept;
+        }
+        if (!dst->started || timespec_diff(&dst->last_close, &src->last_close) > 0) {
+            dst->last_close = src->last_close;
+        }
+        dst->started = 1;
+    }
+}
+
+void epoll_stats_print(const char *mechanism, const struct epoll_server *srv, struct epoll_stats *st,
+                       double user_time, double sys_time) {
+    double wall = st->started ? timespec_diff(&st->first_accept, &st->last_close) : 0.0;
+    size_t n = st->connections < (long)st->latencies_cap ? (size_t)st->connections : st->latencies_cap;
+    qsort(st->latencies, n, sizeof(double), compare_doubles);
+
+    printf("Mechanism: %s\n", mechanism);
+    printf("BufferSize: %ld\n", srv->buffer_size);
+    printf("TimeTakenServer: %.6f\n", wall);
+    printf("Connections: %ld\n", st->connections);
+    printf("BytesReceived: %lld\n", st->bytes);
+    printf("AggregateThroughputMBs: %.2f\n", wall > 0 ? st->bytes / (1024.0 * 1024.0) / wall : 0.0);
+    printf("ConnLatencyP50: %.6f\n", percentile(st->latencies, n, 50));
+    printf("ConnLatencyP90: %.6f\n", percentile(st->latencies, n, 90));
+    printf("ConnLatencyP99: %.6f\n", percentile(st->latencies, n, 99));
+    printf("ConnLatencyMax: %.6f\n", n > 0 ? st->latencies[n - 1] : 0.0);
+    printf("RecvCalls: %ld\n", st->recv_calls);
+    printf("WriteCalls: %ld\n", st->write_calls);
+    if (srv->hooks != NULL && srv->hooks->print != NULL) {
+        srv->hooks->print(srv->hook_arg);
+    }
+    printf("UserTime: %.6f\n", user_time);
+    printf("SysTime: %.6f\n", sys_time);
+    printf("CpuNsPerByte: %.4f\n", st->bytes > 0 ? (user_time + sys_time) * 1e9 / st->bytes : 0.0);
+    sampler_print();
+    io_trace_print();
+}
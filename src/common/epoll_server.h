@@ -0,0 +1,65 @@
+#ifndef EPOLL_SERVER_H
+#define EPOLL_SERVER_H
+
+#include <signal.h>
+#include <stddef.h>
+#include <time.h>
+
+/**
+ * epoll_server.h
+ *
+ * Modo persistente (--epoll) de tcp_server y unix_socket_server: un bucle de
+ * eventos epoll edge-triggered con sockets no bloqueantes que atiende muchas
+ * subidas simultáneas y escribe cada una en su propio archivo
+ * <output_path>.<n>. Termina tras max_conns conexiones completadas (contadas
+ * entre todos los hilos que ejecuten el bucle a la vez) o cuando *stop se
+ * activa, normalmente desde el manejador de SIGINT/SIGTERM.
+ *
+ * Lo único que depende del tipo de socket va en los ganchos: tcp_server los
+ * usa para aplicar sus ajustes TCP a cada conexión aceptada, rearmar
+ * TCP_QUICKACK tras cada recv() y leer los valores efectivos.
+ */
+
+// Ganchos por socket; cualquiera puede ser NULL. arg es epoll_server.hook_arg.
+struct epoll_server_hooks {
+    void (*setup)(int sock, void *arg);   // Tras aceptar la conexión
+    void (*rearm)(int sock, void *arg);   // Tras cada recv() con datos
+    void (*finish)(int sock, void *arg);  // Antes de cerrar la conexión
+    void (*print)(void *arg);             // Claves propias, tras WriteCalls
+};
+
+struct epoll_server {
+    const char *output_path;
+    long buffer_size;
+    long max_conns;                       // 0 = hasta que se active *stop
+    volatile sig_atomic_t *stop;
+    const struct epoll_server_hooks *hooks;
+    void *hook_arg;
+};
+
+// Resultados acumulados de un bucle (inicializar a cero)
+struct epoll_stats {
+    long connections;         // Conexiones completadas
+    long long bytes;
+    long recv_calls;
+    long write_calls;
+    double *latencies;        // Duración de cada conexión (s)
+    size_t latencies_cap;
+    struct timespec first_accept;
+    struct timespec last_close;
+    int started;
+};
+
+// Atiende listen_sock (ya en escucha) hasta la condición de parada.
+// Devuelve 0, o -1 si falló (ya informado con perror).
+int epoll_server_run(int listen_sock, const struct epoll_server *srv, struct epoll_stats *st);
+
+// Acumula en dst los resultados de otro bucle (modo con varios hilos)
+void epoll_stats_merge(struct epoll_stats *dst, const struct epoll_stats *src);
+
+// Imprime los resultados con el formato Clave: valor, incluidos los de
+// sampler e io_trace. Ordena st->latencies.
+void epoll_stats_print(const char *mechanism, const struct epoll_server *srv, struct epoll_stats *st,
+                       double user_time, double sys_time);
+
+#endif
@@ -0,0 +1,82 @@
+#include <math.h>
+#include <string.h>
+
+#include "histogram.h"
+
+/**
+ * histogram.c
+ *
+ * Implementación del histograma log-lineal (ver histogram.h).
+ */
+
+static int bucket_index(uint64_t value) {
+    if (value < HIST_SUB_BUCKETS) {
+        return (int)value;
+    }
+    if (value >= (1ULL << HIST_MAX_BITS)) {
+        value = (1ULL << HIST_MAX_BITS) - 1;
+    }
+    int magnitude = 63 - __builtin_clzll(value);    // Posición del bit más alto
+    int shift = magnitude - HIST_SUB_BUCKET_BITS;
+    int sub = (int)((value >> shift) & (HIST_SUB_BUCKETS - 1));
+    return (shift + 1) * HIST_SUB_BUCKETS + sub;
+}
+
+// Mayor valor que cae en la cubeta index
+static uint64_t bucket_upper(int index) {
+    if (index < HIST_SUB_BUCKETS) {
+        return (uint64_t)index;
+    }
+    int shift = index / HIST_SUB_BUCKETS - 1;
+    uint64_t sub = index % HIST_SUB_BUCKETS;
+    return ((HIST_SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+void hist_init(struct histogram *h) {
+    memset(h, 0, sizeof(*h));
+    h->min = UINT64_MAX;
+}
+
+void hist_record(struct histogram *h, uint64_t value) {
+    h->counts[bucket_index(value)]++;
+    h->total++;
+    h->sum += (double)value;
+    if (value < h->min) h->min = value;
+    if (value > h->max) h->max = value;
+}
+
+void hist_merge(struct histogram *dst, const struct histogram *src) {
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total += src->total;
+    dst->sum += src->sum;
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+uint64_t hist_percentile(const struct histogram *h, double p) {
+    if (h->total == 0) {
+        return 0;
+    }
+    // Rango más cercano, ceil(p/100 * n), como stats.c. El margen evita que
+    // el error de redondeo de p/100 (p. ej. 99.9) suba un rango entero.
+    uint64_t rank = (uint64_t)ceil(p / 100.0 * h->total - 1e-9);
+    if (rank < 1) rank = 1;
+    if (rank > h->total) rank = h->total;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            uint64_t upper = bucket_upper(i);
+            // Nunca por encima del máximo observado
+            return upper < h->max ? upper : h->max;
+        }
+    }
+    return h->max;
+}
+
+double hist_mean(const struct histogram *h) {
+    return h->total > 0 ? h->sum / h->total : 0.0;
+}
@@ -0,0 +1,37 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+/**
+ * histogram.h
+ *
+ * Histograma log-lineal al estilo HDR para latencias en nanosegundos. Los
+ * valores menores que HIST_SUB_BUCKETS se guardan exactos; a partir de ahí
+ * cada potencia de dos se divide en HIST_SUB_BUCKETS cubetas, con lo que el
+ * error relativo de cualquier percentil es menor que 1/HIST_SUB_BUCKETS
+ * (< 1%) y el tamaño es fijo, sin guardar cada muestra.
+ */
+
+#define HIST_SUB_BUCKET_BITS 7
+#define HIST_SUB_BUCKETS (1 << HIST_SUB_BUCKET_BITS)
+#define HIST_MAX_BITS 40 // Valores hasta 2^40 ns (~18 minutos); los mayores se recortan
+#define HIST_BUCKETS ((HIST_MAX_BITS - HIST_SUB_BUCKET_BITS + 1) * HIST_SUB_BUCKETS)
+
+struct histogram {
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+};
+
+void hist_init(struct histogram *h);
+void hist_record(struct histogram *h, uint64_t value);
+void hist_merge(struct histogram *dst, const struct histogram *src);
+
+// Valor del percentil p (0-100): el mayor valor equivalente de su cubeta
+uint64_t hist_percentile(const struct histogram *h, double p);
+double hist_mean(const struct histogram *h);
+
+#endif
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include "histogram.h"
+#include "io_trace.h"
+
+/**
+ * io_trace.c
+ *
+ * Implementación de la instrumentación de llamadas (ver io_trace.h). Cada
+ * hilo reserva sus contadores la primera vez que registra algo y los añade
+ * a una lista global sin cerrojos; la lista no se libera, para que los
+ * hilos ya terminados sigan contando al imprimir.
+ */
+
+struct io_trace_op {
+    uint64_t calls;
+    uint64_t errors;
+    uint64_t bytes;
+    struct histogram latency;   // ns por llamada
+    struct histogram size;      // bytes por llamada (solo las que devolvieron > 0)
+};
+
+struct io_trace_thread {
+    struct io_trace_op *ops[IO_OP_COUNT];
+    struct io_trace_thread *next;
+};
+
+static const struct {
+    const char *name;   // Parte de la clave: Sys<name>Calls...
+    int has_bytes;      // El resultado de la llamada son bytes transferidos
+} op_info[IO_OP_COUNT] = {
+    [IO_OP_READ]            = {"Read", 1},
+    [IO_OP_WRITE]           = {"Write", 1},
+    [IO_OP_RECV]            = {"Recv", 1},
+    [IO_OP_SEND]            = {"Send", 1},
+    [IO_OP_SENDFILE]        = {"Sendfile", 1},
+    [IO_OP_SPLICE]          = {"Splice", 1},
+    [IO_OP_COPY_FILE_RANGE] = {"CopyFileRange", 1},
+    [IO_OP_IO_SUBMIT]       = {"IoSubmit", 0},
+    [IO_OP_IO_GETEVENTS]    = {"IoGetevents", 0},
+    [IO_OP_IO_URING_ENTER]  = {"IoUringEnter", 0},
+};
+
+static struct io_trace_thread *threads;
+static __thread struct io_trace_thread *self;
+static volatile int active;
+static struct rusage ru_begin, ru_end;
+
+static void op_reset(struct io_trace_op *o) {
+    o->calls = o->errors = o->bytes = 0;
+    hist_init(&o->latency);
+    hist_init(&o->size);
+}
+
+static struct io_trace_op *op_get(enum io_op op) {
+    if (self == NULL) {
+        self = calloc(1, sizeof(*self));
+        if (self == NULL) return NULL;
+        struct io_trace_thread *head = __atomic_load_n(&threads, __ATOMIC_ACQUIRE);
+        do {
+            self->next = head;
+        } while (!__atomic_compare_exchange_n(&threads, &head, self, 0, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+    }
+    if (self->ops[op] == NULL) {
+        struct io_trace_op *o = malloc(sizeof(*o));
+        if (o == NULL) return NULL;
+        op_reset(o);
+        self->ops[op] = o;
+    }
+    return self->ops[op];
+}
+
+void io_trace_record(enum io_op op, uint64_t start_ns, ssize_t ret) {
+    uint64_t elapsed = io_trace_now() - start_ns;
+    if (!active) return;
+    struct io_trace_op *o = op_get(op);
+    if (o == NULL) return;
+    o->calls++;
+    hist_record(&o->latency, elapsed);
+    if (ret < 0) {
+        o->errors++;
+    } else if (ret > 0 && op_info[op].has_bytes) {
+        o->bytes += ret;
+        hist_record(&o->size, (uint64_t)ret);
+    }
+}
+
+void io_trace_begin(void) {
+    // Se llama antes de arrancar los hilos del intervalo medido
+    for (struct io_trace_thread *t = threads; t != NULL; t = t->next) {
+        for (int i = 0; i < IO_OP_COUNT; i++) {
+            if (t->ops[i] != NULL) op_reset(t->ops[i]);
+        }
+    }
+    getrusage(RUSAGE_SELF, &ru_begin);
+    active = 1;
+}
+
+void io_trace_end(void) {
+    active = 0;
+    getrusage(RUSAGE_SELF, &ru_end);
+}
+
+static double tv_diff(const struct timeval *a, const struct timeval *b) {
+    return (b->tv_sec - a->tv_sec) + (b->tv_usec - a->tv_usec) / 1e6;
+}
+
+void io_trace_print(void) {
+    struct io_trace_op *sum = malloc(sizeof(*sum));
+    if (sum == NULL) return;
+
+    for (int i = 0; i < IO_OP_COUNT; i++) {
+        op_reset(sum);
+        for (struct io_trace_thread *t = threads; t != NULL; t = t->next) {
+            const struct io_trace_op *o = t->ops[i];
+            if (o == NULL) continue;
+            sum->calls += o->calls;
+            sum->errors += o->errors;
+            sum->bytes += o->bytes;
+            hist_merge(&sum->latency, &o->latency);
+            hist_merge(&sum->size, &o->size);
+        }
+        if (sum->calls == 0) continue;
+
+        const char *name = op_info[i].name;
+        printf("Sys%sCalls: %llu\n", name, (unsigned long long)sum->calls);
+        printf("Sys%sErrors: %llu\n", name, (unsigned long long)sum->errors);
+        if (op_info[i].has_bytes) {
+            printf("Sys%sBytes: %llu\n", name, (unsigned long long)sum->bytes);
+            printf("Sys%sBytesPerCallP50: %llu\n", name, (unsigned long long)hist_percentile(&sum->size, 50));
+        }
+        printf("Sys%sLatMeanNs: %.0f\n", name, hist_mean(&sum->latency));
+        printf("Sys%sLatP50Ns: %llu\n", name, (unsigned long long)hist_percentile(&sum->latency, 50));
+        printf("Sys%sLatP99Ns: %llu\n", name, (unsigned long long)hist_percentile(&sum->latency, 99));
+        printf("Sys%sLatMaxNs: %llu\n", name, (unsigned long long)sum->latency.max);
+    }
+    free(sum);
+
+    printf("RusageUserTime: %.6f\n", tv_diff(&ru_begin.ru_utime, &ru_end.ru_utime));
+    printf("RusageSysTime: %.6f\n", tv_diff(&ru_begin.ru_stime, &ru_end.ru_stime));
+    printf("RusageVolCtxSwitches: %ld\n", ru_end.ru_nvcsw - ru_begin.ru_nvcsw);
+    printf("RusageInvolCtxSwitches: %ld\n", ru_end.ru_nivcsw - ru_begin.ru_nivcsw);
+    printf("RusageMajorFaults: %ld\n", ru_end.ru_majflt - ru_begin.ru_majflt);
+    printf("RusageMinorFaults: %ld\n", ru_end.ru_minflt - ru_begin.ru_minflt);
+}
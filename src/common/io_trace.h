@@ -0,0 +1,70 @@
+#ifndef IO_TRACE_H
+#define IO_TRACE_H
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+
+/**
+ * io_trace.h
+ *
+ * Instrumentación de las llamadas de E/S dentro del propio programa, en
+ * lugar de strace -c. strace detiene el proceso en cada llamada (ptrace),
+ * y ese coste infla justo los casos con muchas llamadas pequeñas. Aquí cada
+ * llamada del bucle de copia se envuelve con IO_TRACE(), que cuesta dos
+ * lecturas del reloj por la vDSO (unas decenas de ns).
+ *
+ * Por cada tipo de llamada se acumulan el número de llamadas, los errores,
+ * los bytes, un histograma de latencia (ns) y otro de bytes por llamada (ver
+ * histogram.h). Cada hilo acumula en su propia estructura y las de todos se
+ * suman al imprimir. Solo cuenta lo ejecutado entre io_trace_begin() y
+ * io_trace_end(), que también toman getrusage() del proceso para informar
+ * CPU, cambios de contexto y fallos de página de ese mismo intervalo.
+ *
+ * Uso:
+ *   io_trace_begin();
+ *   n = IO_TRACE(IO_OP_READ, read(fd, buf, len));
+ *   io_trace_end();
+ *   io_trace_print();   // Claves Sys<Llamada>... y Rusage...
+ */
+
+enum io_op {
+    IO_OP_READ,             // read, pread
+    IO_OP_WRITE,            // write, pwrite
+    IO_OP_RECV,             // recv, recvmsg
+    IO_OP_SEND,             // send, sendmsg
+    IO_OP_SENDFILE,
+    IO_OP_SPLICE,
+    IO_OP_COPY_FILE_RANGE,
+    IO_OP_IO_SUBMIT,        // Linux AIO (sin bytes)
+    IO_OP_IO_GETEVENTS,
+    IO_OP_IO_URING_ENTER,   // io_uring (sin bytes)
+    IO_OP_COUNT
+};
+
+static inline uint64_t io_trace_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Registra una llamada que empezó en start_ns y devolvió ret (< 0: error)
+void io_trace_record(enum io_op op, uint64_t start_ns, ssize_t ret);
+
+// Ejecuta call, registra su latencia y su resultado, y devuelve el resultado
+#define IO_TRACE(op, call) ({                       \
+        uint64_t io_trace_t0_ = io_trace_now();     \
+        ssize_t io_trace_ret_ = (call);             \
+        io_trace_record((op), io_trace_t0_, io_trace_ret_); \
+        io_trace_ret_;                              \
+    })
+
+// Inicio del intervalo medido: pone a cero los contadores y toma getrusage()
+void io_trace_begin(void);
+
+// Fin del intervalo medido: deja de registrar y toma getrusage()
+void io_trace_end(void);
+
+void io_trace_print(void);
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+/**
+ * page_cache.h
+ *
+ * Consultas sobre el cache de página: cuántos bytes de un archivo están
+ * residentes (mmap + mincore, sin leer el archivo) y el total del sistema
+ * según la línea "Cached:" de /proc/meminfo.
+ */
+
+// Bytes del archivo abierto en fd presentes en el cache, o -1 si hay error
+long long page_cache_resident_bytes(int fd);
+
+// Valor de "Cached:" en /proc/meminfo en KiB, o -1 si no se puede leer
+long page_cache_meminfo_cached_kb(void);
+
+#endif
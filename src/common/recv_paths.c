@@ -0,0 +1,266 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "io_trace.h"
+#include "recv_paths.h"
+#include "sampler.h"
+
+/**
+ * recv_paths.c
+ *
+ * Implementación de los caminos de recepción (ver recv_paths.h).
+ */
+
+static void rearm(const struct recv_hook *hook, int sock) {
+    if (hook != NULL && hook->rearm != NULL) {
+        hook->rearm(sock, hook->arg);
+    }
+}
+
+long long recv_copy(int sock, int fd_out, long buffer_size, const struct recv_hook *hook, struct recv_stats *st) {
+    char *buffer = malloc(buffer_size);
+    if (buffer == NULL) {
+        perror("Error al asignar memoria para el buffer");
+        return -1;
+    }
+
+    long long total = 0;
+    for (;;) {
+        ssize_t bytes_received = IO_TRACE(IO_OP_RECV, recv(sock, buffer, buffer_size, 0));
+        if (bytes_received == -1) {
+            if (errno == EINTR) continue;
+            perror("Error en recv del servidor");
+            total = -1;
+            break;
+        }
+        if (bytes_received == 0) {
+            break; // El cliente cerró la conexión
+        }
+        st->recv_calls++;
+        rearm(hook, sock);
+        ssize_t bytes_written = IO_TRACE(IO_OP_WRITE, write(fd_out, buffer, bytes_received));
+        st->write_calls++;
+        if (bytes_written != bytes_received) {
+            perror("Error de escritura incompleta en el servidor");
+            total = -1;
+            break;
+        }
+        total += bytes_written;
+        sampler_add(bytes_written);
+    }
+
+    free(buffer);
+    return total;
+}
+
+long long recv_with_splice(int sock, int fd_out, long chunk, const struct recv_hook *hook, struct recv_stats *st) {
+    int pipefd[2];
+    if (pipe(pipefd) == -1) {
+        perror("Error al crear la tubería");
+        return -1;
+    }
+    long pipe_size = fcntl(pipefd[1], F_SETPIPE_SZ, chunk);
+    if (pipe_size == -1) {
+        pipe_size = fcntl(pipefd[1], F_GETPIPE_SZ);
+    }
+    if (chunk > pipe_size) {
+        chunk = pipe_size;
+    }
+
+    long long total = 0;
+    for (;;) {
+        ssize_t in_pipe = IO_TRACE(IO_OP_SPLICE, splice(sock, NULL, pipefd[1], NULL, chunk, SPLICE_F_MOVE | SPLICE_F_MORE));
+        st->splice_calls++;
+        rearm(hook, sock);
+        if (in_pipe == -1) {
+            if (errno == EINTR) continue;
+            perror("Error en splice (socket -> tubería)");
+            total = -1;
+            break;
+        }
+        if (in_pipe == 0) {
+            break; // El cliente cerró la conexión
+        }
+        while (in_pipe > 0) {
+            ssize_t out = IO_TRACE(IO_OP_SPLICE, splice(pipefd[0], NULL, fd_out, NULL, in_pipe, SPLICE_F_MOVE | SPLICE_F_MORE));
+            st->splice_calls++;
+            if (out == -1) {
+                if (errno == EINTR) continue;
+                perror("Error en splice (tubería -> archivo)");
+                total = -1;
+                break;
+            }
+            in_pipe -= out;
+            total += out;
+            sampler_add(out);
+        }
+        if (total == -1) {
+            break;
+        }
+    }
+
+    close(pipefd[0]);
+    close(pipefd[1]);
+    return total;
+}
+
+// Anillo de búferes alineados entre el hilo receptor y el escritor.
+// Los búferes [tail, tail + count) están llenos y pendientes de escribir;
+// el receptor solo toca el búfer head y el escritor solo el tail.
+struct bounce_ring {
+    char *pool;
+    long slot_size;
+    size_t filled[RECV_RING_SLOTS];
+    int head, tail, count;
+    int eof;                  // El receptor no va a llenar más búferes
+    int failed;               // Cualquiera de los dos lados falló
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+
+    int fd_out;
+    unsigned int offset_align;
+    struct recv_stats *st;
+    long long written;        // Bytes recibidos ya escritos (sin relleno)
+};
+
+static void *ring_writer(void *arg) {
+    struct bounce_ring *r = arg;
+    for (;;) {
+        pthread_mutex_lock(&r->lock);
+        while (r->count == 0 && !r->eof && !r->failed) {
+            pthread_cond_wait(&r->not_empty, &r->lock);
+        }
+        if (r->count == 0 || r->failed) {
+            pthread_mutex_unlock(&r->lock);
+            return NULL;
+        }
+        int slot = r->tail;
+        size_t filled = r->filled[slot];
+        pthread_mutex_unlock(&r->lock);
+
+        // El último bloque se rellena hasta la alineación
+        size_t write_len = filled;
+        if (write_len % r->offset_align != 0) {
+            write_len = (write_len / r->offset_align + 1) * r->offset_align;
+        }
+        ssize_t bytes_written = IO_TRACE(IO_OP_WRITE, write(r->fd_out, r->pool + (size_t)slot * r->slot_size, write_len));
+        r->st->write_calls++;
+        int ok = bytes_written == (ssize_t)write_len;
+        if (!ok) {
+            perror("Error de escritura incompleta en el servidor");
+        } else {
+            r->written += filled;
+            sampler_add(filled);
+        }
+
+        pthread_mutex_lock(&r->lock);
+        if (!ok) {
+            r->failed = 1;
+        }
+        r->tail = (r->tail + 1) % RECV_RING_SLOTS;
+        r->count--;
+        pthread_cond_signal(&r->not_full);
+        pthread_mutex_unlock(&r->lock);
+    }
+}
+
+long long recv_direct(int sock, int fd_out, long buffer_size, const struct dio_align *al,
+                      const struct recv_hook *hook, struct recv_stats *st) {
+    struct bounce_ring r = {
+        .slot_size = buffer_size,
+        .fd_out = fd_out,
+        .offset_align = al->offset_align,
+        .st = st,
+    };
+    void *pool;
+    int ret = posix_memalign(&pool, al->mem_align, (size_t)buffer_size * RECV_RING_SLOTS);
+    if (ret != 0) {
+        errno = ret;
+        perror("Error en posix_memalign");
+        return -1;
+    }
+    r.pool = pool;
+    pthread_mutex_init(&r.lock, NULL);
+    pthread_cond_init(&r.not_empty, NULL);
+    pthread_cond_init(&r.not_full, NULL);
+
+    pthread_t writer;
+    ret = pthread_create(&writer, NULL, ring_writer, &r);
+    if (ret != 0) {
+        errno = ret;
+        perror("Error al crear el hilo escritor");
+        free(pool);
+        return -1;
+    }
+
+    int failed = 0;
+    int eof = 0;
+    while (!eof && !failed) {
+        pthread_mutex_lock(&r.lock);
+        while (r.count == RECV_RING_SLOTS && !r.failed) {
+            pthread_cond_wait(&r.not_full, &r.lock);
+        }
+        failed = r.failed;
+        int slot = r.head;
+        pthread_mutex_unlock(&r.lock);
+        if (failed) {
+            break;
+        }
+
+        // Llenar el búfer completo antes de pasarlo al escritor
+        char *buffer = r.pool + (size_t)slot * buffer_size;
+        size_t filled = 0;
+        while (filled < (size_t)buffer_size) {
+            ssize_t n = IO_TRACE(IO_OP_RECV, recv(sock, buffer + filled, buffer_size - filled, MSG_WAITALL));
+            st->recv_calls++;
+            rearm(hook, sock);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                perror("Error en recv del servidor");
+                failed = 1;
+                break;
+            }
+            if (n == 0) {
+                eof = 1;
+                break;
+            }
+            filled += n;
+        }
+
+        pthread_mutex_lock(&r.lock);
+        if (failed) {
+            r.failed = 1;
+        } else if (filled > 0) {
+            r.filled[slot] = filled;
+            r.head = (r.head + 1) % RECV_RING_SLOTS;
+            r.count++;
+        }
+        r.eof = eof;
+        pthread_cond_signal(&r.not_empty);
+        pthread_mutex_unlock(&r.lock);
+    }
+
+    pthread_join(writer, NULL);
+    failed = failed || r.failed;
+    pthread_mutex_destroy(&r.lock);
+    pthread_cond_destroy(&r.not_empty);
+    pthread_cond_destroy(&r.not_full);
+    free(pool);
+    if (failed) {
+        return -1;
+    }
+
+    // Quitar el relleno del último bloque
+    if (ftruncate(fd_out, r.written) == -1) {
+        perror("Error en ftruncate");
+        return -1;
+    }
+    return r.written;
+}
@@ -0,0 +1,50 @@
+#ifndef RECV_PATHS_H
+#define RECV_PATHS_H
+
+#include "dio_align.h"
+
+/**
+ * recv_paths.h
+ *
+ * Caminos de recepción de una conexión hacia un archivo, comunes a
+ * tcp_server y unix_socket_server:
+ *  - recv_copy:        recv() a un búfer de usuario y write() desde él;
+ *  - recv_with_splice: splice() del socket a una tubería y de ésta al
+ *                      archivo, sin tocar la carga útil desde el usuario;
+ *  - recv_direct:      archivo abierto con O_DIRECT y un anillo de
+ *                      RECV_RING_SLOTS búferes alineados. El hilo llamante
+ *                      recibe en un búfer mientras un hilo escritor vuelca
+ *                      los ya llenos, así recv() y la escritura directa se
+ *                      solapan. Cada write() es de un búfer completo salvo
+ *                      el último, que se rellena hasta la alineación; al
+ *                      final el archivo se recorta a los bytes recibidos.
+ * La alineación de recv_direct es la del archivo de salida (ver
+ * dio_align.h) y buffer_size debe ser múltiplo de offset_align.
+ *
+ * Lo único que depende del tipo de socket va en el gancho rearm, llamado
+ * tras cada recv()/splice() del socket: tcp_server lo usa para rearmar
+ * TCP_QUICKACK. Todos devuelven los bytes recibidos o -1 si falló (ya
+ * informado por stderr) y suman los bytes en sampler_add().
+ */
+
+#define RECV_RING_SLOTS 4
+
+// Contadores de llamadas al sistema del bucle de recepción
+struct recv_stats {
+    long recv_calls;
+    long write_calls;
+    long splice_calls;
+};
+
+// Gancho por socket; rearm puede ser NULL
+struct recv_hook {
+    void (*rearm)(int sock, void *arg);
+    void *arg;
+};
+
+long long recv_copy(int sock, int fd_out, long buffer_size, const struct recv_hook *hook, struct recv_stats *st);
+long long recv_with_splice(int sock, int fd_out, long chunk, const struct recv_hook *hook, struct recv_stats *st);
+long long recv_direct(int sock, int fd_out, long buffer_size, const struct dio_align *al,
+                      const struct recv_hook *hook, struct recv_stats *st);
+
+#endif
@@ -0,0 +1,385 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <sys/sysmacros.h>
+#include <sys/utsname.h>
+
+#include "report.h"
+
+/**
+ * report.c
+ *
+ * Implementación de la salida JSON (ver report.h).
+ */
+
+#define REPORT_MAX_TAGS 32
+#define REPORT_MAX_PATHS 4
+
+static int json_stdout;
+static const char *json_out_path;
+static const char *tags[REPORT_MAX_TAGS];
+static int tag_count;
+static struct { const char *role; const char *path; } paths[REPORT_MAX_PATHS];
+static int path_count;
+
+static int argc_saved;
+static char **argv_saved;
+static time_t start_time;
+static pid_t start_pid;     // Los hijos creados con fork() no emiten nada
+static FILE *capture;       // Archivo temporal donde va stdout
+static int saved_stdout = -1;
+
+int report_parse_option(int opt, const char *arg) {
+    switch (opt) {
+        case REPORT_OPT_JSON:
+            json_stdout = 1;
+            return 1;
+        case REPORT_OPT_JSON_OUT:
+            json_out_path = arg;
+            return 1;
+        case REPORT_OPT_TAG:
+            if (strchr(arg, '=') == NULL || arg[0] == '=') {
+                fprintf(stderr, "Error: --tag espera clave=valor.\n");
+                return -1;
+            }
+            if (tag_count == REPORT_MAX_TAGS) {
+                fprintf(stderr, "Error: Demasiadas etiquetas --tag (máximo %d).\n", REPORT_MAX_TAGS);
+                return -1;
+            }
+            tags[tag_count++] = arg;
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+void report_path(const char *role, const char *path) {
+    if (path_count < REPORT_MAX_PATHS) {
+        paths[path_count].role = role;
+        paths[path_count].path = path;
+        path_count++;
+    }
+}
+
+int report_json_enabled(void) {
+    return json_stdout || json_out_path != NULL;
+}
+
+// --- Construcción del JSON ---
+
+struct buf {
+    char *data;
+    size_t len;
+    size_t cap;
+};
+
+static void buf_append(struct buf *b, const char *s, size_t n) {
+    if (b->len + n + 1 > b->cap) {
+        size_t cap = b->cap ? b->cap : 1024;
+        while (b->len + n + 1 > cap) cap *= 2;
+        char *data = realloc(b->data, cap);
+        if (data == NULL) return;
+        b->data = data;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+    b->data[b->len] = '\0';
+}
+
+static void buf_puts(struct buf *b, const char *s) {
+    buf_append(b, s, strlen(s));
+}
+
+static void buf_string(struct buf *b, const char *s, size_t n) {
+    buf_puts(b, "\"");
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = s[i];
+        char esc[8];
+        if (c == '"' || c == '\\') {
+            esc[0] = '\\';
+            esc[1] = c;
+            buf_append(b, esc, 2);
+        } else if (c < 0x20) {
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            buf_puts(b, esc);
+        } else {
+            buf_append(b, (const char *)&c, 1);
+        }
+    }
+    buf_puts(b, "\"");
+}
+
+// Comprueba la gramática de número de JSON (sin ceros a la izquierda, nan ni inf)
+static int is_json_number(const char *s, size_t n) {
+    size_t i = 0;
+    if (i < n && s[i] == '-') i++;
+    if (i == n) return 0;
+    if (s[i] == '0') {
+        i++;
+    } else if (s[i] >= '1' && s[i] <= '9') {
+        while (i < n && s[i] >= '0' && s[i] <= '9') i++;
+    } else {
+        return 0;
+    }
+    if (i < n && s[i] == '.') {
+        i++;
+        size_t digits = i;
+        while (i < n && s[i] >= '0' && s[i] <= '9') i++;
+        if (i == digits) return 0;
+    }
+    if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+        i++;
+        if (i < n && (s[i] == '+' || s[i] == '-')) i++;
+        size_t digits = i;
+        while (i < n && s[i] >= '0' && s[i] <= '9') i++;
+        if (i == digits) return 0;
+    }
+    return i == n;
+}
+
+static void buf_field(struct buf *b, const char *key, size_t key_len, const char *value, size_t value_len) {
+    if (b->len > 1) buf_puts(b, ",");
+    buf_string(b, key, key_len);
+    buf_puts(b, ":");
+    if (is_json_number(value, value_len)) {
+        buf_append(b, value, value_len);
+    } else {
+        buf_string(b, value, value_len);
+    }
+}
+
+static void buf_field_str(struct buf *b, const char *key, const char *value) {
+    buf_field(b, key, strlen(key), value, strlen(value));
+}
+
+static const char *fs_type_name(long type) {
+    switch ((unsigned long)type) {
+        case 0xEF53:     return "ext4";
+        case 0x58465342: return "xfs";
+        case 0x9123683E: return "btrfs";
+        case 0x01021994: return "tmpfs";
+        case 0x2FC12FC1: return "zfs";
+        case 0x6969:     return "nfs";
+        case 0x794C7630: return "overlayfs";
+        case 0xF2F52010: return "f2fs";
+        default:         return NULL;
+    }
+}
+
+// Fuente del montaje (p. ej. /dev/nvme0n1p2) del dispositivo dev, según /proc/self/mountinfo
+static int mount_source(dev_t dev, char *out, size_t len) {
+    FILE *f = fopen("/proc/self/mountinfo", "r");
+    if (f == NULL) return -1;
+    char line[4096];
+    int found = -1;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        unsigned int major_id, minor_id;
+        if (sscanf(line, "%*d %*d %u:%u", &major_id, &minor_id) != 2) continue;
+        if (major_id != major(dev) || minor_id != minor(dev)) continue;
+        // Campos tras el separador " - ": tipo fuente opciones
+        char *sep = strstr(line, " - ");
+        char source[1024];
+        if (sep != NULL && sscanf(sep + 3, "%*s %1023s", source) == 1) {
+            snprintf(out, len, "%s", source);
+            found = 0;
+            break;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+static void add_path_metadata(struct buf *b, const char *role, const char *path) {
+    char key[128], value[1100];
+    snprintf(key, sizeof(key), "%sPath", role);
+    buf_field_str(b, key, path);
+
+    // Si la ruta aún no existe (o ya se borró) se usa su directorio
+    char dir[4096];
+    snprintf(dir, sizeof(dir), "%s", path);
+    struct stat st;
+    struct statfs sfs;
+    while (stat(dir, &st) == -1) {
+        char *slash = strrchr(dir, '/');
+        if (slash == NULL) {
+            if (strcmp(dir, ".") == 0) return;
+            snprintf(dir, sizeof(dir), ".");
+        } else if (slash == dir) {
+            if (dir[1] == '\0') return;
+            dir[1] = '\0';
+        } else {
+            *slash = '\0';
+        }
+    }
+    if (statfs(dir, &sfs) == -1) return;
+
+    snprintf(key, sizeof(key), "%sFsType", role);
+    const char *name = fs_type_name(sfs.f_type);
+    if (name != NULL) {
+        snprintf(value, sizeof(value), "%s", name);
+    } else {
+        snprintf(value, sizeof(value), "0x%lx", (unsigned long)sfs.f_type);
+    }
+    buf_field_str(b, key, value);
+
+    snprintf(key, sizeof(key), "%sDevice", role);
+    if (mount_source(st.st_dev, value, sizeof(value)) == -1) {
+        snprintf(value, sizeof(value), "%u:%u", major(st.st_dev), minor(st.st_dev));
+    }
+    buf_field_str(b, key, value);
+}
+
+static void cpu_model(char *out, size_t len) {
+    snprintf(out, len, "unknown");
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    if (f == NULL) return;
+    char line[512];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (strncmp(line, "model name", 10) == 0) {
+            char *colon = strchr(line, ':');
+            if (colon != NULL) {
+                colon++;
+                while (*colon == ' ' || *colon == '\t') colon++;
+                colon[strcspn(colon, "\n")] = '\0';
+                snprintf(out, len, "%s", colon);
+            }
+            break;
+        }
+    }
+    fclose(f);
+}
+
+// Metadatos comunes a todos los bloques de esta ejecución
+static void add_metadata(struct buf *b) {
+    const char *slash = strrchr(argv_saved[0], '/');
+    buf_field_str(b, "Binary", slash ? slash + 1 : argv_saved[0]);
+
+    struct buf args = {0};
+    for (int i = 1; i < argc_saved; i++) {
+        if (i > 1) buf_puts(&args, " ");
+        buf_puts(&args, argv_saved[i]);
+    }
+    buf_field_str(b, "Args", args.data ? args.data : "");
+    free(args.data);
+
+    char value[512];
+    struct tm tm;
+    gmtime_r(&start_time, &tm);
+    strftime(value, sizeof(value), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    buf_field_str(b, "Timestamp", value);
+
+    struct utsname uts;
+    if (uname(&uts) == 0) {
+        buf_field_str(b, "Hostname", uts.nodename);
+        buf_field_str(b, "Kernel", uts.release);
+        buf_field_str(b, "Machine", uts.machine);
+    }
+    cpu_model(value, sizeof(value));
+    buf_field_str(b, "CpuModel", value);
+    snprintf(value, sizeof(value), "%ld", sysconf(_SC_NPROCESSORS_ONLN));
+    buf_field_str(b, "OnlineCpus", value);
+
+    for (int i = 0; i < path_count; i++) {
+        add_path_metadata(b, paths[i].role, paths[i].path);
+    }
+    for (int i = 0; i < tag_count; i++) {
+        const char *eq = strchr(tags[i], '=');
+        buf_field(b, tags[i], eq - tags[i], eq + 1, strlen(eq + 1));
+    }
+}
+
+// Escribe un objeto por bloque de text en fd
+static void emit_blocks(const char *text, int fd) {
+    struct buf meta = {0};
+    buf_puts(&meta, "{");
+    add_metadata(&meta);
+
+    const char *p = text;
+    while (*p) {
+        struct buf obj = {0};
+        buf_append(&obj, meta.data, meta.len);
+        int keys = 0;
+        // Hasta la siguiente línea en blanco
+        while (*p && *p != '\n') {
+            const char *eol = strchr(p, '\n');
+            size_t line_len = eol ? (size_t)(eol - p) : strlen(p);
+            const char *colon = memchr(p, ':', line_len);
+            if (colon != NULL && colon > p) {
+                const char *value = colon + 1;
+                while (value < p + line_len && *value == ' ') value++;
+                buf_field(&obj, p, colon - p, value, p + line_len - value);
+                keys++;
+            }
+            p += line_len;
+            if (*p == '\n') p++;
+        }
+        while (*p == '\n') p++;
+        buf_puts(&obj, "}\n");
+        if (keys > 0 && obj.data != NULL) {
+            ssize_t ignored = write(fd, obj.data, obj.len);
+            (void)ignored;
+        }
+        free(obj.data);
+    }
+    free(meta.data);
+}
+
+static void report_finish(void) {
+    if (capture == NULL || getpid() != start_pid) return;
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+
+    // Leer todo lo capturado
+    fseek(capture, 0, SEEK_END);
+    long size = ftell(capture);
+    rewind(capture);
+    char *text = malloc(size + 1);
+    if (text == NULL) return;
+    size_t got = fread(text, 1, size, capture);
+    text[got] = '\0';
+    fclose(capture);
+    capture = NULL;
+
+    if (json_stdout) {
+        emit_blocks(text, STDOUT_FILENO);
+    } else {
+        fwrite(text, 1, got, stdout);
+        fflush(stdout);
+    }
+    if (json_out_path != NULL) {
+        int fd = open(json_out_path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd == -1) {
+            perror("Error al abrir el archivo de --json-out");
+        } else {
+            emit_blocks(text, fd);
+            close(fd);
+        }
+    }
+    free(text);
+}
+
+void report_start(int argc, char *argv[]) {
+    argc_saved = argc;
+    argv_saved = argv;
+    start_time = time(NULL);
+    start_pid = getpid();
+    if (!report_json_enabled()) return;
+
+    fflush(stdout);
+    capture = tmpfile();
+    if (capture == NULL) {
+        perror("Error al crear el archivo temporal de resultados");
+        exit(EXIT_FAILURE);
+    }
+    saved_stdout = dup(STDOUT_FILENO);
+    dup2(fileno(capture), STDOUT_FILENO);
+    atexit(report_finish);
+}
@@ -0,0 +1,58 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <getopt.h>
+
+/**
+ * report.h
+ *
+ * Salida de resultados en JSON, común a todos los programas. Los programas
+ * siguen imprimiendo sus líneas Clave: valor con printf(); con --json o
+ * --json-out, report_start() redirige stdout a un archivo temporal y al
+ * salir (atexit) cada bloque de líneas (separados por una línea en blanco)
+ * se convierte en un objeto JSON de una sola línea (JSONL) con:
+ *  - los metadatos de la ejecución: Binary, Args, Timestamp, Hostname,
+ *    Kernel, Machine, CpuModel, OnlineCpus y, por cada ruta registrada con
+ *    report_path(), <Rol>Path, <Rol>FsType y <Rol>Device;
+ *  - las etiquetas --tag clave=valor (p. ej. los parámetros del barrido);
+ *  - todas las claves del bloque; los valores numéricos como números.
+ *
+ *  - --json: stdout lleva solo los objetos JSON.
+ *  - --json-out F: stdout no cambia y cada objeto se añade a F (O_APPEND,
+ *    una escritura por línea), de modo que un barrido acumula todas sus
+ *    ejecuciones en un único archivo.
+ *
+ * Uso: añadir REPORT_LONG_OPTIONS a la tabla de getopt_long, delegar en
+ * report_parse_option(), registrar las rutas de datos con report_path() y
+ * llamar a report_start() antes de imprimir resultados.
+ */
+
+// Códigos de getopt, fuera del rango de los de tcp_tuning.h, cache_state.h y write_layout.h
+enum {
+    REPORT_OPT_JSON = 0x400,
+    REPORT_OPT_JSON_OUT,
+    REPORT_OPT_TAG,
+};
+
+#define REPORT_LONG_OPTIONS \
+    {"json", no_argument, NULL, REPORT_OPT_JSON}, \
+    {"json-out", required_argument, NULL, REPORT_OPT_JSON_OUT}, \
+    {"tag", required_argument, NULL, REPORT_OPT_TAG}
+
+#define REPORT_USAGE "[--json] [--json-out F] [--tag clave=valor]"
+
+// Devuelve 1 si opt era una de estas opciones, 0 si no lo era y -1 si el
+// argumento no es válido (ya informado por stderr).
+int report_parse_option(int opt, const char *arg);
+
+// Registra una ruta cuyo sistema de archivos y dispositivo se informan
+// (role: "Input", "Output"...). Se consultan al emitir, cuando ya existe.
+void report_path(const char *role, const char *path);
+
+// Empieza a capturar stdout si se pidió JSON. No hace nada en otro caso.
+void report_start(int argc, char *argv[]);
+
+// Devuelve 1 si se pidió salida JSON
+int report_json_enabled(void);
+
+#endif
@@ -0,0 +1,177 @@
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "sampler.h"
+
+/**
+ * sampler.c
+ *
+ * Implementación del muestreo (ver sampler.h). Los hilos de copia solo
+ * suman al contador global y, para los parones, intercambian la marca de
+ * tiempo de la última llamada; el hilo de muestreo espera en una variable
+ * de condición con plazo absoluto (CLOCK_MONOTONIC), así el periodo no
+ * deriva y sampler_stop() no tiene que esperar a que venza el intervalo.
+ */
+
+struct sample {
+    uint64_t t_ns;      // Desde sampler_start()
+    uint64_t bytes;     // Acumulados hasta t_ns
+};
+
+static long interval_ms;
+static uint64_t start_ns;
+static uint64_t total_bytes;
+static uint64_t last_ns;            // Última llamada a sampler_add()
+static uint64_t max_stall_ns;
+static uint64_t max_stall_at_ns;    // Inicio del mayor parón, desde sampler_start()
+
+static struct sample *samples;
+static size_t sample_count, sample_cap;
+
+static pthread_t thread;
+static volatile int running;
+static int stop;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int sampler_parse_option(int opt, const char *arg) {
+    if (opt != SAMPLER_OPT_MS) return 0;
+    char *end;
+    interval_ms = strtol(arg, &end, 10);
+    if (*end != '\0' || interval_ms <= 0) {
+        fprintf(stderr, "Error: --sample-ms debe ser un número de milisegundos positivo.\n");
+        return -1;
+    }
+    return 1;
+}
+
+static void stall_check(uint64_t prev, uint64_t now) {
+    // Solo se toma el cerrojo cuando hay un parón mayor que el registrado
+    if (now - prev <= __atomic_load_n(&max_stall_ns, __ATOMIC_RELAXED)) return;
+    pthread_mutex_lock(&lock);
+    if (now - prev > max_stall_ns) {
+        __atomic_store_n(&max_stall_ns, now - prev, __ATOMIC_RELAXED);
+        max_stall_at_ns = prev - start_ns;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+void sampler_add(uint64_t bytes) {
+    if (!running) return;
+    __atomic_fetch_add(&total_bytes, bytes, __ATOMIC_RELAXED);
+    uint64_t now = now_ns();
+    uint64_t prev = __atomic_exchange_n(&last_ns, now, __ATOMIC_RELAXED);
+    // Con varios hilos prev puede ser posterior a now; eso no es un parón
+    if (now > prev) stall_check(prev, now);
+}
+
+static void record(uint64_t now) {
+    if (sample_count == sample_cap) {
+        size_t cap = sample_cap ? sample_cap * 2 : 256;
+        struct sample *s = realloc(samples, cap * sizeof(*s));
+        if (s == NULL) return;
+        samples = s;
+        sample_cap = cap;
+    }
+    samples[sample_count].t_ns = now - start_ns;
+    samples[sample_count].bytes = __atomic_load_n(&total_bytes, __ATOMIC_RELAXED);
+    sample_count++;
+}
+
+static void *sampler_main(void *arg) {
+    (void)arg;
+    uint64_t next = start_ns;
+    pthread_mutex_lock(&lock);
+    while (!stop) {
+        next += (uint64_t)interval_ms * 1000000ULL;
+        struct timespec deadline = { .tv_sec = next / 1000000000ULL, .tv_nsec = next % 1000000000ULL };
+        int rc = 0;
+        while (!stop && rc != ETIMEDOUT) rc = pthread_cond_timedwait(&wake, &lock, &deadline);
+        if (!stop) record(now_ns());
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+int sampler_start(void) {
+    if (interval_ms == 0) return 0;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&wake, &attr);
+    pthread_condattr_destroy(&attr);
+
+    sample_count = 0;
+    total_bytes = 0;
+    max_stall_ns = max_stall_at_ns = 0;
+    stop = 0;
+    start_ns = last_ns = now_ns();
+    if (pthread_create(&thread, NULL, sampler_main, NULL) != 0) {
+        perror("Error al crear el hilo de muestreo");
+        interval_ms = 0;
+        return -1;
+    }
+    running = 1;
+    return 0;
+}
+
+void sampler_stop(void) {
+    if (!running) return;
+    running = 0;
+    uint64_t now = now_ns();
+
+    pthread_mutex_lock(&lock);
+    stop = 1;
+    pthread_cond_signal(&wake);
+    pthread_mutex_unlock(&lock);
+    pthread_join(thread, NULL);
+
+    // Última muestra (intervalo incompleto) y el tramo final sin progreso,
+    // p. ej. el fsync() después de la última escritura
+    record(now);
+    stall_check(last_ns, now);
+}
+
+void sampler_print(void) {
+    if (interval_ms == 0) return;
+
+    printf("SampleIntervalMs: %ld\n", interval_ms);
+    printf("SampleCount: %zu\n", sample_count);
+
+    double sum = 0, sum_sq = 0, min = 0, max = 0;
+    size_t full = 0;
+    printf("SampleThroughputMBs: ");
+    for (size_t i = 0; i < sample_count; i++) {
+        uint64_t t0 = i ? samples[i - 1].t_ns : 0;
+        uint64_t b0 = i ? samples[i - 1].bytes : 0;
+        uint64_t dt = samples[i].t_ns - t0;
+        double mbs = dt ? (samples[i].bytes - b0) / (1024.0 * 1024.0) / (dt / 1e9) : 0.0;
+        printf("%s%.2f", i ? "," : "", mbs);
+        if (i + 1 == sample_count && sample_count > 1) continue;
+        if (full == 0 || mbs < min) min = mbs;
+        if (full == 0 || mbs > max) max = mbs;
+        sum += mbs;
+        sum_sq += mbs * mbs;
+        full++;
+    }
+    printf("\n");
+
+    double mean = full ? sum / full : 0.0;
+    double var = full ? sum_sq / full - mean * mean : 0.0;
+    printf("SampleThroughputMinMBs: %.2f\n", min);
+    printf("SampleThroughputMaxMBs: %.2f\n", max);
+    printf("SampleThroughputCvPct: %.2f\n", mean > 0 ? 100.0 * sqrt(var > 0 ? var : 0) / mean : 0.0);
+    printf("MaxStallMs: %.3f\n", max_stall_ns / 1e6);
+    printf("MaxStallAtMs: %.3f\n", max_stall_at_ns / 1e6);
+}
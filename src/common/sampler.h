@@ -0,0 +1,59 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <getopt.h>
+#include <stdint.h>
+
+/**
+ * sampler.h
+ *
+ * Serie temporal del rendimiento durante la transferencia. TimeTaken es un
+ * único número para todo el archivo y esconde lo que pasa por el camino: el
+ * arranque lento de TCP, los parones de writeback o el momento en que
+ * balance_dirty_pages() empieza a frenar al escritor en una copia de 1 GB.
+ *
+ * Con --sample-ms N un hilo anota cada N ms los bytes transferidos desde el
+ * inicio (el programa llama a sampler_add() donde ya suma sus bytes) y al
+ * final se informa:
+ *  - SampleIntervalMs, SampleCount y SampleThroughputMBs: la serie de MB/s
+ *    de cada intervalo, separada por comas;
+ *  - SampleThroughputMinMBs/MaxMBs y SampleThroughputCvPct (coeficiente de
+ *    variación de la serie; el último intervalo, incompleto, no cuenta);
+ *  - MaxStallMs y MaxStallAtMs: el mayor tiempo sin avanzar ni un byte
+ *    entre dos llamadas a sampler_add() y cuándo empezó, medidos con el
+ *    reloj en cada llamada y no con la resolución del muestreo.
+ * Sin --sample-ms no se crea el hilo y sampler_add() no hace nada.
+ *
+ * Uso: añadir SAMPLER_LONG_OPTIONS a la tabla de getopt_long, delegar en
+ * sampler_parse_option() y llamar a sampler_start()/sampler_stop() junto a
+ * io_trace_begin()/io_trace_end() y a sampler_print() con los resultados.
+ */
+
+// Códigos de getopt, fuera del rango de los de report.h
+enum {
+    SAMPLER_OPT_MS = 0x500,
+};
+
+#define SAMPLER_LONG_OPTIONS \
+    {"sample-ms", required_argument, NULL, SAMPLER_OPT_MS}
+
+#define SAMPLER_USAGE "[--sample-ms N]"
+
+// Devuelve 1 si opt era --sample-ms, 0 si no lo era y -1 si el argumento no
+// es válido (ya informado por stderr).
+int sampler_parse_option(int opt, const char *arg);
+
+// Inicio del intervalo medido: pone el contador a cero y arranca el hilo.
+// Devuelve 0, o -1 si no se pudo crear el hilo (muestreo desactivado).
+int sampler_start(void);
+
+// Suma bytes transferidos. Segura desde varios hilos.
+void sampler_add(uint64_t bytes);
+
+// Fin del intervalo medido: toma la última muestra y detiene el hilo
+void sampler_stop(void);
+
+// Imprime las claves Sample... y MaxStall... si se pidió --sample-ms
+void sampler_print(void);
+
+#endif
@@ -0,0 +1,294 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <linux/errqueue.h>
+
+#include "io_trace.h"
+#include "sampler.h"
+#include "send_paths.h"
+#include "stats.h"
+
+/**
+ * send_paths.c
+ *
+ * Implementación de los caminos de envío (ver send_paths.h).
+ */
+
+// Envío clásico: read() a un búfer de usuario y send() desde él. Cada bloque
+// se envía completo con send_all(); un error de lectura o de envío devuelve
+// -1 en lugar de los bytes enviados hasta entonces.
+long long send_copy(int sock, int fd_in, long buffer_size, struct send_stats *st) {
+    char *buffer = malloc(buffer_size);
+    if (buffer == NULL) {
+        perror("Error al asignar memoria para el buffer");
+        return -1;
+    }
+
+    long long total = 0;
+    for (;;) {
+        ssize_t bytes_read = IO_TRACE(IO_OP_READ, read(fd_in, buffer, buffer_size));
+        if (bytes_read == -1) {
+            if (errno == EINTR) continue;
+            perror("Error de lectura del archivo de entrada");
+            total = -1;
+            break;
+        }
+        if (bytes_read == 0) {
+            break;
+        }
+        st->read_calls++;
+        if (send_all(sock, buffer, bytes_read, st) == -1) {
+            perror("Error en send del cliente");
+            total = -1;
+            break;
+        }
+        total += bytes_read;
+        sampler_add(bytes_read);
+    }
+
+    free(buffer);
+    return total;
+}
+
+long long send_with_sendfile(int sock, int fd_in, off_t file_size, long chunk, struct send_stats *st) {
+    off_t offset = 0;
+    while (offset < file_size) {
+        size_t want = (file_size - offset < chunk) ? (size_t)(file_size - offset) : (size_t)chunk;
+        ssize_t sent = IO_TRACE(IO_OP_SENDFILE, sendfile(sock, fd_in, &offset, want));
+        st->sendfile_calls++;
+        if (sent == -1) {
+            if (errno == EINTR) continue;
+            perror("Error en sendfile del cliente");
+            return -1;
+        }
+        if (sent == 0) {
+            break;
+        }
+        sampler_add(sent);
+    }
+    return offset;
+}
+
+long long send_with_splice(int sock, int fd_in, off_t file_size, long chunk, struct send_stats *st) {
+    int pipefd[2];
+    if (pipe(pipefd) == -1) {
+        perror("Error al crear la tubería");
+        return -1;
+    }
+    long pipe_size = fcntl(pipefd[1], F_SETPIPE_SZ, chunk);
+    if (pipe_size == -1) {
+        pipe_size = fcntl(pipefd[1], F_GETPIPE_SZ);
+    }
+    if (chunk > pipe_size) {
+        chunk = pipe_size;
+    }
+
+    loff_t offset = 0;
+    long long total = -1;
+    while (offset < file_size) {
+        size_t want = (file_size - offset < chunk) ? (size_t)(file_size - offset) : (size_t)chunk;
+        ssize_t in_pipe = IO_TRACE(IO_OP_SPLICE, splice(fd_in, &offset, pipefd[1], NULL, want, SPLICE_F_MOVE | SPLICE_F_MORE));
+        st->splice_calls++;
+        if (in_pipe == -1) {
+            if (errno == EINTR) continue;
+            perror("Error en splice (archivo -> tubería)");
+            goto out;
+        }
+        if (in_pipe == 0) {
+            break;
+        }
+        while (in_pipe > 0) {
+            ssize_t out = IO_TRACE(IO_OP_SPLICE, splice(pipefd[0], NULL, sock, NULL, in_pipe, SPLICE_F_MOVE | SPLICE_F_MORE));
+            st->splice_calls++;
+            if (out == -1) {
+                if (errno == EINTR) continue;
+                perror("Error en splice (tubería -> socket)");
+                goto out;
+            }
+            in_pipe -= out;
+            sampler_add(out);
+        }
+    }
+    total = offset;
+
+out:
+    close(pipefd[0]);
+    close(pipefd[1]);
+    return total;
+}
+
+// Lee las notificaciones pendientes de MSG_ZEROCOPY. Si wait es distinto de
+// cero, bloquea hasta que llegue al menos una.
+static int drain_zerocopy_completions(int sock, int wait, struct send_stats *st) {
+    for (;;) {
+        if (wait) {
+            struct pollfd pfd = { .fd = sock, .events = 0 };
+            if (poll(&pfd, 1, -1) == -1 && errno != EINTR) {
+                perror("Error en poll");
+                return -1;
+            }
+        }
+
+        char control[128];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (recvmsg(sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
+            if (errno == EAGAIN || errno == EINTR) {
+                if (wait) continue;
+                return 0;
+            }
+            perror("Error al leer la cola de errores del socket");
+            return -1;
+        }
+
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm)) {
+            struct sock_extended_err *serr = (struct sock_extended_err *)CMSG_DATA(cm);
+            if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr->ee_errno != 0) {
+                continue;
+            }
+            // Cada notificación cubre el rango de envíos [ee_info, ee_data]
+            long n = (long)(serr->ee_data - serr->ee_info) + 1;
+            st->zc_completed += n;
+            if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                st->zc_copied += n;
+            }
+        }
+        wait = 0;
+    }
+}
+
+long long send_with_msg_zerocopy(int sock, int fd_in, off_t file_size, long chunk, struct send_stats *st) {
+    int one = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == -1) {
+        perror("MSG_ZEROCOPY no está soportado por este socket");
+        return -1;
+    }
+    if (file_size == 0) {
+        return 0;
+    }
+
+    // Las páginas del archivo no cambian mientras el kernel las referencia,
+    // por lo que se pueden enviar directamente desde la proyección.
+    char *data = mmap(NULL, file_size, PROT_READ, MAP_SHARED, fd_in, 0);
+    if (data == MAP_FAILED) {
+        perror("Error en mmap del archivo de entrada");
+        return -1;
+    }
+
+    off_t offset = 0;
+    long long total = -1;
+    while (offset < file_size) {
+        size_t want = (file_size - offset < chunk) ? (size_t)(file_size - offset) : (size_t)chunk;
+        ssize_t sent = IO_TRACE(IO_OP_SEND, send(sock, data + offset, want, MSG_ZEROCOPY));
+        if (sent == -1) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) {
+                // Límite de memoria de opciones alcanzado: liberar notificaciones
+                if (drain_zerocopy_completions(sock, st->zc_completed < st->send_calls, st) == -1) goto out;
+                continue;
+            }
+            perror("Error en send(MSG_ZEROCOPY) del cliente");
+            goto out;
+        }
+        st->send_calls++;
+        offset += sent;
+        sampler_add(sent);
+        if (drain_zerocopy_completions(sock, 0, st) == -1) goto out;
+    }
+
+    // No se puede liberar la proyección hasta que el kernel termine con ella
+    while (st->zc_completed < st->send_calls) {
+        if (drain_zerocopy_completions(sock, 1, st) == -1) goto out;
+    }
+    total = offset;
+
+out:
+    munmap(data, file_size);
+    return total;
+}
+
+// Envía len bytes completos (send() puede aceptar menos de lo pedido)
+int send_all(int sock, const void *buf, size_t len, struct send_stats *st) {
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t n = IO_TRACE(IO_OP_SEND, send(sock, p, len, 0));
+        st->send_calls++;
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+int send_run_connections(void *(*run)(void *), void *conns, size_t conn_size, long count) {
+    if (count == 1) {
+        run(conns);
+        return 0;
+    }
+
+    pthread_t *tids = calloc(count, sizeof(pthread_t));
+    if (tids == NULL) {
+        perror("Error al asignar memoria para los hilos");
+        return -1;
+    }
+    int ret = 0;
+    long started = 0;
+    for (long i = 0; i < count; i++) {
+        if (pthread_create(&tids[i], NULL, run, (char *)conns + i * conn_size) != 0) {
+            fprintf(stderr, "Error al crear el hilo de la conexión %ld\n", i);
+            ret = -1;
+            break;
+        }
+        started++;
+    }
+    for (long i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    free(tids);
+    return ret;
+}
+
+void send_stats_add(struct send_stats *dst, const struct send_stats *src) {
+    dst->read_calls += src->read_calls;
+    dst->send_calls += src->send_calls;
+    dst->sendfile_calls += src->sendfile_calls;
+    dst->splice_calls += src->splice_calls;
+    dst->zc_completed += src->zc_completed;
+    dst->zc_copied += src->zc_copied;
+}
+
+void send_stats_print(const struct send_stats *st, int msg_zerocopy) {
+    printf("ReadCalls: %ld\n", st->read_calls);
+    printf("SendCalls: %ld\n", st->send_calls);
+    printf("SendfileCalls: %ld\n", st->sendfile_calls);
+    printf("SpliceCalls: %ld\n", st->splice_calls);
+    if (msg_zerocopy) {
+        printf("ZeroCopyCompletions: %ld\n", st->zc_completed);
+        printf("ZeroCopyCopied: %ld\n", st->zc_copied);
+    }
+}
+
+void send_print_connections(double *latencies, long count, long long bytes, double wall_time) {
+    qsort(latencies, count, sizeof(double), compare_doubles);
+    printf("Connections: %ld\n", count);
+    printf("AggregateThroughputMBs: %.2f\n", wall_time > 0 ? bytes / (1024.0 * 1024.0) / wall_time : 0.0);
+    printf("ConnLatencyP50: %.6f\n", percentile(latencies, count, 50));
+    printf("ConnLatencyP90: %.6f\n", percentile(latencies, count, 90));
+    printf("ConnLatencyP99: %.6f\n", percentile(latencies, count, 99));
+    printf("ConnLatencyMax: %.6f\n", latencies[count - 1]);
+}
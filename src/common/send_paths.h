@@ -0,0 +1,62 @@
+#ifndef SEND_PATHS_H
+#define SEND_PATHS_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/**
+ * send_paths.h
+ *
+ * Caminos de envío de un archivo por un socket conectado, comunes a
+ * tcp_client y unix_socket_client, y el reparto de --connections M en hilos
+ * con la agregación de sus resultados. Cada cliente conserva su propia
+ * conexión (familia del socket, ajustes TCP, --stripes, fdpass) y elige
+ * aquí cómo se entregan los bytes:
+ *  - send_copy:              read() a un búfer de usuario y send() desde él;
+ *  - send_with_sendfile:     sendfile() del archivo al socket;
+ *  - send_with_splice:       splice() del archivo a una tubería y de ésta al socket;
+ *  - send_with_msg_zerocopy: send(MSG_ZEROCOPY) desde una proyección mmap del
+ *                            archivo (solo TCP/UDP); las notificaciones de
+ *                            finalización se leen de la cola de errores del
+ *                            socket antes de liberar la proyección.
+ * Todos devuelven los bytes enviados o -1 si falló (ya informado por stderr)
+ * y suman sus llamadas en struct send_stats y los bytes en sampler_add().
+ */
+
+// Contadores de llamadas al sistema del bucle de envío de una conexión
+struct send_stats {
+    long read_calls;
+    long send_calls;
+    long sendfile_calls;
+    long splice_calls;
+    // Notificaciones de MSG_ZEROCOPY (completadas y las que el kernel copió)
+    long zc_completed;
+    long zc_copied;
+};
+
+long long send_copy(int sock, int fd_in, long buffer_size, struct send_stats *st);
+long long send_with_sendfile(int sock, int fd_in, off_t file_size, long chunk, struct send_stats *st);
+long long send_with_splice(int sock, int fd_in, off_t file_size, long chunk, struct send_stats *st);
+long long send_with_msg_zerocopy(int sock, int fd_in, off_t file_size, long chunk, struct send_stats *st);
+
+// Envía len bytes completos (send() puede aceptar menos de lo pedido).
+// Devuelve 0, o -1 con errno si falló.
+int send_all(int sock, const void *buf, size_t len, struct send_stats *st);
+
+// Ejecuta run() sobre cada uno de los count elementos de conns (de
+// conn_size bytes), en un hilo por elemento; con count == 1, en el propio
+// hilo. Devuelve 0, o -1 si no se pudo crear algún hilo (los creados se
+// esperan igualmente).
+int send_run_connections(void *(*run)(void *), void *conns, size_t conn_size, long count);
+
+void send_stats_add(struct send_stats *dst, const struct send_stats *src);
+
+// Imprime ReadCalls, SendCalls, SendfileCalls, SpliceCalls y, con
+// msg_zerocopy, ZeroCopyCompletions y ZeroCopyCopied
+void send_stats_print(const struct send_stats *st, int msg_zerocopy);
+
+// Imprime Connections, AggregateThroughputMBs y los percentiles de la
+// duración de cada conexión. Ordena latencies.
+void send_print_connections(double *latencies, long count, long long bytes, double wall_time);
+
+#endif
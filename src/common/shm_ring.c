@@ -0,0 +1,272 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "shm_ring.h"
+
+/**
+ * shm_ring.c
+ *
+ * Implementación del anillo en memoria compartida (ver shm_ring.h). Los
+ * futex no son FUTEX_PRIVATE porque la palabra está en un segmento
+ * compartido entre procesos.
+ */
+
+// shm_open exige un nombre con '/' inicial y sin más barras; se añade la
+// inicial si falta para aceptar el mismo estilo de argumento que un socket.
+static int ring_name(const char *name, char *out, size_t out_len) {
+    const char *base = (name[0] == '/') ? name + 1 : name;
+    if (*base == '\0' || strchr(base, '/') != NULL || strlen(base) + 2 > out_len) {
+        fprintf(stderr, "Error: Nombre de memoria compartida inválido '%s' (formato /nombre).\n", name);
+        return -1;
+    }
+    snprintf(out, out_len, "/%s", base);
+    return 0;
+}
+
+// Espera como mucho SHM_RING_LIVENESS_MS. EAGAIN (el valor ya cambió), EINTR
+// y ETIMEDOUT se tratan igual: volver a comprobar
+static void futex_wait(uint32_t *addr, uint32_t expected) {
+    struct timespec timeout = {
+        .tv_sec = SHM_RING_LIVENESS_MS / 1000,
+        .tv_nsec = (SHM_RING_LIVENESS_MS % 1000) * 1000000L,
+    };
+    syscall(SYS_futex, addr, FUTEX_WAIT, expected, &timeout, NULL, 0);
+}
+
+static void futex_wake(uint32_t *addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+// Comprueba tras despertar si el anillo se abortó o el otro lado murió sin
+// marcarlo; en el segundo caso lo marca para que la comprobación sea única.
+static int peer_gone(struct shm_ring *r, int32_t pid, const char *who) {
+    if (__atomic_load_n(&r->aborted, __ATOMIC_ACQUIRE)) {
+        return 1;
+    }
+    if (pid > 0 && kill(pid, 0) == -1 && errno == ESRCH) {
+        fprintf(stderr, "Error: El %s terminó sin cerrar el anillo.\n", who);
+        __atomic_store_n(&r->aborted, 1, __ATOMIC_RELEASE);
+        return 1;
+    }
+    return 0;
+}
+
+// Avisa al otro lado tras incrementar seq, solo si anunció que iba a dormir
+static void notify(uint32_t *seq, uint32_t *waiting, struct shm_ring_stats *st) {
+    __atomic_fetch_add(seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(waiting, __ATOMIC_SEQ_CST) &&
+        __atomic_exchange_n(waiting, 0, __ATOMIC_SEQ_CST)) {
+        futex_wake(seq);
+        st->futex_wakes++;
+    }
+}
+
+struct shm_ring *shm_ring_create(const char *name, uint64_t capacity, size_t *map_len) {
+    char path[NAME_MAX];
+    if (ring_name(name, path, sizeof(path)) == -1) {
+        return NULL;
+    }
+
+    shm_unlink(path); // Restos de una ejecución anterior
+    int fd = shm_open(path, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1) {
+        perror("Error en shm_open");
+        return NULL;
+    }
+    size_t len = sizeof(struct shm_ring) + capacity;
+    if (ftruncate(fd, len) == -1) {
+        perror("Error en ftruncate del segmento compartido");
+        close(fd);
+        shm_unlink(path);
+        return NULL;
+    }
+    // MAP_POPULATE: los fallos de página del segmento no cuentan en la transferencia
+    struct shm_ring *r = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (r == MAP_FAILED) {
+        perror("Error en mmap del segmento compartido");
+        shm_unlink(path);
+        return NULL;
+    }
+
+    r->capacity = capacity;
+    r->consumer_pid = getpid();
+    r->state = SHM_RING_READY;
+    // La firma se publica la última: un cliente que la ve encuentra el resto inicializado
+    __atomic_store_n(&r->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+    *map_len = len;
+    return r;
+}
+
+struct shm_ring *shm_ring_attach(const char *name, size_t *map_len) {
+    char path[NAME_MAX];
+    if (ring_name(name, path, sizeof(path)) == -1) {
+        return NULL;
+    }
+
+    int fd = shm_open(path, O_RDWR, 0);
+    if (fd == -1) {
+        perror("Error al abrir la memoria compartida del servidor");
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(struct shm_ring)) {
+        fprintf(stderr, "Error: El segmento '%s' no es un anillo válido.\n", path);
+        close(fd);
+        return NULL;
+    }
+    size_t len = st.st_size;
+    struct shm_ring *r = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (r == MAP_FAILED) {
+        perror("Error en mmap del segmento compartido");
+        return NULL;
+    }
+
+    if (__atomic_load_n(&r->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC ||
+        sizeof(struct shm_ring) + r->capacity > len) {
+        fprintf(stderr, "Error: El segmento '%s' no es un anillo válido.\n", path);
+        munmap(r, len);
+        return NULL;
+    }
+    uint32_t expected = SHM_RING_READY;
+    if (!__atomic_compare_exchange_n(&r->state, &expected, SHM_RING_CONNECTED, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        fprintf(stderr, "Error: El servidor ya tiene un cliente conectado.\n");
+        munmap(r, len);
+        return NULL;
+    }
+    // Antes de despertar al servidor, que lo lee al volver de shm_ring_wait_client
+    __atomic_store_n(&r->producer_pid, (int32_t)getpid(), __ATOMIC_RELEASE);
+    futex_wake(&r->state);
+    *map_len = len;
+    return r;
+}
+
+void shm_ring_wait_client(struct shm_ring *r) {
+    while (__atomic_load_n(&r->state, __ATOMIC_ACQUIRE) == SHM_RING_READY) {
+        futex_wait(&r->state, SHM_RING_READY);
+    }
+}
+
+void shm_ring_unmap(struct shm_ring *r, size_t map_len) {
+    munmap(r, map_len);
+}
+
+int shm_ring_unlink(const char *name) {
+    char path[NAME_MAX];
+    if (ring_name(name, path, sizeof(path)) == -1) {
+        return -1;
+    }
+    return shm_unlink(path);
+}
+
+char *shm_ring_reserve(struct shm_ring *r, size_t max, size_t *len, struct shm_ring_stats *st) {
+    uint64_t head = r->head; // Solo lo escribe el productor
+    for (;;) {
+        if (__atomic_load_n(&r->aborted, __ATOMIC_ACQUIRE)) {
+            *len = 0;
+            return NULL;
+        }
+        uint32_t seq = __atomic_load_n(&r->space_seq, __ATOMIC_ACQUIRE);
+        uint64_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+        if (head - tail < r->capacity) {
+            uint64_t pos = head % r->capacity;
+            uint64_t avail = r->capacity - (head - tail);
+            if (avail > r->capacity - pos) avail = r->capacity - pos; // Hasta el final del área
+            *len = avail < max ? avail : max;
+            return r->data + pos;
+        }
+        if (peer_gone(r, r->consumer_pid, "servidor")) {
+            *len = 0;
+            return NULL;
+        }
+        // Lleno: anunciar la espera y comprobar otra vez antes de dormir
+        __atomic_store_n(&r->producer_waiting, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&r->tail, __ATOMIC_SEQ_CST) != tail ||
+            __atomic_load_n(&r->aborted, __ATOMIC_SEQ_CST)) {
+            continue;
+        }
+        futex_wait(&r->space_seq, seq);
+        st->futex_waits++;
+    }
+}
+
+void shm_ring_publish(struct shm_ring *r, size_t n, struct shm_ring_stats *st) {
+    __atomic_store_n(&r->head, r->head + n, __ATOMIC_RELEASE);
+    notify(&r->data_seq, &r->consumer_waiting, st);
+}
+
+void shm_ring_close(struct shm_ring *r, struct shm_ring_stats *st) {
+    __atomic_store_n(&r->eof, 1, __ATOMIC_RELEASE);
+    notify(&r->data_seq, &r->consumer_waiting, st);
+}
+
+char *shm_ring_peek(struct shm_ring *r, size_t max, size_t *len, struct shm_ring_stats *st) {
+    uint64_t tail = r->tail; // Solo lo escribe el consumidor
+    for (;;) {
+        if (__atomic_load_n(&r->aborted, __ATOMIC_ACQUIRE)) {
+            *len = 0;
+            return NULL;
+        }
+        uint32_t seq = __atomic_load_n(&r->data_seq, __ATOMIC_ACQUIRE);
+        // eof antes que head: si el productor ya cerró, head es el definitivo
+        uint32_t eof = __atomic_load_n(&r->eof, __ATOMIC_ACQUIRE);
+        uint64_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        if (head != tail) {
+            uint64_t pos = tail % r->capacity;
+            uint64_t avail = head - tail;
+            if (avail > r->capacity - pos) avail = r->capacity - pos;
+            *len = avail < max ? avail : max;
+            return r->data + pos;
+        }
+        if (eof) {
+            *len = 0;
+            return NULL;
+        }
+        if (peer_gone(r, __atomic_load_n(&r->producer_pid, __ATOMIC_ACQUIRE), "cliente")) {
+            *len = 0;
+            return NULL;
+        }
+        // Vacío: anunciar la espera y comprobar otra vez antes de dormir
+        __atomic_store_n(&r->consumer_waiting, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&r->head, __ATOMIC_SEQ_CST) != tail ||
+            __atomic_load_n(&r->eof, __ATOMIC_SEQ_CST) ||
+            __atomic_load_n(&r->aborted, __ATOMIC_SEQ_CST)) {
+            continue;
+        }
+        futex_wait(&r->data_seq, seq);
+        st->futex_waits++;
+    }
+}
+
+void shm_ring_consume(struct shm_ring *r, size_t n, struct shm_ring_stats *st) {
+    __atomic_store_n(&r->tail, r->tail + n, __ATOMIC_RELEASE);
+    notify(&r->space_seq, &r->producer_waiting, st);
+}
+
+void shm_ring_abort(struct shm_ring *r, struct shm_ring_stats *st) {
+    __atomic_store_n(&r->aborted, 1, __ATOMIC_RELEASE);
+    // No se sabe en qué palabra duerme el otro lado: se despiertan las dos
+    __atomic_fetch_add(&r->data_seq, 1, __ATOMIC_SEQ_CST);
+    __atomic_fetch_add(&r->space_seq, 1, __ATOMIC_SEQ_CST);
+    futex_wake(&r->data_seq);
+    futex_wake(&r->space_seq);
+    st->futex_wakes += 2;
+}
+
+int shm_ring_aborted(const struct shm_ring *r) {
+    return __atomic_load_n(&r->aborted, __ATOMIC_ACQUIRE) != 0;
+}
@@ -0,0 +1,92 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * shm_ring.h
+ *
+ * Anillo de bytes de un productor y un consumidor (SPSC) sobre un segmento
+ * POSIX de memoria compartida (shm_open), usado por shm_ring_server y
+ * shm_ring_client. head y tail son contadores monótonos de bytes escritos y
+ * consumidos; cada lado solo escribe el suyo, así que no hacen falta
+ * cerrojos. Cuando un lado no puede avanzar duerme con FUTEX_WAIT sobre un
+ * contador de secuencia que el otro incrementa tras publicar, y solo se
+ * llama a FUTEX_WAKE si el otro lado anunció que iba a dormir.
+ *
+ * Si un lado falla marca el anillo como abortado (shm_ring_abort) y
+ * despierta al otro, que deja de esperar. Para el caso en que el otro
+ * proceso muere sin marcarlo, las esperas duran como mucho
+ * SHM_RING_LIVENESS_MS y tras cada una se comprueba que el otro lado sigue
+ * vivo con kill(pid, 0).
+ *
+ * El servidor crea el segmento (consumidor) y el cliente se conecta a él
+ * (productor); los datos se copian directamente entre el archivo y el anillo,
+ * sin búfer intermedio, con lo que cada byte se copia una vez por lado.
+ */
+
+#define SHM_RING_MAGIC 0x53484d52u // "SHMR"
+
+// Estados del segmento
+enum { SHM_RING_INIT = 0, SHM_RING_READY, SHM_RING_CONNECTED };
+
+#define SHM_RING_CACHELINE 64
+#define SHM_RING_LIVENESS_MS 1000
+
+struct shm_ring {
+    uint32_t magic;
+    uint32_t state;                 // Palabra futex: el servidor espera al cliente
+    uint64_t capacity;              // Bytes del área de datos
+    int32_t consumer_pid;           // Servidor, para comprobar que sigue vivo
+    int32_t producer_pid;           // Cliente, fijado al conectarse
+    uint32_t aborted;               // Algún lado falló: el otro deja de esperar
+
+    // Lado del productor: separado del consumidor para no compartir línea de caché
+    uint64_t head __attribute__((aligned(SHM_RING_CACHELINE)));
+    uint32_t data_seq;              // Palabra futex: se incrementa al publicar datos o EOF
+    uint32_t consumer_waiting;
+    uint32_t eof;
+
+    uint64_t tail __attribute__((aligned(SHM_RING_CACHELINE)));
+    uint32_t space_seq;             // Palabra futex: se incrementa al liberar espacio
+    uint32_t producer_waiting;
+
+    char data[] __attribute__((aligned(SHM_RING_CACHELINE)));
+};
+
+// Contadores de esperas y despertares de un lado del anillo
+struct shm_ring_stats {
+    long futex_waits;
+    long futex_wakes;
+};
+
+// Crea el segmento (borrando uno anterior con el mismo nombre) y lo deja listo
+// para que se conecte un cliente. Devuelve NULL si hay error.
+struct shm_ring *shm_ring_create(const char *name, uint64_t capacity, size_t *map_len);
+// Se conecta a un segmento existente; falla si ya tiene cliente.
+struct shm_ring *shm_ring_attach(const char *name, size_t *map_len);
+// Bloquea al servidor hasta que se conecte un cliente
+void shm_ring_wait_client(struct shm_ring *r);
+void shm_ring_unmap(struct shm_ring *r, size_t map_len);
+int shm_ring_unlink(const char *name);
+
+// Productor: devuelve un puntero al espacio libre contiguo (hasta max bytes,
+// al menos 1) en *len, esperando si el anillo está lleno. NULL si el anillo
+// se abortó o el servidor terminó.
+char *shm_ring_reserve(struct shm_ring *r, size_t max, size_t *len, struct shm_ring_stats *st);
+void shm_ring_publish(struct shm_ring *r, size_t n, struct shm_ring_stats *st);
+void shm_ring_close(struct shm_ring *r, struct shm_ring_stats *st);
+
+// Consumidor: devuelve un puntero a los datos contiguos disponibles (hasta
+// max bytes) en *len, esperando si está vacío. *len = 0 indica EOF; NULL con
+// *len = 0 y shm_ring_aborted() indica que el anillo se abortó o el cliente
+// terminó sin cerrarlo.
+char *shm_ring_peek(struct shm_ring *r, size_t max, size_t *len, struct shm_ring_stats *st);
+void shm_ring_consume(struct shm_ring *r, size_t n, struct shm_ring_stats *st);
+
+// Cualquier lado: marca el anillo como abortado y despierta al otro
+void shm_ring_abort(struct shm_ring *r, struct shm_ring_stats *st);
+int shm_ring_aborted(const struct shm_ring *r);
+
+#endif
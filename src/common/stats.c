@@ -0,0 +1,31 @@
+#include <math.h>
+
+#include "stats.h"
+
+/**
+ * stats.c
+ *
+ * Implementación de los percentiles (ver stats.h).
+ */
+
+int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+double percentile(const double *sorted, size_t n, double p) {
+    if (n == 0) return 0.0;
+    // ceil(p/100 * n); el margen absorbe el error de redondeo de p/100
+    size_t rank = (size_t)ceil(p / 100.0 * n - 1e-9);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return sorted[rank - 1];
+}
+
+double percentile_interp(const double *sorted, size_t n, double p) {
+    if (n == 0) return 0.0;
+    double pos = (n - 1) * p / 100.0;
+    size_t i = (size_t)pos;
+    if (i + 1 >= n) return sorted[n - 1];
+    return sorted[i] + (pos - i) * (sorted[i + 1] - sorted[i]);
+}
@@ -0,0 +1,26 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stddef.h>
+
+/**
+ * stats.h
+ *
+ * Percentiles sobre muestras guardadas en un arreglo de double (duración de
+ * cada conexión, rendimiento de cada repetición). Se ordena con
+ * qsort(..., compare_doubles) y se consulta el arreglo ordenado. Para
+ * latencias en nanosegundos sin guardar cada muestra, ver histogram.h.
+ */
+
+// Comparador de double para qsort(), en orden ascendente
+int compare_doubles(const void *a, const void *b);
+
+// Percentil p (0-100) por rango más cercano, la muestra de rango ceil(p/100 * n):
+// siempre una muestra real. 0 si n == 0.
+double percentile(const double *sorted, size_t n, double p);
+
+// Percentil p (0-100) con interpolación lineal entre las dos muestras vecinas
+// (la mediana de un número par de muestras es la media de las centrales). 0 si n == 0.
+double percentile_interp(const double *sorted, size_t n, double p);
+
+#endif
@@ -0,0 +1,120 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "tcp_tuning.h"
+
+/**
+ * tcp_tuning.c
+ *
+ * Implementación de las opciones de ajuste TCP (ver tcp_tuning.h).
+ */
+
+// Convierte un tamaño positivo; devuelve -1 si no es válido
+static int parse_size(const char *name, const char *arg) {
+    char *end;
+    long v = strtol(arg, &end, 10);
+    if (*arg == '\0' || *end != '\0' || v <= 0 || v > 0x7fffffff) {
+        fprintf(stderr, "Error: --%s debe ser un entero positivo.\n", name);
+        return -1;
+    }
+    return (int)v;
+}
+
+int tcp_tuning_parse_option(int opt, const char *arg, struct tcp_tuning *t) {
+    switch (opt) {
+        case TCP_OPT_SNDBUF:
+            if ((t->sndbuf = parse_size("sndbuf", arg)) == -1) return -1;
+            return 1;
+        case TCP_OPT_RCVBUF:
+            if ((t->rcvbuf = parse_size("rcvbuf", arg)) == -1) return -1;
+            return 1;
+        case TCP_OPT_NOTSENT_LOWAT:
+            if ((t->notsent_lowat = parse_size("notsent-lowat", arg)) == -1) return -1;
+            return 1;
+        case TCP_OPT_NODELAY:  t->nodelay = 1; return 1;
+        case TCP_OPT_CORK:     t->cork = 1; return 1;
+        case TCP_OPT_QUICKACK: t->quickack = 1; return 1;
+        case TCP_OPT_CONGESTION:
+            t->congestion = arg;
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int set_int(int sock, int level, int name, int value, const char *label) {
+    if (setsockopt(sock, level, name, &value, sizeof(value)) == -1) {
+        perror(label);
+        return -1;
+    }
+    return 0;
+}
+
+int tcp_tuning_apply(int sock, const struct tcp_tuning *t) {
+    // Los tamaños de búfer deben fijarse antes de connect()/listen() para que
+    // la ventana anunciada y el factor de escala se negocien con ellos.
+    if (t->sndbuf > 0 && set_int(sock, SOL_SOCKET, SO_SNDBUF, t->sndbuf, "setsockopt(SO_SNDBUF)") == -1) return -1;
+    if (t->rcvbuf > 0 && set_int(sock, SOL_SOCKET, SO_RCVBUF, t->rcvbuf, "setsockopt(SO_RCVBUF)") == -1) return -1;
+    if (t->nodelay && set_int(sock, IPPROTO_TCP, TCP_NODELAY, 1, "setsockopt(TCP_NODELAY)") == -1) return -1;
+    if (t->cork && set_int(sock, IPPROTO_TCP, TCP_CORK, 1, "setsockopt(TCP_CORK)") == -1) return -1;
+    if (t->notsent_lowat > 0 &&
+        set_int(sock, IPPROTO_TCP, TCP_NOTSENT_LOWAT, t->notsent_lowat, "setsockopt(TCP_NOTSENT_LOWAT)") == -1) return -1;
+    if (t->quickack && set_int(sock, IPPROTO_TCP, TCP_QUICKACK, 1, "setsockopt(TCP_QUICKACK)") == -1) return -1;
+    if (t->congestion != NULL &&
+        setsockopt(sock, IPPROTO_TCP, TCP_CONGESTION, t->congestion, strlen(t->congestion)) == -1) {
+        perror("setsockopt(TCP_CONGESTION)");
+        return -1;
+    }
+    return 0;
+}
+
+void tcp_tuning_rearm_quickack(int sock, const struct tcp_tuning *t) {
+    if (t->quickack) {
+        int one = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+    }
+}
+
+static int get_int(int sock, int level, int name) {
+    int value = -1;
+    socklen_t len = sizeof(value);
+    if (getsockopt(sock, level, name, &value, &len) == -1) {
+        return -1;
+    }
+    return value;
+}
+
+void tcp_tuning_read(int sock, struct tcp_effective *eff) {
+    memset(eff, 0, sizeof(*eff));
+    eff->sndbuf = get_int(sock, SOL_SOCKET, SO_SNDBUF);
+    eff->rcvbuf = get_int(sock, SOL_SOCKET, SO_RCVBUF);
+    eff->nodelay = get_int(sock, IPPROTO_TCP, TCP_NODELAY);
+    eff->cork = get_int(sock, IPPROTO_TCP, TCP_CORK);
+    eff->notsent_lowat = get_int(sock, IPPROTO_TCP, TCP_NOTSENT_LOWAT);
+    eff->quickack = get_int(sock, IPPROTO_TCP, TCP_QUICKACK);
+    socklen_t len = sizeof(eff->congestion);
+    if (getsockopt(sock, IPPROTO_TCP, TCP_CONGESTION, eff->congestion, &len) == -1) {
+        strcpy(eff->congestion, "unknown");
+    }
+    eff->congestion[sizeof(eff->congestion) - 1] = '\0';
+    eff->valid = 1;
+}
+
+void tcp_tuning_print(const struct tcp_effective *eff) {
+    if (!eff->valid) {
+        return;
+    }
+    printf("SockSndBuf: %d\n", eff->sndbuf);
+    printf("SockRcvBuf: %d\n", eff->rcvbuf);
+    printf("TcpNoDelay: %d\n", eff->nodelay);
+    printf("TcpCork: %d\n", eff->cork);
+    // 0 o UINT_MAX (-1 como int) significan "sin límite"
+    printf("TcpNotSentLowat: %d\n", eff->notsent_lowat);
+    printf("TcpQuickAck: %d\n", eff->quickack);
+    printf("TcpCongestion: %s\n", eff->congestion);
+}
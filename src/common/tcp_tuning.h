@@ -0,0 +1,77 @@
+#ifndef TCP_TUNING_H
+#define TCP_TUNING_H
+
+#include <getopt.h>
+
+/**
+ * tcp_tuning.h
+ *
+ * Opciones de ajuste de sockets TCP compartidas por tcp_server y tcp_client.
+ * Cada programa añade TCP_TUNING_LONG_OPTIONS a su tabla de getopt_long y
+ * delega en tcp_tuning_parse_option() los códigos que no reconoce. Los
+ * valores efectivos se leen de vuelta con getsockopt() (el kernel puede
+ * duplicar o recortar lo pedido) y se imprimen con el formato Clave: valor
+ * que consumen los parsers.
+ */
+
+// Códigos de getopt fuera del rango de los caracteres imprimibles
+enum {
+    TCP_OPT_SNDBUF = 0x100,
+    TCP_OPT_RCVBUF,
+    TCP_OPT_NODELAY,
+    TCP_OPT_CORK,
+    TCP_OPT_NOTSENT_LOWAT,
+    TCP_OPT_QUICKACK,
+    TCP_OPT_CONGESTION,
+};
+
+#define TCP_TUNING_LONG_OPTIONS \
+    {"sndbuf", required_argument, NULL, TCP_OPT_SNDBUF}, \
+    {"rcvbuf", required_argument, NULL, TCP_OPT_RCVBUF}, \
+    {"nodelay", no_argument, NULL, TCP_OPT_NODELAY}, \
+    {"cork", no_argument, NULL, TCP_OPT_CORK}, \
+    {"notsent-lowat", required_argument, NULL, TCP_OPT_NOTSENT_LOWAT}, \
+    {"quickack", no_argument, NULL, TCP_OPT_QUICKACK}, \
+    {"cc", required_argument, NULL, TCP_OPT_CONGESTION}
+
+#define TCP_TUNING_USAGE \
+    "[--sndbuf N] [--rcvbuf N] [--nodelay] [--cork] [--notsent-lowat N] [--quickack] [--cc ALG]"
+
+// Ajustes pedidos en la línea de comandos. 0/NULL = valor por defecto del kernel.
+struct tcp_tuning {
+    int sndbuf;
+    int rcvbuf;
+    int nodelay;
+    int cork;
+    int notsent_lowat;
+    int quickack;
+    const char *congestion;
+};
+
+// Valores efectivos leídos con getsockopt()
+struct tcp_effective {
+    int valid;
+    int sndbuf;
+    int rcvbuf;
+    int nodelay;
+    int cork;
+    int notsent_lowat;
+    int quickack;
+    char congestion[16];
+};
+
+// Devuelve 1 si opt era una opción de ajuste, 0 si no lo era y -1 si el
+// argumento no es válido (ya informado por stderr).
+int tcp_tuning_parse_option(int opt, const char *arg, struct tcp_tuning *t);
+
+// Aplica los ajustes pedidos a un socket TCP. Devuelve 0 o -1 (con perror).
+int tcp_tuning_apply(int sock, const struct tcp_tuning *t);
+
+// TCP_QUICKACK no es permanente: el kernel lo desactiva tras algunos ACK,
+// por lo que los bucles de recepción lo vuelven a activar tras cada recv().
+void tcp_tuning_rearm_quickack(int sock, const struct tcp_tuning *t);
+
+void tcp_tuning_read(int sock, struct tcp_effective *eff);
+void tcp_tuning_print(const struct tcp_effective *eff);
+
+#endif
@@ -0,0 +1,197 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
+
+#include "write_layout.h"
+
+/**
+ * write_layout.c
+ *
+ * Implementación de --prealloc/--fsync y del recuento de extents (ver
+ * write_layout.h).
+ */
+
+#define DEFAULT_SFR_PERIOD (8LL * 1024 * 1024)
+
+static const char *prealloc_names[] = { "none", "fallocate", "keep-size" };
+static const char *flush_names[] = { "none", "end", "periodic", "fdatasync", "sync_file_range" };
+
+// Convierte el N de "modo:N"; devuelve -1 si no es un entero positivo
+static long long parse_period(const char *arg) {
+    char *end;
+    long long v = strtoll(arg, &end, 10);
+    if (*arg == '\0' || *end != '\0' || v <= 0) {
+        fprintf(stderr, "Error: El periodo de --fsync debe ser un entero positivo de bytes.\n");
+        return -1;
+    }
+    return v;
+}
+
+int write_layout_parse_option(int opt, const char *arg, struct write_layout *wl) {
+    switch (opt) {
+        case WRITE_OPT_PREALLOC:
+            if (strcmp(arg, "none") == 0) {
+                wl->prealloc = PREALLOC_NONE;
+            } else if (strcmp(arg, "fallocate") == 0) {
+                wl->prealloc = PREALLOC_FALLOCATE;
+            } else if (strcmp(arg, "keep-size") == 0) {
+                wl->prealloc = PREALLOC_KEEP_SIZE;
+            } else {
+                fprintf(stderr, "Error: Modo de --prealloc desconocido '%s'.\n", arg);
+                return -1;
+            }
+            return 1;
+        case WRITE_OPT_FSYNC:
+            wl->period = 0;
+            if (strcmp(arg, "end") == 0) {
+                wl->flush = FLUSH_END;
+            } else if (strncmp(arg, "periodic:", 9) == 0) {
+                wl->flush = FLUSH_PERIODIC;
+                if ((wl->period = parse_period(arg + 9)) == -1) return -1;
+            } else if (strcmp(arg, "fdatasync") == 0) {
+                wl->flush = FLUSH_FDATASYNC;
+            } else if (strcmp(arg, "sync_file_range") == 0) {
+                wl->flush = FLUSH_SYNC_FILE_RANGE;
+                wl->period = DEFAULT_SFR_PERIOD;
+            } else if (strncmp(arg, "sync_file_range:", 16) == 0) {
+                wl->flush = FLUSH_SYNC_FILE_RANGE;
+                if ((wl->period = parse_period(arg + 16)) == -1) return -1;
+            } else {
+                fprintf(stderr, "Error: Modo de --fsync desconocido '%s'.\n", arg);
+                return -1;
+            }
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+void write_layout_set_sync(struct write_layout *wl) {
+    wl->flush = FLUSH_END;
+    wl->period = 0;
+}
+
+int write_layout_syncs(const struct write_layout *wl) {
+    return wl->flush != FLUSH_NONE;
+}
+
+int write_layout_begin(struct write_layout *wl, int fd_out, off_t size) {
+    wl->written = 0;
+    wl->next_flush = wl->period;
+    wl->range_start = 0;
+    wl->range_waited = 0;
+    wl->flush_calls = 0;
+    wl->extents = -1;
+
+    if (wl->prealloc == PREALLOC_NONE || size <= 0) {
+        return 0;
+    }
+    int mode = (wl->prealloc == PREALLOC_KEEP_SIZE) ? FALLOC_FL_KEEP_SIZE : 0;
+    if (fallocate(fd_out, mode, 0, size) == -1) {
+        perror("Error en fallocate del archivo de salida");
+        return -1;
+    }
+    return 0;
+}
+
+// Inicia la escritura de lo escrito desde el último tramo y espera la del
+// tramo anterior, para que nunca haya más de dos tramos sucios en vuelo
+static int sync_range_step(struct write_layout *wl, int fd_out) {
+    if (wl->written > wl->range_start) {
+        wl->flush_calls++;
+        if (sync_file_range(fd_out, wl->range_start, wl->written - wl->range_start,
+                            SYNC_FILE_RANGE_WRITE) == -1) {
+            perror("Error en sync_file_range");
+            return -1;
+        }
+    }
+    if (wl->range_start > wl->range_waited) {
+        wl->flush_calls++;
+        if (sync_file_range(fd_out, wl->range_waited, wl->range_start - wl->range_waited,
+                            SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER) == -1) {
+            perror("Error en sync_file_range");
+            return -1;
+        }
+        wl->range_waited = wl->range_start;
+    }
+    wl->range_start = wl->written;
+    return 0;
+}
+
+int write_layout_wrote(struct write_layout *wl, int fd_out, size_t len) {
+    wl->written += len;
+    if (wl->period <= 0 || wl->written < wl->next_flush) {
+        return 0;
+    }
+    wl->next_flush = wl->written + wl->period;
+
+    if (wl->flush == FLUSH_PERIODIC) {
+        wl->flush_calls++;
+        if (fsync(fd_out) == -1) {
+            perror("Error en fsync");
+            return -1;
+        }
+        return 0;
+    }
+    return sync_range_step(wl, fd_out);
+}
+
+int write_layout_finish(struct write_layout *wl, int fd_out) {
+    switch (wl->flush) {
+        case FLUSH_NONE:
+            return 0;
+        case FLUSH_END:
+        case FLUSH_PERIODIC:
+            wl->flush_calls++;
+            if (fsync(fd_out) == -1) {
+                perror("Error en fsync");
+                return -1;
+            }
+            return 0;
+        case FLUSH_SYNC_FILE_RANGE:
+            if (sync_range_step(wl, fd_out) == -1) {
+                return -1;
+            }
+            // Los tramos ya están en disco; fdatasync() completa el tamaño y los extents
+            /* fallthrough */
+        case FLUSH_FDATASYNC:
+            wl->flush_calls++;
+            if (fdatasync(fd_out) == -1) {
+                perror("Error en fdatasync");
+                return -1;
+            }
+            return 0;
+    }
+    return 0;
+}
+
+void write_layout_report(struct write_layout *wl, int fd_out) {
+    // Sin espacio para extents, FIEMAP solo devuelve cuántos hay.
+    // FIEMAP_FLAG_SYNC asigna antes los bloques de asignación diferida.
+    struct fiemap fm;
+    memset(&fm, 0, sizeof(fm));
+    fm.fm_start = 0;
+    fm.fm_length = FIEMAP_MAX_OFFSET;
+    fm.fm_flags = FIEMAP_FLAG_SYNC;
+    fm.fm_extent_count = 0;
+    if (ioctl(fd_out, FS_IOC_FIEMAP, &fm) == -1) {
+        wl->extents = -1;
+        return;
+    }
+    wl->extents = fm.fm_mapped_extents;
+}
+
+void write_layout_print(const struct write_layout *wl) {
+    printf("Prealloc: %s\n", prealloc_names[wl->prealloc]);
+    printf("FlushMode: %s\n", flush_names[wl->flush]);
+    printf("FlushPeriod: %lld\n", wl->period);
+    printf("FlushCalls: %ld\n", wl->flush_calls);
+    printf("Extents: %ld\n", wl->extents);
+}
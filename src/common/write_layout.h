@@ -0,0 +1,86 @@
+#ifndef WRITE_LAYOUT_H
+#define WRITE_LAYOUT_H
+
+#include <getopt.h>
+#include <sys/types.h>
+
+/**
+ * write_layout.h
+ *
+ * Opciones de colocación y volcado del archivo de destino, compartidas por
+ * los programas de copia local:
+ *  - --prealloc=none|fallocate|keep-size: reservar el destino completo con
+ *    fallocate() antes de la primera escritura (keep-size: sin cambiar su
+ *    tamaño, FALLOC_FL_KEEP_SIZE). Sin reserva, ext4 asigna bloques a medida
+ *    que el archivo crece y el resultado puede quedar fragmentado.
+ *  - --fsync=end|periodic:N|fdatasync|sync_file_range[:N]: cómo llegan los
+ *    datos al disco. end es fsync() al final (igual que --sync); periodic
+ *    llama a fsync() cada N bytes escritos y al final; fdatasync omite los
+ *    metadatos no imprescindibles; sync_file_range inicia la escritura cada
+ *    N bytes (por defecto 8 MiB), espera la del tramo anterior y termina con
+ *    fdatasync(). Todos los modos dejan los datos en disco al acabar.
+ * Tras la copia se cuentan los extents del destino con FIEMAP.
+ *
+ * Uso: añadir WRITE_LAYOUT_LONG_OPTIONS a la tabla de getopt_long, delegar
+ * en write_layout_parse_option() y llamar a write_layout_begin() al empezar
+ * a medir, a write_layout_wrote() tras cada escritura y a
+ * write_layout_finish() en lugar del fsync() final.
+ */
+
+// Códigos de getopt, fuera del rango de los de tcp_tuning.h y cache_state.h
+enum {
+    WRITE_OPT_PREALLOC = 0x300,
+    WRITE_OPT_FSYNC,
+};
+
+#define WRITE_LAYOUT_LONG_OPTIONS \
+    {"prealloc", required_argument, NULL, WRITE_OPT_PREALLOC}, \
+    {"fsync", required_argument, NULL, WRITE_OPT_FSYNC}
+
+#define WRITE_LAYOUT_USAGE \
+    "[--prealloc=none|fallocate|keep-size] [--fsync=end|periodic:N|fdatasync|sync_file_range[:N]]"
+
+enum prealloc_mode { PREALLOC_NONE, PREALLOC_FALLOCATE, PREALLOC_KEEP_SIZE };
+
+enum flush_mode { FLUSH_NONE, FLUSH_END, FLUSH_PERIODIC, FLUSH_FDATASYNC, FLUSH_SYNC_FILE_RANGE };
+
+struct write_layout {
+    enum prealloc_mode prealloc;
+    enum flush_mode flush;
+    long long period;             // Bytes entre volcados (periodic, sync_file_range)
+    // Estado y resultados
+    long long written;            // Bytes escritos desde write_layout_begin()
+    long long next_flush;         // Valor de written en el que toca el siguiente volcado
+    long long range_start;        // sync_file_range: inicio del tramo aún sin iniciar
+    long long range_waited;       // sync_file_range: bytes cuya escritura ya se esperó
+    long flush_calls;             // fsync/fdatasync/sync_file_range emitidos
+    long extents;                 // Extents del destino (-1 = desconocido)
+};
+
+// Devuelve 1 si opt era una de estas opciones, 0 si no lo era y -1 si el
+// argumento no es válido (ya informado por stderr).
+int write_layout_parse_option(int opt, const char *arg, struct write_layout *wl);
+
+// --sync de cada programa: fsync() al final
+void write_layout_set_sync(struct write_layout *wl);
+
+// 1 si los datos se vuelcan a disco (SyncMode: sync)
+int write_layout_syncs(const struct write_layout *wl);
+
+// Reserva el destino (si se pidió). size es el tamaño final esperado.
+// Devuelve 0 o -1 (con perror).
+int write_layout_begin(struct write_layout *wl, int fd_out, off_t size);
+
+// Registra len bytes escritos y emite el volcado periódico si toca.
+// Devuelve 0 o -1 (con perror).
+int write_layout_wrote(struct write_layout *wl, int fd_out, size_t len);
+
+// Volcado final según el modo. Devuelve 0 o -1 (con perror).
+int write_layout_finish(struct write_layout *wl, int fd_out);
+
+// Cuenta los extents del destino (FIEMAP); llamar fuera del intervalo medido
+void write_layout_report(struct write_layout *wl, int fd_out);
+
+void write_layout_print(const struct write_layout *wl);
+
+#endif
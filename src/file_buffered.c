@@ -6,6 +6,16 @@
 #include <string.h>
 #include <time.h>
 #include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/resource.h>
+
+#include "page_cache.h"
+#include "cache_state.h"
+#include "write_layout.h"
+#include "io_trace.h"
+#include "report.h"
+#include "sampler.h"
 
 /**
  * file_buffered.c
@@ -16,8 +26,31 @@
  * búfer en el espacio de usuario y luego se escriben desde ese búfer al
  * archivo de salida.
  *
+ * Con la opción --buffers N se usa en su lugar el esquema de "buffer
+ * circular" (con N = 2, "double buffer") de la misma sección: un hilo lector
+ * llena un anillo de N búferes mientras un hilo escritor lo vacía, de modo
+ * que la latencia de lectura del origen se solapa con la de escritura en el
+ * destino. Se mide el tiempo que cada hilo pasa bloqueado esperando al otro
+ * (el lector por un búfer libre, el escritor por uno lleno) para identificar
+ * qué lado es el cuello de botella.
+ *
  * Mide el tiempo total de la operación, y cuenta el número de llamadas
- * al sistema 'read' y 'write'.
+ * al sistema 'read' y 'write' y los fallos de página (getrusage), para
+ * comparar con la copia por proyecciones de file_mmap.
+ *
+ * Pistas al cache de página (en ambos modos):
+ *  - --fadvise M: posix_fadvise() sobre todo el origen antes de copiar
+ *                 (sequential, willneed o dontneed).
+ *  - --readahead N: readahead() explícito para mantener N bytes pedidos por
+ *                   delante del cursor de lectura.
+ *  - --drop-behind N: cada N bytes se inicia la escritura del tramo recién
+ *                     escrito con sync_file_range(), se espera la del tramo
+ *                     anterior y se descarta con POSIX_FADV_DONTNEED (y lo
+ *                     ya leído del origen), de modo que una copia grande no
+ *                     desaloja el resto del cache. El último tramo queda en
+ *                     cache salvo con --sync.
+ * Al final se informa cuánto del origen y del destino quedó residente
+ * (mincore) y la variación de "Cached:" en /proc/meminfo durante la copia.
  *
  * Argumentos:
  *  - <fichero_entrada>: Ruta al archivo de origen.
@@ -25,27 +58,301 @@
  *  - <tam_buffer>: Tamaño del búfer de lectura/escritura en bytes.
  *  - [--sync]: Opcional. Si se especifica, se llama a fsync() para forzar
  *              la escritura a disco.
+ *  - [--buffers N]: Opcional. Número de búferes del anillo (N >= 2) para el
+ *                   modo con hilo lector y escritor.
+ *  - [--fadvise M] [--readahead N] [--drop-behind N]: Opcionales. Pistas al
+ *                   cache de página descritas arriba.
+ *  - [--prealloc=M] [--fsync=M]: Opcionales. Reserva y volcado a disco del
+ *                                destino (ver common/write_layout.h).
+ *  - [--cold|--warm]: Opcional. Desalojar o precargar solo el archivo de
+ *                     entrada antes de medir (ver common/cache_state.h).
+ *  - [--sample-ms N]: Opcional. Cada N ms anota los bytes transferidos e informa
+ *                     la serie de MB/s y el mayor parón (ver common/sampler.h).
+ *  - [--json] [--json-out F] [--tag K=V]: Opcionales. Resultados en JSON, una
+ *                     línea por bloque con los metadatos de la ejecución (ver common/report.h).
  */
 
+#define MAX_RING_BUFFERS 1024
+
+enum fadvise_mode { FADVISE_NONE, FADVISE_SEQUENTIAL, FADVISE_WILLNEED, FADVISE_DONTNEED };
+
+static const char *fadvise_names[] = { "none", "sequential", "willneed", "dontneed" };
+
+// Pistas al cache de página durante la copia. El lado lector solo toca los
+// campos read_* y el escritor los write_*, así que en el modo con anillo
+// cada hilo actualiza los suyos sin cerrojo.
+struct cache_hints {
+    long readahead_window;    // Bytes pedidos por delante del cursor (0 = solo el kernel)
+    long drop_behind;         // Tramo liberado detrás del cursor (0 = desactivado)
+
+    off_t read_pos;
+    off_t read_ahead_end;     // Hasta dónde se pidió readahead()
+    off_t read_dropped;       // Origen ya descartado del cache
+    long readahead_calls;
+    long read_fadvise_calls;
+
+    off_t write_pos;
+    off_t write_started;      // Hasta dónde se inició la escritura a disco
+    off_t write_dropped;      // Destino ya escrito y descartado del cache
+    long sync_file_range_calls;
+    long write_fadvise_calls;
+};
+
+// Tras leer n bytes: renovar la ventana de readahead y soltar lo ya leído
+static void hints_after_read(struct cache_hints *h, int fd_in, ssize_t n) {
+    h->read_pos += n;
+    // Se renueva al consumir la mitad de la ventana, no en cada lectura
+    if (h->readahead_window > 0 && h->read_ahead_end - h->read_pos < h->readahead_window / 2) {
+        off_t from = h->read_ahead_end > h->read_pos ? h->read_ahead_end : h->read_pos;
+        off_t to = h->read_pos + h->readahead_window;
+        readahead(fd_in, from, to - from);
+        h->readahead_calls++;
+        h->read_ahead_end = to;
+    }
+    if (h->drop_behind > 0 && h->read_pos - h->read_dropped >= h->drop_behind) {
+        posix_fadvise(fd_in, h->read_dropped, h->read_pos - h->read_dropped, POSIX_FADV_DONTNEED);
+        h->read_fadvise_calls++;
+        h->read_dropped = h->read_pos;
+    }
+}
+
+// Tras escribir n bytes: iniciar la escritura del tramo nuevo y descartar el
+// anterior, cuya escritura ya tuvo un tramo entero de tiempo para avanzar
+static void hints_after_write(struct cache_hints *h, int fd_out, ssize_t n) {
+    h->write_pos += n;
+    if (h->drop_behind <= 0 || h->write_pos - h->write_started < h->drop_behind) {
+        return;
+    }
+    sync_file_range(fd_out, h->write_started, h->write_pos - h->write_started, SYNC_FILE_RANGE_WRITE);
+    h->sync_file_range_calls++;
+    if (h->write_started > h->write_dropped) {
+        off_t len = h->write_started - h->write_dropped;
+        sync_file_range(fd_out, h->write_dropped, len,
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        h->sync_file_range_calls++;
+        posix_fadvise(fd_out, h->write_dropped, len, POSIX_FADV_DONTNEED);
+        h->write_fadvise_calls++;
+        h->write_dropped = h->write_started;
+    }
+    h->write_started = h->write_pos;
+}
+
+// Anillo de búferes compartido entre el hilo lector y el escritor
+struct ring {
+    char **buffers;
+    ssize_t *lengths;         // Bytes válidos en cada búfer
+    long count;               // Número de búferes del anillo
+    long buffer_size;
+    long head;                // Próximo búfer a escribir (escritor)
+    long tail;                // Próximo búfer a llenar (lector)
+    long filled;              // Búferes llenos pendientes de escribir
+    int eof;                  // El lector llegó al final del archivo
+    int error;                // Alguno de los hilos falló
+    pthread_mutex_t lock;
+    pthread_cond_t not_full;
+    pthread_cond_t not_empty;
+
+    int fd_in;
+    int fd_out;
+    long read_calls;
+    long write_calls;
+    double reader_stall;      // Segundos esperando un búfer libre
+    double writer_stall;      // Segundos esperando un búfer lleno
+    struct cache_hints *hints;
+    struct write_layout *layout;
+};
+
+static double elapsed_since(const struct timespec *t0) {
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0->tv_sec) + (t1.tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+static void *reader_thread(void *arg) {
+    struct ring *r = arg;
+
+    for (;;) {
+        pthread_mutex_lock(&r->lock);
+        if (r->filled == r->count && !r->error) {
+            struct timespec t0;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            while (r->filled == r->count && !r->error) {
+                pthread_cond_wait(&r->not_full, &r->lock);
+            }
+            r->reader_stall += elapsed_since(&t0);
+        }
+        if (r->error) {
+            pthread_mutex_unlock(&r->lock);
+            return NULL;
+        }
+        long slot = r->tail;
+        pthread_mutex_unlock(&r->lock);
+
+        // La lectura se hace sin el cerrojo: el escritor no toca este búfer
+        ssize_t bytes_read = IO_TRACE(IO_OP_READ, read(r->fd_in, r->buffers[slot], r->buffer_size));
+        r->read_calls++;
+        // Las pistas son syscalls: fuera del cerrojo, como hints_after_write
+        if (bytes_read > 0) {
+            hints_after_read(r->hints, r->fd_in, bytes_read);
+        }
+
+        pthread_mutex_lock(&r->lock);
+        if (bytes_read == -1) {
+            perror("Error de lectura");
+            r->error = 1;
+        } else if (bytes_read == 0) {
+            r->eof = 1;
+        } else {
+            r->lengths[slot] = bytes_read;
+            r->tail = (slot + 1) % r->count;
+            r->filled++;
+        }
+        int done = r->eof || r->error;
+        pthread_cond_signal(&r->not_empty);
+        pthread_mutex_unlock(&r->lock);
+
+        if (done) {
+            return NULL;
+        }
+    }
+}
+
+static void *writer_thread(void *arg) {
+    struct ring *r = arg;
+
+    for (;;) {
+        pthread_mutex_lock(&r->lock);
+        if (r->filled == 0 && !r->eof && !r->error) {
+            struct timespec t0;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            while (r->filled == 0 && !r->eof && !r->error) {
+                pthread_cond_wait(&r->not_empty, &r->lock);
+            }
+            r->writer_stall += elapsed_since(&t0);
+        }
+        if (r->error || (r->filled == 0 && r->eof)) {
+            pthread_mutex_unlock(&r->lock);
+            return NULL;
+        }
+        long slot = r->head;
+        pthread_mutex_unlock(&r->lock);
+
+        ssize_t bytes_written = IO_TRACE(IO_OP_WRITE, write(r->fd_out, r->buffers[slot], r->lengths[slot]));
+        r->write_calls++;
+        int flush_failed = 0;
+        if (bytes_written > 0) {
+            hints_after_write(r->hints, r->fd_out, bytes_written);
+            sampler_add(bytes_written);
+            flush_failed = (write_layout_wrote(r->layout, r->fd_out, bytes_written) == -1);
+        }
+
+        pthread_mutex_lock(&r->lock);
+        if (bytes_written != r->lengths[slot]) {
+            perror("Error de escritura incompleta");
+            r->error = 1;
+        } else if (flush_failed) {
+            r->error = 1;
+        } else {
+            r->head = (slot + 1) % r->count;
+            r->filled--;
+        }
+        int failed = r->error;
+        pthread_cond_signal(&r->not_full);
+        pthread_mutex_unlock(&r->lock);
+
+        if (failed) {
+            return NULL;
+        }
+    }
+}
+
 void print_usage(const char *prog_name) {
-    fprintf(stderr, "Uso: %s <fichero_entrada> <fichero_salida> <tam_buffer> [--sync]\n", prog_name);
+    fprintf(stderr, "Uso: %s <fichero_entrada> <fichero_salida> <tam_buffer> [--sync] [--buffers N] "
+                    "[--fadvise sequential|willneed|dontneed] [--readahead N] [--drop-behind N] "
+                    WRITE_LAYOUT_USAGE " " CACHE_STATE_USAGE " " SAMPLER_USAGE " " REPORT_USAGE "\n", prog_name);
 }
 
 int main(int argc, char *argv[]) {
-    if (argc < 4 || argc > 5) {
+    enum cache_state cache_state = CACHE_STATE_DEFAULT;
+    struct write_layout layout;
+    memset(&layout, 0, sizeof(layout));
+    long ring_buffers = 0; // 0: esquema clásico de un solo búfer
+    enum fadvise_mode fadvise = FADVISE_NONE;
+    struct cache_hints hints;
+    memset(&hints, 0, sizeof(hints));
+
+    static struct option long_options[] = {
+        {"sync", no_argument, NULL, 's'},
+        {"buffers", required_argument, NULL, 'b'},
+        {"fadvise", required_argument, NULL, 'f'},
+        {"readahead", required_argument, NULL, 'r'},
+        {"drop-behind", required_argument, NULL, 'd'},
+        WRITE_LAYOUT_LONG_OPTIONS,
+        CACHE_STATE_LONG_OPTIONS,
+        REPORT_LONG_OPTIONS,
+        SAMPLER_LONG_OPTIONS,
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 's': write_layout_set_sync(&layout); break;
+            case 'b': ring_buffers = atol(optarg); break;
+            case 'f':
+                if (strcmp(optarg, "sequential") == 0) {
+                    fadvise = FADVISE_SEQUENTIAL;
+                } else if (strcmp(optarg, "willneed") == 0) {
+                    fadvise = FADVISE_WILLNEED;
+                } else if (strcmp(optarg, "dontneed") == 0) {
+                    fadvise = FADVISE_DONTNEED;
+                } else {
+                    fprintf(stderr, "Error: Modo de fadvise desconocido '%s'.\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'r': hints.readahead_window = atol(optarg); break;
+            case 'd': hints.drop_behind = atol(optarg); break;
+            default:
+                if (report_parse_option(opt, optarg) == 1) break;
+                if (sampler_parse_option(opt, optarg) == 1) break;
+                if (cache_state_parse_option(opt, &cache_state)) break;
+                if (write_layout_parse_option(opt, optarg, &layout) == 1) break;
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 3) {
         print_usage(argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    const char *input_path = argv[1];
-    const char *output_path = argv[2];
-    long buffer_size = atol(argv[3]);
-    int use_fsync = (argc == 5 && strcmp(argv[4], "--sync") == 0);
+    const char *input_path = argv[optind];
+    const char *output_path = argv[optind + 1];
+    long buffer_size = atol(argv[optind + 2]);
+    report_path("Input", input_path);
+    report_path("Output", output_path);
+    report_start(argc, argv);
 
     if (buffer_size <= 0) {
         fprintf(stderr, "Error: El tamaño del buffer debe ser un entero positivo.\n");
         exit(EXIT_FAILURE);
     }
+    if (ring_buffers != 0 && (ring_buffers < 2 || ring_buffers > MAX_RING_BUFFERS)) {
+        fprintf(stderr, "Error: El número de búferes debe estar entre 2 y %d.\n", MAX_RING_BUFFERS);
+        exit(EXIT_FAILURE);
+    }
+    if (hints.readahead_window < 0 || hints.drop_behind < 0) {
+        fprintf(stderr, "Error: --readahead y --drop-behind deben ser enteros no negativos.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Estado del cache de la entrada ---
+    struct cache_report cache_report;
+    if (cache_state_prepare(cache_state, input_path, &cache_report) == -1) {
+        exit(EXIT_FAILURE);
+    }
 
     // --- Apertura de archivos ---
     int fd_in = open(input_path, O_RDONLY);
@@ -61,8 +368,9 @@ int main(int argc, char *argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    // --- Asignación del búfer ---
-    char *buffer = malloc(buffer_size);
+    // --- Asignación de los búferes ---
+    long buffer_count = ring_buffers > 0 ? ring_buffers : 1;
+    char *buffer = malloc(buffer_size * buffer_count);
     if (buffer == NULL) {
         perror("Error al asignar memoria para el buffer");
         close(fd_in);
@@ -72,47 +380,130 @@ int main(int argc, char *argv[]) {
 
     // --- Medición de tiempo y copia ---
     struct timespec start, end;
+    struct rusage ru_start, ru_end;
     long read_calls = 0;
     long write_calls = 0;
-    ssize_t bytes_read;
+    ssize_t bytes_read = 0;
+    struct ring ring;
+    long fadvise_calls = 0;
+    long cached_before = page_cache_meminfo_cached_kb();
 
+    io_trace_begin();
+    sampler_start();
+    getrusage(RUSAGE_SELF, &ru_start);
     clock_gettime(CLOCK_MONOTONIC, &start);
 
-    while ((bytes_read = read(fd_in, buffer, buffer_size)) > 0) {
-        read_calls++;
-        ssize_t bytes_written = write(fd_out, buffer, bytes_read);
-        write_calls++;
-        if (bytes_written != bytes_read) {
-            perror("Error de escritura incompleta");
-            // Se podría añadir una lógica más robusta para reintentar la escritura
+    if (write_layout_begin(&layout, fd_out, cache_report.input_size) == -1) {
+        free(buffer);
+        close(fd_in);
+        close(fd_out);
+        exit(EXIT_FAILURE);
+    }
+
+    if (fadvise != FADVISE_NONE) {
+        static const int advice[] = { 0, POSIX_FADV_SEQUENTIAL, POSIX_FADV_WILLNEED, POSIX_FADV_DONTNEED };
+        int ret = posix_fadvise(fd_in, 0, 0, advice[fadvise]);
+        fadvise_calls++;
+        if (ret != 0) {
+            fprintf(stderr, "Aviso: posix_fadvise(%s) falló: %s\n", fadvise_names[fadvise], strerror(ret));
+        }
+    }
+
+    if (ring_buffers > 0) {
+        char *slots[MAX_RING_BUFFERS];
+        ssize_t lengths[MAX_RING_BUFFERS];
+        for (long i = 0; i < ring_buffers; i++) {
+            slots[i] = buffer + i * buffer_size;
+        }
+
+        memset(&ring, 0, sizeof(ring));
+        ring.buffers = slots;
+        ring.lengths = lengths;
+        ring.count = ring_buffers;
+        ring.buffer_size = buffer_size;
+        ring.fd_in = fd_in;
+        ring.fd_out = fd_out;
+        ring.hints = &hints;
+        ring.layout = &layout;
+        pthread_mutex_init(&ring.lock, NULL);
+        pthread_cond_init(&ring.not_full, NULL);
+        pthread_cond_init(&ring.not_empty, NULL);
+
+        pthread_t reader, writer;
+        if (pthread_create(&reader, NULL, reader_thread, &ring) != 0 ||
+            pthread_create(&writer, NULL, writer_thread, &ring) != 0) {
+            fprintf(stderr, "Error al crear los hilos lector/escritor\n");
             free(buffer);
             close(fd_in);
             close(fd_out);
             exit(EXIT_FAILURE);
         }
-    }
+        pthread_join(reader, NULL);
+        pthread_join(writer, NULL);
 
-    if (bytes_read == -1) {
-        perror("Error de lectura");
-        free(buffer);
-        close(fd_in);
-        close(fd_out);
-        exit(EXIT_FAILURE);
-    }
-    
-    // Forzar la escritura a disco si se especificó --sync
-    if (use_fsync) {
-        if (fsync(fd_out) == -1) {
-            perror("Error en fsync");
-            // No es fatal, pero el experimento debe registrar el error.
+        pthread_cond_destroy(&ring.not_empty);
+        pthread_cond_destroy(&ring.not_full);
+        pthread_mutex_destroy(&ring.lock);
+
+        if (ring.error) {
+            free(buffer);
+            close(fd_in);
+            close(fd_out);
+            exit(EXIT_FAILURE);
+        }
+        read_calls = ring.read_calls;
+        write_calls = ring.write_calls;
+    } else {
+        while ((bytes_read = IO_TRACE(IO_OP_READ, read(fd_in, buffer, buffer_size))) > 0) {
+            read_calls++;
+            hints_after_read(&hints, fd_in, bytes_read);
+            ssize_t bytes_written = IO_TRACE(IO_OP_WRITE, write(fd_out, buffer, bytes_read));
+            write_calls++;
+            if (bytes_written != bytes_read) {
+                perror("Error de escritura incompleta");
+                // Se podría añadir una lógica más robusta para reintentar la escritura
+                free(buffer);
+                close(fd_in);
+                close(fd_out);
+                exit(EXIT_FAILURE);
+            }
+            hints_after_write(&hints, fd_out, bytes_written);
+            sampler_add(bytes_written);
+            if (write_layout_wrote(&layout, fd_out, bytes_written) == -1) {
+                free(buffer);
+                close(fd_in);
+                close(fd_out);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        if (bytes_read == -1) {
+            perror("Error de lectura");
+            free(buffer);
+            close(fd_in);
+            close(fd_out);
+            exit(EXIT_FAILURE);
         }
     }
 
+    // Forzar la escritura a disco según --sync/--fsync.
+    // No es fatal, pero el experimento debe registrar el error.
+    write_layout_finish(&layout, fd_out);
+
     clock_gettime(CLOCK_MONOTONIC, &end);
-    
+    getrusage(RUSAGE_SELF, &ru_end);
+    io_trace_end();
+    sampler_stop();
+
     // --- Cálculo de tiempo y resultados ---
     double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
 
+    // Ocupación del cache tras la copia, fuera del intervalo medido
+    long cached_after = page_cache_meminfo_cached_kb();
+    long long input_resident = page_cache_resident_bytes(fd_in);
+    long long output_resident = page_cache_resident_bytes(fd_out);
+    write_layout_report(&layout, fd_out);
+
     // --- Limpieza ---
     free(buffer);
     close(fd_in);
@@ -120,12 +511,32 @@ int main(int argc, char *argv[]) {
 
     // --- Imprimir resultados para el parser ---
     // Este formato es clave para el script de análisis.
-    printf("Mechanism: Buffered I/O\n");
+    printf("Mechanism: %s\n", ring_buffers > 0 ? "Buffered I/O (Ring)" : "Buffered I/O");
     printf("BufferSize: %ld\n", buffer_size);
-    printf("SyncMode: %s\n", use_fsync ? "sync" : "nosync");
+    printf("SyncMode: %s\n", write_layout_syncs(&layout) ? "sync" : "nosync");
     printf("TimeTaken: %.6f\n", time_taken);
+    cache_state_print(&cache_report);
+    write_layout_print(&layout);
     printf("ReadCalls: %ld\n", read_calls);
     printf("WriteCalls: %ld\n", write_calls);
+    printf("MajorFaults: %ld\n", ru_end.ru_majflt - ru_start.ru_majflt);
+    printf("MinorFaults: %ld\n", ru_end.ru_minflt - ru_start.ru_minflt);
+    printf("Fadvise: %s\n", fadvise_names[fadvise]);
+    printf("ReadaheadWindow: %ld\n", hints.readahead_window);
+    printf("DropBehind: %ld\n", hints.drop_behind);
+    printf("FadviseCalls: %ld\n", fadvise_calls + hints.read_fadvise_calls + hints.write_fadvise_calls);
+    printf("ReadaheadCalls: %ld\n", hints.readahead_calls);
+    printf("SyncFileRangeCalls: %ld\n", hints.sync_file_range_calls);
+    printf("InputResidentBytes: %lld\n", input_resident);
+    printf("OutputResidentBytes: %lld\n", output_resident);
+    printf("PageCacheDeltaKB: %ld\n", (cached_before >= 0 && cached_after >= 0) ? cached_after - cached_before : 0);
+    if (ring_buffers > 0) {
+        printf("Buffers: %ld\n", ring_buffers);
+        printf("ReaderStallTime: %.6f\n", ring.reader_stall);
+        printf("WriterStallTime: %.6f\n", ring.writer_stall);
+    }
+    sampler_print();
+    io_trace_print();
 
     return 0;
 } 
\ No newline at end of file
@@ -6,7 +6,18 @@
 #include <string.h>
 #include <time.h>
 #include <errno.h>
+#include <getopt.h>
 #include <malloc.h> // Para memalign/posix_memalign
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/aio_abi.h>
+
+#include "cache_state.h"
+#include "write_layout.h"
+#include "dio_align.h"
+#include "io_trace.h"
+#include "report.h"
+#include "sampler.h"
 
 /**
  * file_direct.c
@@ -22,35 +33,492 @@
  * que las aplicaciones gestionen su propia estrategia de cache. Requiere
  * alineación de memoria y tamaño para los buffers.
  *
+ * Motores de copia:
+ *  - serial: read() y write() bloqueantes, un búfer cada vez; el dispositivo
+ *            nunca ve más de una petición pendiente (profundidad de cola 1).
+ *  - aio:    AIO nativo de Linux (io_submit/io_getevents) con <qd> búferes
+ *            en vuelo. Cada búfer lee su bloque y lo escribe en el mismo
+ *            offset, así que la lectura del bloque N+1 se solapa con la
+ *            escritura del bloque N. Es el esquema de las bases de datos que
+ *            gestionan su propio cache. Se usan las llamadas al sistema
+ *            directamente (sin libaio), igual que file_uring.
+ *
+ * La alineación se consulta para cada archivo con statx(STATX_DIOALIGN)
+ * (ver common/dio_align.h) en lugar de suponer un valor fijo. Si el tamaño
+ * del archivo no es múltiplo de ella, el último bloque leído es corto y no
+ * se puede escribir tal cual con O_DIRECT (EINVAL). Dos formas de copiarlo:
+ *  - pad:      se escribe el bloque completo rellenado con ceros y al final
+ *              se recorta el destino con ftruncate().
+ *  - buffered: se quita O_DIRECT del destino con fcntl() y la cola se
+ *              escribe a través del cache de página.
+ *
  * Argumentos:
  *  - <fichero_entrada>: Ruta al archivo de origen.
  *  - <fichero_salida>: Ruta al archivo de destino.
- *  - <tam_buffer>: Tamaño del búfer (debe ser múltiplo del tamaño de bloque del FS).
+ *  - <tam_buffer>: Tamaño del búfer (múltiplo de la alineación O_DIRECT de
+ *                  ambos archivos). Con --aio, tamaño de cada bloque en vuelo.
  *  - [--sync]: Opcional. Aunque O_DIRECT implica E/S síncrona, fsync()
  *              garantiza la escritura de metadatos.
+ *  - [--tail M]: Opcional. pad o buffered. Por defecto pad.
+ *  - [--aio]: Opcional. Usar el motor AIO en lugar del serial.
+ *  - [--qd N]: Opcional. Con --aio, bloques en vuelo. Por defecto 8.
+ *  - [--prealloc=M] [--fsync=M]: Opcionales. Reserva y volcado a disco del
+ *                                destino (ver common/write_layout.h).
+ *  - [--cold|--warm]: Opcional. Desalojar o precargar solo el archivo de
+ *                     entrada antes de medir (ver common/cache_state.h).
+ *  - [--sample-ms N]: Opcional. Cada N ms anota los bytes transferidos e informa
+ *                     la serie de MB/s y el mayor parón (ver common/sampler.h).
+ *  - [--json] [--json-out F] [--tag K=V]: Opcionales. Resultados en JSON, una
+ *                     línea por bloque con los metadatos de la ejecución (ver common/report.h).
  */
 
-#define ALIGNMENT 512 // Alineación de 512 bytes, común para O_DIRECT
+#define DEFAULT_QUEUE_DEPTH 8
+
+enum tail_method { TAIL_PAD, TAIL_BUFFERED };
+
+static const char *tail_names[] = { "pad", "buffered" };
+
+// Estado compartido por ambos motores de copia
+struct copy_ctx {
+    int fd_in, fd_out;
+    char *pool;                // Búferes alineados (uno en modo serial, qd en modo aio)
+    long buffer_size;
+    struct dio_align align;
+    enum tail_method tail_method;
+    struct write_layout *layout;
+    // Resultados
+    long read_calls;
+    long write_calls;
+    long long bytes_copied;
+    long tail_bytes;           // Bytes de la cola no alineada (0 si no la hay)
+    long submit_calls;         // Solo aio
+    long getevents_calls;      // Solo aio
+};
 
 void print_usage(const char *prog_name) {
-    fprintf(stderr, "Uso: %s <fichero_entrada> <fichero_salida> <tam_buffer> [--sync]\n", prog_name);
-    fprintf(stderr, "Nota: tam_buffer debe ser múltiplo de %d.\n", ALIGNMENT);
+    fprintf(stderr, "Uso: %s <fichero_entrada> <fichero_salida> <tam_buffer> [--sync] [--tail pad|buffered] "
+                    "[--aio] [--qd N] " WRITE_LAYOUT_USAGE " " CACHE_STATE_USAGE " " SAMPLER_USAGE " " REPORT_USAGE "\n", prog_name);
+    fprintf(stderr, "Nota: tam_buffer debe ser múltiplo de la alineación O_DIRECT (normalmente 512 o 4096).\n");
+}
+
+// Escribe len bytes completos; O_DIRECT puede devolver escrituras parciales
+static int write_all(int fd, const char *buf, size_t len, long *write_calls) {
+    while (len > 0) {
+        ssize_t n = IO_TRACE(IO_OP_WRITE, write(fd, buf, len));
+        (*write_calls)++;
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// Quita O_DIRECT del destino para escribir la cola a través del cache
+static int clear_direct(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    if (flags == -1 || fcntl(fd, F_SETFL, flags & ~O_DIRECT) == -1) {
+        perror("Error en fcntl al quitar O_DIRECT");
+        return -1;
+    }
+    return 0;
+}
+
+// --- Motor serial: read()/write() bloqueantes ---
+
+static int copy_serial(struct copy_ctx *c) {
+    char *buffer = c->pool;
+    ssize_t bytes_read;
+
+    while ((bytes_read = IO_TRACE(IO_OP_READ, read(c->fd_in, buffer, c->buffer_size))) != 0) {
+        c->read_calls++;
+        if (bytes_read == -1) {
+            if (errno == EINTR) continue;
+            perror("Error de lectura");
+            return -1;
+        }
+        if (c->tail_bytes > 0) {
+            // Tras un bloque no alineado el desplazamiento ya no admite O_DIRECT
+            fprintf(stderr, "Error: Lectura corta antes del final del archivo de entrada.\n");
+            return -1;
+        }
+
+        size_t write_len = bytes_read;
+        long unaligned = bytes_read % c->align.offset_align;
+        if (unaligned != 0) {
+            // Con O_DIRECT solo el final del archivo puede dar una lectura no alineada
+            c->tail_bytes = unaligned;
+            if (c->tail_method == TAIL_PAD) {
+                write_len = bytes_read - unaligned + c->align.offset_align;
+                memset(buffer + bytes_read, 0, write_len - bytes_read);
+            } else {
+                // Parte alineada con O_DIRECT; la cola, a través del cache
+                size_t aligned_len = bytes_read - unaligned;
+                if (aligned_len > 0 && write_all(c->fd_out, buffer, aligned_len, &c->write_calls) == -1) {
+                    perror("Error de escritura");
+                    return -1;
+                }
+                if (clear_direct(c->fd_out) == -1) {
+                    return -1;
+                }
+                if (write_all(c->fd_out, buffer + aligned_len, unaligned, &c->write_calls) == -1) {
+                    perror("Error de escritura de la cola");
+                    return -1;
+                }
+                c->bytes_copied += bytes_read;
+                sampler_add(bytes_read);
+                if (write_layout_wrote(c->layout, c->fd_out, bytes_read) == -1) {
+                    return -1;
+                }
+                continue;
+            }
+        }
+        if (write_all(c->fd_out, buffer, write_len, &c->write_calls) == -1) {
+            perror("Error de escritura");
+            return -1;
+        }
+        c->bytes_copied += bytes_read;
+        sampler_add(bytes_read);
+        if (write_layout_wrote(c->layout, c->fd_out, bytes_read) == -1) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// --- Motor aio: io_submit/io_getevents con varios bloques en vuelo ---
+
+enum slot_state { SLOT_IDLE, SLOT_READING, SLOT_WRITING };
+
+// Un búfer en vuelo y la operación que tiene en curso
+struct slot {
+    char *buf;
+    off_t offset;      // Posición del bloque en el archivo
+    size_t len;        // Bytes de datos útiles del bloque
+    size_t io_len;     // Bytes a transferir (alineados) en la fase actual
+    size_t done;       // Bytes ya transferidos en la fase actual
+    enum slot_state state;
+    struct iocb cb;
+};
+
+static int sys_io_setup(unsigned nr, aio_context_t *ctx) {
+    return syscall(__NR_io_setup, nr, ctx);
+}
+
+static int sys_io_destroy(aio_context_t ctx) {
+    return syscall(__NR_io_destroy, ctx);
+}
+
+static int sys_io_submit(aio_context_t ctx, long nr, struct iocb **iocbs) {
+    return syscall(__NR_io_submit, ctx, nr, iocbs);
+}
+
+static int sys_io_getevents(aio_context_t ctx, long min_nr, long nr, struct io_event *events) {
+    return syscall(__NR_io_getevents, ctx, min_nr, nr, events, NULL);
+}
+
+// Redondea hacia arriba a la alineación de desplazamientos
+static size_t align_up(size_t len, unsigned align) {
+    return (len + align - 1) / align * align;
+}
+
+// Prepara el iocb de la fase actual del slot (el resto pendiente de la operación)
+static void prepare_io(struct copy_ctx *c, struct slot *s, long index) {
+    int reading = (s->state == SLOT_READING);
+    memset(&s->cb, 0, sizeof(s->cb));
+    s->cb.aio_lio_opcode = reading ? IOCB_CMD_PREAD : IOCB_CMD_PWRITE;
+    s->cb.aio_fildes = reading ? c->fd_in : c->fd_out;
+    s->cb.aio_buf = (unsigned long)(s->buf + s->done);
+    s->cb.aio_nbytes = s->io_len - s->done;
+    s->cb.aio_offset = s->offset + s->done;
+    s->cb.aio_data = index;
+    if (reading) {
+        c->read_calls++;
+    } else {
+        c->write_calls++;
+    }
+}
+
+// Asigna al slot el siguiente bloque del archivo y prepara su lectura
+static void start_block(struct copy_ctx *c, struct slot *s, long index, off_t *next_offset, off_t file_size) {
+    s->offset = *next_offset;
+    s->len = (file_size - *next_offset < c->buffer_size) ? (size_t)(file_size - *next_offset) : (size_t)c->buffer_size;
+    // O_DIRECT lee bloques alineados aunque se pase del final del archivo
+    s->io_len = align_up(s->len, c->align.offset_align);
+    s->done = 0;
+    s->state = SLOT_READING;
+    *next_offset += s->len;
+    prepare_io(c, s, index);
+}
+
+// Envía todos los iocb pendientes; io_submit puede aceptar solo una parte
+static int submit_pending(struct copy_ctx *c, aio_context_t ctx, struct iocb **pending, long *npending) {
+    long first = 0;
+    while (first < *npending) {
+        int ret = IO_TRACE(IO_OP_IO_SUBMIT, sys_io_submit(ctx, *npending - first, pending + first));
+        c->submit_calls++;
+        if (ret < 0) {
+            if (errno == EAGAIN || errno == EINTR) continue;
+            perror("Error en io_submit");
+            return -1;
+        }
+        first += ret;
+    }
+    *npending = 0;
+    return 0;
+}
+
+static int copy_aio(struct copy_ctx *c, long queue_depth, off_t file_size) {
+    struct slot *slots = calloc(queue_depth, sizeof(struct slot));
+    struct iocb **pending = calloc(queue_depth, sizeof(struct iocb *));
+    struct io_event *events = calloc(queue_depth, sizeof(struct io_event));
+    if (slots == NULL || pending == NULL || events == NULL) {
+        perror("Error al asignar memoria para las peticiones AIO");
+        free(slots);
+        free(pending);
+        free(events);
+        return -1;
+    }
+    for (long i = 0; i < queue_depth; i++) {
+        slots[i].buf = c->pool + i * c->buffer_size;
+        slots[i].state = SLOT_IDLE;
+    }
+
+    aio_context_t ctx = 0;
+    if (sys_io_setup(queue_depth, &ctx) == -1) {
+        perror("Error en io_setup");
+        free(slots);
+        free(pending);
+        free(events);
+        return -1;
+    }
+
+    off_t next_offset = 0;
+    long npending = 0;
+    long inflight = 0;
+    struct slot *tail_slot = NULL;   // Con --tail buffered, bloque cuya cola queda pendiente
+    int failed = 0;
+
+    // Cebar la cola: una lectura por búfer mientras quede archivo
+    for (long i = 0; i < queue_depth && next_offset < file_size; i++) {
+        start_block(c, &slots[i], i, &next_offset, file_size);
+        pending[npending++] = &slots[i].cb;
+        inflight++;
+    }
+
+    while (inflight > 0) {
+        if (submit_pending(c, ctx, pending, &npending) == -1) {
+            failed = 1;
+            break;
+        }
+        int nevents = IO_TRACE(IO_OP_IO_GETEVENTS, sys_io_getevents(ctx, 1, queue_depth, events));
+        c->getevents_calls++;
+        if (nevents < 0) {
+            if (errno == EINTR) continue;
+            perror("Error en io_getevents");
+            failed = 1;
+            break;
+        }
+
+        for (int e = 0; e < nevents && !failed; e++) {
+            long index = (long)events[e].data;
+            long long res = events[e].res;
+            struct slot *s = &slots[index];
+
+            if (res == -EAGAIN || res == -EINTR) {
+                // Reintentar la misma operación
+                prepare_io(c, s, index);
+                pending[npending++] = &s->cb;
+                continue;
+            }
+            if (res < 0) {
+                errno = -res;
+                perror(s->state == SLOT_READING ? "Error de lectura" : "Error de escritura");
+                failed = 1;
+                break;
+            }
+
+            s->done += res;
+            if (s->state == SLOT_READING) {
+                if (s->done < s->len) {
+                    // El resto del bloque empezaría en un offset no alineado, que
+                    // O_DIRECT rechaza con EINVAL: igual que en copy_serial, error
+                    fprintf(stderr, "Error: Lectura corta antes del final del archivo de entrada (offset %ld).\n",
+                            (long)(s->offset + s->done));
+                    failed = 1;
+                    break;
+                }
+                // Bloque completo: pasa a escribirse en el mismo offset
+                long unaligned = s->len % c->align.offset_align;
+                s->io_len = s->len;
+                if (unaligned != 0) {
+                    c->tail_bytes = unaligned;
+                    if (c->tail_method == TAIL_PAD) {
+                        s->io_len = align_up(s->len, c->align.offset_align);
+                        memset(s->buf + s->len, 0, s->io_len - s->len);
+                    } else {
+                        s->io_len = s->len - unaligned;
+                        tail_slot = s;
+                    }
+                }
+                s->state = SLOT_WRITING;
+                s->done = 0;
+                if (s->io_len == 0) {
+                    // Bloque formado solo por la cola: nada que escribir con O_DIRECT
+                    s->state = SLOT_IDLE;
+                    inflight--;
+                    continue;
+                }
+                prepare_io(c, s, index);
+                pending[npending++] = &s->cb;
+            } else {
+                if (s->done < s->io_len) {
+                    if (res == 0) {
+                        fprintf(stderr, "Error de escritura incompleta\n");
+                        failed = 1;
+                        break;
+                    }
+                    prepare_io(c, s, index);
+                    pending[npending++] = &s->cb;
+                    continue;
+                }
+                c->bytes_copied += (s == tail_slot) ? s->io_len : s->len;
+                sampler_add((s == tail_slot) ? s->io_len : s->len);
+                if (write_layout_wrote(c->layout, c->fd_out, (s == tail_slot) ? s->io_len : s->len) == -1) {
+                    failed = 1;
+                    break;
+                }
+                // Búfer libre: reutilizarlo para el siguiente bloque pendiente
+                if (next_offset < file_size) {
+                    start_block(c, s, index, &next_offset, file_size);
+                    pending[npending++] = &s->cb;
+                } else {
+                    s->state = SLOT_IDLE;
+                    inflight--;
+                }
+            }
+        }
+        if (failed) {
+            break;
+        }
+    }
+
+    // io_destroy() espera a las peticiones aún en vuelo antes de volver, así
+    // que tras un error los búferes se pueden liberar sin más
+    sys_io_destroy(ctx);
+
+    // La cola de --tail buffered sigue en su búfer: el slot ya no se reutilizó
+    if (!failed && tail_slot != NULL) {
+        size_t aligned_len = tail_slot->len - c->tail_bytes;
+        if (clear_direct(c->fd_out) == -1) {
+            failed = 1;
+        } else {
+            ssize_t n;
+            size_t done = 0;
+            while (done < (size_t)c->tail_bytes) {
+                n = IO_TRACE(IO_OP_WRITE, pwrite(c->fd_out, tail_slot->buf + aligned_len + done, c->tail_bytes - done,
+                                                 tail_slot->offset + aligned_len + done));
+                c->write_calls++;
+                if (n == -1) {
+                    if (errno == EINTR) continue;
+                    perror("Error de escritura de la cola");
+                    failed = 1;
+                    break;
+                }
+                done += n;
+            }
+            if (!failed) {
+                c->bytes_copied += c->tail_bytes;
+                sampler_add(c->tail_bytes);
+                if (write_layout_wrote(c->layout, c->fd_out, c->tail_bytes) == -1) {
+                    failed = 1;
+                }
+            }
+        }
+    }
+
+    free(slots);
+    free(pending);
+    free(events);
+    return failed ? -1 : 0;
 }
 
 int main(int argc, char *argv[]) {
-    if (argc < 4 || argc > 5) {
+    enum cache_state cache_state = CACHE_STATE_DEFAULT;
+    struct write_layout layout;
+    memset(&layout, 0, sizeof(layout));
+    int use_aio = 0;
+    long queue_depth = DEFAULT_QUEUE_DEPTH;
+    enum tail_method tail_method = TAIL_PAD;
+
+    static struct option long_options[] = {
+        {"sync", no_argument, NULL, 's'},
+        {"tail", required_argument, NULL, 't'},
+        {"aio", no_argument, NULL, 'a'},
+        {"qd", required_argument, NULL, 'q'},
+        WRITE_LAYOUT_LONG_OPTIONS,
+        CACHE_STATE_LONG_OPTIONS,
+        REPORT_LONG_OPTIONS,
+        SAMPLER_LONG_OPTIONS,
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 's': write_layout_set_sync(&layout); break;
+            case 't':
+                if (strcmp(optarg, "pad") == 0) {
+                    tail_method = TAIL_PAD;
+                } else if (strcmp(optarg, "buffered") == 0) {
+                    tail_method = TAIL_BUFFERED;
+                } else {
+                    fprintf(stderr, "Error: Método de cola desconocido '%s'.\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'a': use_aio = 1; break;
+            case 'q': queue_depth = atol(optarg); break;
+            default:
+                if (report_parse_option(opt, optarg) == 1) break;
+                if (sampler_parse_option(opt, optarg) == 1) break;
+                if (cache_state_parse_option(opt, &cache_state)) break;
+                if (write_layout_parse_option(opt, optarg, &layout) == 1) break;
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 3) {
         print_usage(argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    const char *input_path = argv[1];
-    const char *output_path = argv[2];
-    long buffer_size = atol(argv[3]);
-    int use_fsync = (argc == 5 && strcmp(argv[4], "--sync") == 0);
+    const char *input_path = argv[optind];
+    const char *output_path = argv[optind + 1];
+    long buffer_size = atol(argv[optind + 2]);
+    report_path("Input", input_path);
+    report_path("Output", output_path);
+    report_start(argc, argv);
 
-    if (buffer_size <= 0 || buffer_size % ALIGNMENT != 0) {
-        fprintf(stderr, "Error: El tamaño del buffer debe ser un múltiplo de %d.\n", ALIGNMENT);
-        print_usage(argv[0]);
+    if (buffer_size <= 0) {
+        fprintf(stderr, "Error: El tamaño del buffer debe ser un entero positivo.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (queue_depth <= 0 || queue_depth > 4096) {
+        fprintf(stderr, "Error: La profundidad de cola debe estar entre 1 y 4096.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (!use_aio) {
+        queue_depth = 1;
+    }
+
+    // --- Estado del cache de la entrada ---
+    // Con O_DIRECT el cache no se usa para los datos, pero se informa igual
+    struct cache_report cache_report;
+    if (cache_state_prepare(cache_state, input_path, &cache_report) == -1) {
         exit(EXIT_FAILURE);
     }
 
@@ -69,9 +537,42 @@ int main(int argc, char *argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    // --- Asignación del búfer alineado ---
-    void *buffer;
-    int ret = posix_memalign(&buffer, ALIGNMENT, buffer_size);
+    struct stat file_stat;
+    if (fstat(fd_in, &file_stat) == -1) {
+        perror("Error en fstat");
+        close(fd_in);
+        close(fd_out);
+        exit(EXIT_FAILURE);
+    }
+
+    struct copy_ctx c;
+    memset(&c, 0, sizeof(c));
+    c.fd_in = fd_in;
+    c.fd_out = fd_out;
+    c.buffer_size = buffer_size;
+    c.tail_method = tail_method;
+    c.layout = &layout;
+
+    // --- Alineación exigida por ambos archivos ---
+    struct dio_align out_align;
+    if (dio_align_probe(fd_in, &c.align) == -1 || dio_align_probe(fd_out, &out_align) == -1) {
+        fprintf(stderr, "Error: El sistema de archivos no admite O_DIRECT para estos archivos.\n");
+        close(fd_in);
+        close(fd_out);
+        exit(EXIT_FAILURE);
+    }
+    dio_align_merge(&c.align, &out_align);
+
+    if (buffer_size % c.align.offset_align != 0) {
+        fprintf(stderr, "Error: El tamaño del buffer debe ser un múltiplo de %u.\n", c.align.offset_align);
+        close(fd_in);
+        close(fd_out);
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Asignación de los búferes alineados (una sola región) ---
+    void *pool;
+    int ret = posix_memalign(&pool, c.align.mem_align, (size_t)buffer_size * queue_depth);
     if (ret != 0) {
         errno = ret;
         perror("Error en posix_memalign");
@@ -79,62 +580,74 @@ int main(int argc, char *argv[]) {
         close(fd_out);
         exit(EXIT_FAILURE);
     }
+    c.pool = pool;
 
     // --- Medición de tiempo y copia ---
     struct timespec start, end;
-    long read_calls = 0;
-    long write_calls = 0;
-    ssize_t bytes_read;
 
+    io_trace_begin();
+    sampler_start();
     clock_gettime(CLOCK_MONOTONIC, &start);
 
-    while ((bytes_read = read(fd_in, buffer, buffer_size)) > 0) {
-        read_calls++;
-        // Con O_DIRECT, la escritura debe tener un tamaño múltiplo del tamaño de bloque,
-        // excepto posiblemente la última escritura. Aquí asumimos que las lecturas no finales
-        // serán del tamaño completo del buffer.
-        ssize_t bytes_written = write(fd_out, buffer, bytes_read);
-        write_calls++;
-        if (bytes_written != bytes_read) {
-            perror("Error de escritura incompleta");
-            free(buffer);
-            close(fd_in);
-            close(fd_out);
-            exit(EXIT_FAILURE);
+    int failed = write_layout_begin(&layout, fd_out, file_stat.st_size) == -1;
+    if (!failed) {
+        failed = (use_aio ? copy_aio(&c, queue_depth, file_stat.st_size) : copy_serial(&c)) == -1;
+    }
+
+    // Recortar el relleno de la última escritura
+    if (!failed && tail_method == TAIL_PAD && c.tail_bytes > 0) {
+        if (ftruncate(fd_out, c.bytes_copied) == -1) {
+            perror("Error en ftruncate del archivo de salida");
+            failed = 1;
         }
     }
 
-    if (bytes_read == -1) {
-        perror("Error de lectura");
-        free(buffer);
+    if (failed) {
+        free(pool);
         close(fd_in);
         close(fd_out);
         exit(EXIT_FAILURE);
     }
-    
-    if (use_fsync) {
-        if (fsync(fd_out) == -1) {
-            perror("Error en fsync");
-        }
-    }
+
+    write_layout_finish(&layout, fd_out);
 
     clock_gettime(CLOCK_MONOTONIC, &end);
-    
+    io_trace_end();
+    sampler_stop();
+
     // --- Cálculo de tiempo y resultados ---
     double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
 
+    write_layout_report(&layout, fd_out);
+
     // --- Limpieza ---
-    free(buffer);
+    free(pool);
     close(fd_in);
     close(fd_out);
 
     // --- Imprimir resultados para el parser ---
-    printf("Mechanism: Direct I/O\n");
+    printf("Mechanism: Direct I/O%s\n", use_aio ? " (Linux AIO)" : "");
     printf("BufferSize: %ld\n", buffer_size);
-    printf("SyncMode: %s\n", use_fsync ? "sync" : "nosync");
+    printf("SyncMode: %s\n", write_layout_syncs(&layout) ? "sync" : "nosync");
     printf("TimeTaken: %.6f\n", time_taken);
-    printf("ReadCalls: %ld\n", read_calls);
-    printf("WriteCalls: %ld\n", write_calls);
+    cache_state_print(&cache_report);
+    write_layout_print(&layout);
+    printf("BytesCopied: %lld\n", c.bytes_copied);
+    printf("Engine: %s\n", use_aio ? "aio" : "serial");
+    printf("QueueDepth: %ld\n", queue_depth);
+    printf("ReadCalls: %ld\n", c.read_calls);
+    printf("WriteCalls: %ld\n", c.write_calls);
+    if (use_aio) {
+        printf("SubmitCalls: %ld\n", c.submit_calls);
+        printf("GeteventsCalls: %ld\n", c.getevents_calls);
+    }
+    printf("DioMemAlign: %u\n", c.align.mem_align);
+    printf("DioOffsetAlign: %u\n", c.align.offset_align);
+    printf("DioAlignSource: %s\n", c.align.from_statx ? "statx" : "fallback");
+    printf("TailBytes: %ld\n", c.tail_bytes);
+    printf("TailMethod: %s\n", tail_names[tail_method]);
+    sampler_print();
+    io_trace_print();
 
     return 0;
-} 
\ No newline at end of file
+}
@@ -0,0 +1,329 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#include "cache_state.h"
+#include "write_layout.h"
+#include "io_trace.h"
+#include "report.h"
+
+/**
+ * file_mmap.c
+ *
+ * Realiza una copia de archivo a través de proyecciones en memoria (mmap).
+ * El origen se proyecta completo y los datos se obtienen por fallos de
+ * página en lugar de con read(): la E/S la dispara el acceso a la memoria.
+ *
+ * Referencia teórica: Stallings, Cap. 8 (memoria virtual, paginación por
+ * demanda) y Cap. 11.4. Frente al bucle read()/write() de file_buffered no
+ * hay búfer de usuario intermedio, pero cada página cuesta un fallo (menor si
+ * ya está en el cache de página, mayor si hay que leerla del dispositivo).
+ * Se informan ambos contadores (getrusage) junto con el tiempo.
+ *
+ * Métodos de escritura del destino:
+ *  - memcpy: el destino se reserva con ftruncate, se proyecta con MAP_SHARED
+ *            y se copia con memcpy() bloque a bloque; con --sync se llama a
+ *            msync() antes de fsync().
+ *  - write:  write() del destino directamente desde la proyección del origen.
+ *
+ * Variantes de la proyección:
+ *  - --populate:   MAP_POPULATE, precarga todas las páginas en mmap() (el
+ *                  coste se traslada a la llamada y desaparecen los fallos).
+ *  - --sequential: madvise(MADV_SEQUENTIAL), lectura anticipada agresiva.
+ *  - --hugepage:   madvise(MADV_HUGEPAGE); solo tiene efecto donde el
+ *                  sistema de archivos admite páginas grandes en el cache.
+ *  - --dontneed:   madvise(MADV_DONTNEED) sobre lo ya copiado, detrás del
+ *                  cursor, para que la proyección no acumule páginas.
+ *
+ * Argumentos:
+ *  - <fichero_entrada>: Ruta al archivo de origen.
+ *  - <fichero_salida>: Ruta al archivo de destino.
+ *  - <tam_buffer>: Bytes copiados por memcpy()/write().
+ *  - [--sync]: Opcional. Forzar la escritura a disco al final.
+ *  - [--method M]: Opcional. memcpy o write. Por defecto memcpy.
+ *  - [--populate] [--sequential] [--hugepage] [--dontneed]: Opcionales.
+ *  - [--prealloc=M] [--fsync=M]: Opcionales. Reserva y volcado a disco del
+ *                                destino (ver common/write_layout.h).
+ *  - [--cold|--warm]: Opcional. Desalojar o precargar solo el archivo de
+ *                     entrada antes de medir (ver common/cache_state.h).
+ *  - [--json] [--json-out F] [--tag K=V]: Opcionales. Resultados en JSON, una
+ *                     línea por bloque con los metadatos de la ejecución (ver common/report.h).
+ */
+
+enum copy_method { METHOD_MEMCPY, METHOD_WRITE };
+
+static const char *method_names[] = { "memcpy", "write" };
+
+// Contadores de llamadas al sistema del bucle de copia
+static long write_calls = 0;
+static long madvise_calls = 0;
+
+void print_usage(const char *prog_name) {
+    fprintf(stderr, "Uso: %s <fichero_entrada> <fichero_salida> <tam_buffer> [--sync] [--method memcpy|write] "
+                    "[--populate] [--sequential] [--hugepage] [--dontneed] " WRITE_LAYOUT_USAGE " " CACHE_STATE_USAGE " " REPORT_USAGE "\n", prog_name);
+}
+
+// Aplica un consejo a toda la proyección. Los fallos no son fatales: el
+// consejo es opcional y el kernel puede no admitirlo para este archivo.
+static void advise(void *addr, size_t len, int advice, const char *label) {
+    madvise_calls++;
+    if (madvise(addr, len, advice) == -1) {
+        fprintf(stderr, "Aviso: madvise(%s) falló: %s\n", label, strerror(errno));
+    }
+}
+
+// Libera las páginas completas ya copiadas de [*released, done)
+static void release_behind(char *map, off_t *released, off_t done, long page_size) {
+    off_t limit = done - (done % page_size);
+    if (limit > *released) {
+        madvise_calls++;
+        madvise(map + *released, limit - *released, MADV_DONTNEED);
+        *released = limit;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    enum cache_state cache_state = CACHE_STATE_DEFAULT;
+    struct write_layout layout;
+    memset(&layout, 0, sizeof(layout));
+    enum copy_method method = METHOD_MEMCPY;
+    int populate = 0;
+    int sequential = 0;
+    int hugepage = 0;
+    int dontneed = 0;
+
+    static struct option long_options[] = {
+        {"sync", no_argument, NULL, 's'},
+        {"method", required_argument, NULL, 'm'},
+        {"populate", no_argument, NULL, 'p'},
+        {"sequential", no_argument, NULL, 'q'},
+        {"hugepage", no_argument, NULL, 'h'},
+        {"dontneed", no_argument, NULL, 'd'},
+        WRITE_LAYOUT_LONG_OPTIONS,
+        CACHE_STATE_LONG_OPTIONS,
+        REPORT_LONG_OPTIONS,
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 's': write_layout_set_sync(&layout); break;
+            case 'm':
+                if (strcmp(optarg, "memcpy") == 0) {
+                    method = METHOD_MEMCPY;
+                } else if (strcmp(optarg, "write") == 0) {
+                    method = METHOD_WRITE;
+                } else {
+                    fprintf(stderr, "Error: Método desconocido '%s'.\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'p': populate = 1; break;
+            case 'q': sequential = 1; break;
+            case 'h': hugepage = 1; break;
+            case 'd': dontneed = 1; break;
+            default:
+                if (report_parse_option(opt, optarg) == 1) break;
+                if (cache_state_parse_option(opt, &cache_state)) break;
+                if (write_layout_parse_option(opt, optarg, &layout) == 1) break;
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 3) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    const char *input_path = argv[optind];
+    const char *output_path = argv[optind + 1];
+    long buffer_size = atol(argv[optind + 2]);
+    report_path("Input", input_path);
+    report_path("Output", output_path);
+    report_start(argc, argv);
+
+    if (buffer_size <= 0) {
+        fprintf(stderr, "Error: El tamaño del buffer debe ser un entero positivo.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Estado del cache de la entrada ---
+    struct cache_report cache_report;
+    if (cache_state_prepare(cache_state, input_path, &cache_report) == -1) {
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Apertura de archivos ---
+    int fd_in = open(input_path, O_RDONLY);
+    if (fd_in == -1) {
+        perror("Error al abrir el archivo de entrada");
+        exit(EXIT_FAILURE);
+    }
+
+    struct stat file_stat;
+    if (fstat(fd_in, &file_stat) == -1) {
+        perror("Error en fstat");
+        close(fd_in);
+        exit(EXIT_FAILURE);
+    }
+    off_t file_size = file_stat.st_size;
+
+    // La proyección compartida del destino necesita lectura y escritura
+    int fd_out = open(output_path, (method == METHOD_MEMCPY ? O_RDWR : O_WRONLY) | O_CREAT | O_TRUNC, 0644);
+    if (fd_out == -1) {
+        perror("Error al abrir el archivo de salida");
+        close(fd_in);
+        exit(EXIT_FAILURE);
+    }
+
+    long page_size = sysconf(_SC_PAGESIZE);
+
+    // --- Medición de tiempo y copia ---
+    // mmap() queda dentro del intervalo: con --populate es donde se lee el archivo.
+    struct timespec start, end;
+    struct rusage ru_start, ru_end;
+    char *src = NULL;
+    char *dst = NULL;
+    off_t copied = 0;
+    int failed = 0;
+
+    io_trace_begin();
+    getrusage(RUSAGE_SELF, &ru_start);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (write_layout_begin(&layout, fd_out, file_size) == -1) {
+        close(fd_in);
+        close(fd_out);
+        exit(EXIT_FAILURE);
+    }
+
+    // Un archivo vacío no se puede proyectar; la copia es trivial
+    if (file_size > 0) {
+        int map_flags = MAP_SHARED | (populate ? MAP_POPULATE : 0);
+        src = mmap(NULL, file_size, PROT_READ, map_flags, fd_in, 0);
+        if (src == MAP_FAILED) {
+            perror("Error en mmap del archivo de entrada");
+            close(fd_in);
+            close(fd_out);
+            exit(EXIT_FAILURE);
+        }
+        if (method == METHOD_MEMCPY) {
+            if (ftruncate(fd_out, file_size) == -1) {
+                perror("Error en ftruncate del archivo de salida");
+                munmap(src, file_size);
+                close(fd_in);
+                close(fd_out);
+                exit(EXIT_FAILURE);
+            }
+            dst = mmap(NULL, file_size, PROT_READ | PROT_WRITE, map_flags, fd_out, 0);
+            if (dst == MAP_FAILED) {
+                perror("Error en mmap del archivo de salida");
+                munmap(src, file_size);
+                close(fd_in);
+                close(fd_out);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        if (sequential) {
+            advise(src, file_size, MADV_SEQUENTIAL, "MADV_SEQUENTIAL");
+            if (dst != NULL) advise(dst, file_size, MADV_SEQUENTIAL, "MADV_SEQUENTIAL");
+        }
+        if (hugepage) {
+            advise(src, file_size, MADV_HUGEPAGE, "MADV_HUGEPAGE");
+            if (dst != NULL) advise(dst, file_size, MADV_HUGEPAGE, "MADV_HUGEPAGE");
+        }
+
+        off_t released = 0;
+        while (copied < file_size) {
+            size_t chunk = (file_size - copied < buffer_size) ? (size_t)(file_size - copied) : (size_t)buffer_size;
+            if (method == METHOD_MEMCPY) {
+                memcpy(dst + copied, src + copied, chunk);
+            } else {
+                ssize_t bytes_written = IO_TRACE(IO_OP_WRITE, write(fd_out, src + copied, chunk));
+                write_calls++;
+                if (bytes_written == -1) {
+                    if (errno == EINTR) continue;
+                    perror("Error de escritura");
+                    failed = 1;
+                    break;
+                }
+                chunk = bytes_written;
+            }
+            copied += chunk;
+            if (write_layout_wrote(&layout, fd_out, chunk) == -1) {
+                failed = 1;
+                break;
+            }
+
+            if (dontneed) {
+                off_t before = released;
+                release_behind(src, &released, copied, page_size);
+                if (dst != NULL && released > before) {
+                    // Las páginas sucias del destino siguen en el cache; solo se quita la proyección
+                    madvise_calls++;
+                    madvise(dst + before, released - before, MADV_DONTNEED);
+                }
+            }
+        }
+    }
+
+    // Forzar la escritura a disco según --sync/--fsync
+    if (!failed && write_layout_syncs(&layout)) {
+        if (dst != NULL && msync(dst, file_size, MS_SYNC) == -1) {
+            perror("Error en msync");
+        }
+        write_layout_finish(&layout, fd_out);
+    }
+
+    if (dst != NULL) munmap(dst, file_size);
+    if (src != NULL) munmap(src, file_size);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    getrusage(RUSAGE_SELF, &ru_end);
+    io_trace_end();
+
+    // --- Cálculo de tiempo y resultados ---
+    double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    write_layout_report(&layout, fd_out);
+
+    // --- Limpieza ---
+    close(fd_in);
+    close(fd_out);
+
+    if (failed) {
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Imprimir resultados para el parser ---
+    printf("Mechanism: Memory-Mapped I/O (%s)\n", method_names[method]);
+    printf("BufferSize: %ld\n", buffer_size);
+    printf("SyncMode: %s\n", write_layout_syncs(&layout) ? "sync" : "nosync");
+    printf("TimeTaken: %.6f\n", time_taken);
+    cache_state_print(&cache_report);
+    write_layout_print(&layout);
+    printf("BytesCopied: %lld\n", (long long)copied);
+    printf("WriteCalls: %ld\n", write_calls);
+    printf("MadviseCalls: %ld\n", madvise_calls);
+    printf("Populate: %d\n", populate);
+    printf("Sequential: %d\n", sequential);
+    printf("HugePage: %d\n", hugepage);
+    printf("DontNeed: %d\n", dontneed);
+    printf("MajorFaults: %ld\n", ru_end.ru_majflt - ru_start.ru_majflt);
+    printf("MinorFaults: %ld\n", ru_end.ru_minflt - ru_start.ru_minflt);
+    io_trace_print();
+
+    return 0;
+}
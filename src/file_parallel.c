@@ -0,0 +1,430 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+
+#include "cache_state.h"
+#include "io_trace.h"
+#include "report.h"
+
+/**
+ * file_parallel.c
+ *
+ * Realiza una copia de archivo dividiendo el origen en N rangos de bytes
+ * contiguos que se copian concurrentemente, uno por hilo. Con un único bucle
+ * read/write (file_buffered.c, file_direct.c) o una única llamada a
+ * sendfile() (file_sendfile.c) la copia queda limitada a un núcleo y a una
+ * petición en vuelo; aquí cada hilo mantiene la suya, de modo que el
+ * dispositivo recibe hasta N peticiones simultáneas.
+ *
+ * Antes de copiar se reserva el destino completo con fallocate() para que
+ * los hilos no compitan extendiendo el archivo ni asignando bloques.
+ *
+ * Métodos de copia por rango:
+ *  - rw:              pread()/pwrite() con un búfer por hilo (opcionalmente
+ *                     con O_DIRECT).
+ *  - copy_file_range: copy_file_range() con offsets explícitos.
+ *  - sendfile:        sendfile() con offset de entrada; cada hilo abre su
+ *                     propio descriptor de salida posicionado con lseek().
+ *
+ * Se informa el rendimiento de cada hilo y el tiempo total de pared, para
+ * localizar a partir de cuántos hilos deja de escalar cada dispositivo.
+ *
+ * Argumentos:
+ *  - <fichero_entrada>: Ruta al archivo de origen.
+ *  - <fichero_salida>: Ruta al archivo de destino.
+ *  - <tam_buffer>: Tamaño del búfer (rw) o del bloque por llamada (resto).
+ *  - [--threads N]: Opcional. Número de hilos/rangos. Por defecto 4.
+ *  - [--method M]: Opcional. rw, copy_file_range o sendfile. Por defecto rw.
+ *  - [--direct]: Opcional. Solo con rw: abre ambos archivos con O_DIRECT.
+ *  - [--no-prealloc]: Opcional. No reservar el destino con fallocate().
+ *  - [--sync]: Opcional. Si se especifica, se llama a fsync() al final.
+ *  - [--cold|--warm]: Opcional. Desalojar o precargar solo el archivo de
+ *                     entrada antes de medir (ver common/cache_state.h).
+ *  - [--json] [--json-out F] [--tag K=V]: Opcionales. Resultados en JSON, una
+ *                     línea por bloque con los metadatos de la ejecución (ver common/report.h).
+ */
+
+#define DEFAULT_THREADS 4
+#define MAX_THREADS 256
+#define ALIGNMENT 4096 // Alineación segura para O_DIRECT en la mayoría de dispositivos
+
+enum copy_method { METHOD_RW, METHOD_COPY_FILE_RANGE, METHOD_SENDFILE };
+
+static const char *method_names[] = { "rw", "copy_file_range", "sendfile" };
+
+// Trabajo y resultados de un hilo
+struct worker {
+    int id;
+    enum copy_method method;
+    int fd_in;
+    int fd_out;
+    const char *output_path;
+    int direct;
+    off_t start;           // Primer byte del rango
+    off_t end;             // Un byte después del último del rango
+    long buffer_size;
+
+    long long bytes;       // Bytes copiados
+    long calls;            // Llamadas de copia (pread+pwrite o equivalentes)
+    double time_taken;
+    int error;
+};
+
+void print_usage(const char *prog_name) {
+    fprintf(stderr, "Uso: %s <fichero_entrada> <fichero_salida> <tam_buffer> [--threads N] "
+                    "[--method rw|copy_file_range|sendfile] [--direct] [--no-prealloc] [--sync] "
+                    CACHE_STATE_USAGE " " REPORT_USAGE "\n", prog_name);
+    fprintf(stderr, "Nota: con --direct, tam_buffer debe ser múltiplo de %d.\n", ALIGNMENT);
+}
+
+static int copy_range_rw(struct worker *w) {
+    void *buffer;
+    int ret = posix_memalign(&buffer, ALIGNMENT, w->buffer_size);
+    if (ret != 0) {
+        errno = ret;
+        perror("Error en posix_memalign");
+        return -1;
+    }
+
+    off_t offset = w->start;
+    while (offset < w->end) {
+        size_t want = (w->end - offset < w->buffer_size) ? (size_t)(w->end - offset) : (size_t)w->buffer_size;
+        // Con O_DIRECT se lee el bloque completo; al final del archivo el
+        // kernel devuelve solo los bytes que existen.
+        size_t io_len = w->direct ? (size_t)w->buffer_size : want;
+
+        ssize_t bytes_read = IO_TRACE(IO_OP_READ, pread(w->fd_in, buffer, io_len, offset));
+        w->calls++;
+        if (bytes_read == -1) {
+            perror("Error de lectura");
+            free(buffer);
+            return -1;
+        }
+        if (bytes_read == 0) {
+            fprintf(stderr, "Error: fin de archivo inesperado en el offset %ld\n", (long)offset);
+            free(buffer);
+            return -1;
+        }
+        if ((size_t)bytes_read > want) {
+            bytes_read = want;
+        }
+
+        // En O_DIRECT la última escritura se rellena hasta la alineación y el
+        // archivo se recorta al terminar.
+        size_t write_len = bytes_read;
+        if (w->direct && write_len % ALIGNMENT != 0) {
+            write_len = (write_len / ALIGNMENT + 1) * ALIGNMENT;
+        }
+        ssize_t bytes_written = IO_TRACE(IO_OP_WRITE, pwrite(w->fd_out, buffer, write_len, offset));
+        w->calls++;
+        if (bytes_written != (ssize_t)write_len) {
+            perror("Error de escritura incompleta");
+            free(buffer);
+            return -1;
+        }
+
+        offset += bytes_read;
+        w->bytes += bytes_read;
+    }
+
+    free(buffer);
+    return 0;
+}
+
+static int copy_range_copy_file_range(struct worker *w) {
+    loff_t off_in = w->start;
+    loff_t off_out = w->start;
+
+    while (off_in < w->end) {
+        size_t want = (w->end - off_in < w->buffer_size) ? (size_t)(w->end - off_in) : (size_t)w->buffer_size;
+        ssize_t copied = IO_TRACE(IO_OP_COPY_FILE_RANGE, copy_file_range(w->fd_in, &off_in, w->fd_out, &off_out, want, 0));
+        w->calls++;
+        if (copied == -1) {
+            perror("Error en copy_file_range");
+            return -1;
+        }
+        if (copied == 0) {
+            fprintf(stderr, "Error: fin de archivo inesperado en el offset %ld\n", (long)off_in);
+            return -1;
+        }
+        w->bytes += copied;
+    }
+    return 0;
+}
+
+static int copy_range_sendfile(struct worker *w) {
+    // sendfile() escribe en la posición actual del descriptor de salida, así
+    // que cada hilo necesita el suyo propio.
+    int fd_out = open(w->output_path, O_WRONLY);
+    if (fd_out == -1) {
+        perror("Error al abrir el archivo de salida en el hilo");
+        return -1;
+    }
+    if (lseek(fd_out, w->start, SEEK_SET) == -1) {
+        perror("Error en lseek");
+        close(fd_out);
+        return -1;
+    }
+
+    off_t offset = w->start;
+    while (offset < w->end) {
+        size_t want = (w->end - offset < w->buffer_size) ? (size_t)(w->end - offset) : (size_t)w->buffer_size;
+        ssize_t sent = IO_TRACE(IO_OP_SENDFILE, sendfile(fd_out, w->fd_in, &offset, want));
+        w->calls++;
+        if (sent == -1) {
+            perror("Error en sendfile");
+            close(fd_out);
+            return -1;
+        }
+        if (sent == 0) {
+            fprintf(stderr, "Error: fin de archivo inesperado en el offset %ld\n", (long)offset);
+            close(fd_out);
+            return -1;
+        }
+        w->bytes += sent;
+    }
+
+    close(fd_out);
+    return 0;
+}
+
+static void *worker_thread(void *arg) {
+    struct worker *w = arg;
+    struct timespec t0, t1;
+    int ret;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    switch (w->method) {
+        case METHOD_COPY_FILE_RANGE: ret = copy_range_copy_file_range(w); break;
+        case METHOD_SENDFILE:        ret = copy_range_sendfile(w); break;
+        default:                     ret = copy_range_rw(w); break;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    w->time_taken = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    w->error = (ret == -1);
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    enum cache_state cache_state = CACHE_STATE_DEFAULT;
+    int use_fsync = 0;
+    int use_direct = 0;
+    int use_prealloc = 1;
+    long threads = DEFAULT_THREADS;
+    enum copy_method method = METHOD_RW;
+
+    static struct option long_options[] = {
+        {"sync", no_argument, NULL, 's'},
+        {"direct", no_argument, NULL, 'd'},
+        {"no-prealloc", no_argument, NULL, 'n'},
+        {"threads", required_argument, NULL, 't'},
+        {"method", required_argument, NULL, 'm'},
+        CACHE_STATE_LONG_OPTIONS,
+        REPORT_LONG_OPTIONS,
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 's': use_fsync = 1; break;
+            case 'd': use_direct = 1; break;
+            case 'n': use_prealloc = 0; break;
+            case 't': threads = atol(optarg); break;
+            case 'm':
+                if (strcmp(optarg, "rw") == 0) {
+                    method = METHOD_RW;
+                } else if (strcmp(optarg, "copy_file_range") == 0) {
+                    method = METHOD_COPY_FILE_RANGE;
+                } else if (strcmp(optarg, "sendfile") == 0) {
+                    method = METHOD_SENDFILE;
+                } else {
+                    fprintf(stderr, "Error: Método desconocido '%s'.\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            default:
+                if (report_parse_option(opt, optarg) == 1) break;
+                if (cache_state_parse_option(opt, &cache_state)) break;
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 3) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    const char *input_path = argv[optind];
+    const char *output_path = argv[optind + 1];
+    long buffer_size = atol(argv[optind + 2]);
+    report_path("Input", input_path);
+    report_path("Output", output_path);
+    report_start(argc, argv);
+
+    if (buffer_size <= 0 || (use_direct && buffer_size % ALIGNMENT != 0)) {
+        fprintf(stderr, "Error: El tamaño del buffer debe ser un entero positivo%s.\n",
+                use_direct ? " y múltiplo de la alineación" : "");
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (threads <= 0 || threads > MAX_THREADS) {
+        fprintf(stderr, "Error: El número de hilos debe estar entre 1 y %d.\n", MAX_THREADS);
+        exit(EXIT_FAILURE);
+    }
+    if (use_direct && method != METHOD_RW) {
+        fprintf(stderr, "Error: --direct solo se admite con el método rw.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Estado del cache de la entrada ---
+    struct cache_report cache_report;
+    if (cache_state_prepare(cache_state, input_path, &cache_report) == -1) {
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Apertura de archivos ---
+    int direct_flag = use_direct ? O_DIRECT : 0;
+    int fd_in = open(input_path, O_RDONLY | direct_flag);
+    if (fd_in == -1) {
+        perror("Error al abrir el archivo de entrada");
+        exit(EXIT_FAILURE);
+    }
+
+    int fd_out = open(output_path, O_WRONLY | O_CREAT | O_TRUNC | direct_flag, 0644);
+    if (fd_out == -1) {
+        perror("Error al abrir el archivo de salida");
+        close(fd_in);
+        exit(EXIT_FAILURE);
+    }
+
+    struct stat file_stat;
+    if (fstat(fd_in, &file_stat) == -1) {
+        perror("Error en fstat");
+        close(fd_in);
+        close(fd_out);
+        exit(EXIT_FAILURE);
+    }
+    off_t file_size = file_stat.st_size;
+
+    // --- Reparto en rangos ---
+    // Cada rango es múltiplo de tam_buffer para que, con O_DIRECT, todos los
+    // offsets queden alineados. Con archivos pequeños algunos hilos pueden
+    // quedar sin trabajo.
+    long long blocks = (file_size + buffer_size - 1) / buffer_size;
+    long long blocks_per_thread = (blocks + threads - 1) / threads;
+    off_t range_size = (off_t)blocks_per_thread * buffer_size;
+
+    struct worker workers[MAX_THREADS];
+    pthread_t tids[MAX_THREADS];
+    memset(workers, 0, sizeof(workers));
+    for (long i = 0; i < threads; i++) {
+        struct worker *w = &workers[i];
+        w->id = i;
+        w->method = method;
+        w->fd_in = fd_in;
+        w->fd_out = fd_out;
+        w->output_path = output_path;
+        w->direct = use_direct;
+        w->buffer_size = buffer_size;
+        w->start = (i * range_size < file_size) ? i * range_size : file_size;
+        w->end = (w->start + range_size < file_size) ? w->start + range_size : file_size;
+    }
+
+    // --- Medición de tiempo y copia ---
+    struct timespec start, end;
+    int preallocated = 0;
+    int failed = 0;
+
+    io_trace_begin();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (use_prealloc && file_size > 0) {
+        if (fallocate(fd_out, 0, 0, file_size) == -1) {
+            // No es fatal: el sistema de archivos puede no soportarlo.
+            perror("Aviso: fallocate no disponible");
+        } else {
+            preallocated = 1;
+        }
+    }
+
+    long started = 0;
+    for (long i = 0; i < threads; i++) {
+        if (pthread_create(&tids[i], NULL, worker_thread, &workers[i]) != 0) {
+            fprintf(stderr, "Error al crear el hilo %ld\n", i);
+            failed = 1;
+            break;
+        }
+        started++;
+    }
+    for (long i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+        if (workers[i].error) {
+            failed = 1;
+        }
+    }
+
+    // Recortar el relleno de la última escritura O_DIRECT
+    if (!failed && use_direct && ftruncate(fd_out, file_size) == -1) {
+        perror("Error en ftruncate");
+        failed = 1;
+    }
+
+    if (!failed && use_fsync) {
+        if (fsync(fd_out) == -1) {
+            perror("Error en fsync");
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    io_trace_end();
+
+    // --- Cálculo de tiempo y resultados ---
+    double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    // --- Limpieza ---
+    close(fd_in);
+    close(fd_out);
+
+    if (failed) {
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Imprimir resultados para el parser ---
+    long total_calls = 0;
+    for (long i = 0; i < threads; i++) {
+        total_calls += workers[i].calls;
+    }
+
+    printf("Mechanism: Parallel Copy\n");
+    printf("BufferSize: %ld\n", buffer_size);
+    printf("SyncMode: %s\n", use_fsync ? "sync" : "nosync");
+    printf("TimeTaken: %.6f\n", time_taken);
+    cache_state_print(&cache_report);
+    printf("Threads: %ld\n", threads);
+    printf("Method: %s\n", method_names[method]);
+    printf("DirectIO: %s\n", use_direct ? "yes" : "no");
+    printf("Preallocated: %s\n", preallocated ? "yes" : "no");
+    printf("CopyCalls: %ld\n", total_calls);
+    for (long i = 0; i < threads; i++) {
+        struct worker *w = &workers[i];
+        double mb_s = w->time_taken > 0 ? w->bytes / (1024.0 * 1024.0) / w->time_taken : 0.0;
+        printf("Thread%ldBytes: %lld\n", i, w->bytes);
+        printf("Thread%ldTime: %.6f\n", i, w->time_taken);
+        printf("Thread%ldThroughputMBs: %.2f\n", i, mb_s);
+    }
+    io_trace_print();
+
+    return 0;
+}
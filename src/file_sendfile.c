@@ -6,9 +6,15 @@
 #include <string.h>
 #include <time.h>
 #include <errno.h>
+#include <getopt.h>
 #include <sys/sendfile.h>
 #include <sys/stat.h>
 
+#include "cache_state.h"
+#include "write_layout.h"
+#include "io_trace.h"
+#include "report.h"
+
 /**
  * file_sendfile.c
  *
@@ -23,26 +29,250 @@
  * siendo extremadamente eficiente para transferir datos entre dos
  * descriptores de archivo.
  *
+ * Una sola llamada no basta para archivos grandes: el kernel limita cada
+ * transferencia a 0x7ffff000 bytes (~2 GiB), por lo que la copia se hace en
+ * un bucle de bloques de tamaño configurable. Además de sendfile() se pueden
+ * comparar los otros dos caminos zero-copy del kernel:
+ *  - copy_file_range(): permite al sistema de archivos hacer una copia por
+ *    reflink (XFS, btrfs) o en el servidor (NFS/SMB).
+ *  - splice(): mueve las páginas a través de una tubería intermedia.
+ * Si copy_file_range() o splice() no están soportados para estos archivos,
+ * se recurre a sendfile() y se informa en FallbackFrom.
+ *
  * Argumentos:
  *  - <fichero_entrada>: Ruta al archivo de origen.
  *  - <fichero_salida>: Ruta al archivo de destino.
  *  - [--sync]: Opcional. Si se especifica, se llama a fsync() para forzar
  *              la escritura a disco.
+ *  - [--method M]: Opcional. sendfile, copy_file_range o splice. Por defecto
+ *                  sendfile.
+ *  - [--chunk N]: Opcional. Bytes por llamada. Por defecto el máximo del
+ *                 kernel (con splice, la capacidad de la tubería).
+ *  - [--prealloc=M] [--fsync=M]: Opcionales. Reserva y volcado a disco del
+ *                                destino (ver common/write_layout.h).
+ *  - [--cold|--warm]: Opcional. Desalojar o precargar solo el archivo de
+ *                     entrada antes de medir (ver common/cache_state.h).
+ *  - [--json] [--json-out F] [--tag K=V]: Opcionales. Resultados en JSON, una
+ *                     línea por bloque con los metadatos de la ejecución (ver common/report.h).
  */
 
+#define MAX_CHUNK 0x7ffff000L // Máximo que el kernel transfiere por llamada
+#define SPLICE_PIPE_MAX (1024 * 1024) // Valor por defecto de /proc/sys/fs/pipe-max-size
+
+enum copy_method { METHOD_SENDFILE, METHOD_COPY_FILE_RANGE, METHOD_SPLICE };
+
+static const char *method_names[] = { "sendfile", "copy_file_range", "splice" };
+
+// Contadores de llamadas reales, uno por tipo
+static long sendfile_calls = 0;
+static long copy_file_range_calls = 0;
+static long splice_calls = 0;
+
+// Reserva y volcado del destino; los bucles de copia avisan de cada tramo escrito
+static struct write_layout layout;
+
 void print_usage(const char *prog_name) {
-    fprintf(stderr, "Uso: %s <fichero_entrada> <fichero_salida> [--sync]\n", prog_name);
+    fprintf(stderr, "Uso: %s <fichero_entrada> <fichero_salida> [--sync] "
+                    "[--method sendfile|copy_file_range|splice] [--chunk N] " WRITE_LAYOUT_USAGE " " CACHE_STATE_USAGE " " REPORT_USAGE "\n", prog_name);
+}
+
+// Indica si un error significa "este método no sirve para estos archivos"
+static int is_unsupported(int err) {
+    return err == ENOSYS || err == EXDEV || err == EOPNOTSUPP || err == EINVAL;
+}
+
+// Copia con sendfile() desde *offset hasta file_size. Devuelve 0 o -1.
+static int copy_sendfile(int fd_in, int fd_out, off_t *offset, off_t file_size, long chunk) {
+    while (*offset < file_size) {
+        size_t want = (file_size - *offset < chunk) ? (size_t)(file_size - *offset) : (size_t)chunk;
+        ssize_t sent = IO_TRACE(IO_OP_SENDFILE, sendfile(fd_out, fd_in, offset, want));
+        sendfile_calls++;
+        if (sent == -1) {
+            if (errno == EINTR) continue;
+            perror("Error en sendfile");
+            return -1;
+        }
+        if (sent == 0) {
+            fprintf(stderr, "Error: fin de archivo inesperado en el offset %ld\n", (long)*offset);
+            return -1;
+        }
+        if (write_layout_wrote(&layout, fd_out, sent) == -1) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Copia con copy_file_range(). Si falla en la primera llamada por falta de
+// soporte devuelve 1 para que el llamador recurra a sendfile().
+static int copy_cfr(int fd_in, int fd_out, off_t *offset, off_t file_size, long chunk) {
+    loff_t off_out = *offset;
+    while (*offset < file_size) {
+        size_t want = (file_size - *offset < chunk) ? (size_t)(file_size - *offset) : (size_t)chunk;
+        loff_t off_in = *offset;
+        ssize_t copied = IO_TRACE(IO_OP_COPY_FILE_RANGE, copy_file_range(fd_in, &off_in, fd_out, &off_out, want, 0));
+        copy_file_range_calls++;
+        if (copied == -1) {
+            if (errno == EINTR) continue;
+            if (*offset == 0 && is_unsupported(errno)) {
+                return 1;
+            }
+            perror("Error en copy_file_range");
+            return -1;
+        }
+        if (copied == 0) {
+            fprintf(stderr, "Error: fin de archivo inesperado en el offset %ld\n", (long)*offset);
+            return -1;
+        }
+        *offset = off_in;
+        if (write_layout_wrote(&layout, fd_out, copied) == -1) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Copia con splice() a través de una tubería. Devuelve 1 si splice no está
+// soportado para estos archivos. *chunk_size se ajusta a la capacidad real de la
+// tubería.
+static int copy_splice(int fd_in, int fd_out, off_t *offset, off_t file_size, long *chunk_size) {
+    int pipefd[2];
+    if (pipe(pipefd) == -1) {
+        perror("Error al crear la tubería");
+        return -1;
+    }
+
+    // La tubería limita cuánto se mueve por llamada; se intenta agrandarla
+    // hasta el tamaño de bloque pedido.
+    long pipe_size = fcntl(pipefd[1], F_SETPIPE_SZ, *chunk_size < SPLICE_PIPE_MAX ? *chunk_size : SPLICE_PIPE_MAX);
+    if (pipe_size == -1) {
+        pipe_size = fcntl(pipefd[1], F_GETPIPE_SZ);
+    }
+    if (*chunk_size > pipe_size) {
+        *chunk_size = pipe_size;
+    }
+    long chunk = *chunk_size;
+
+    // splice() escribe en la posición actual del descriptor de salida
+    if (lseek(fd_out, *offset, SEEK_SET) == -1) {
+        perror("Error en lseek");
+        close(pipefd[0]);
+        close(pipefd[1]);
+        return -1;
+    }
+
+    int ret = 0;
+    while (*offset < file_size) {
+        size_t want = (file_size - *offset < chunk) ? (size_t)(file_size - *offset) : (size_t)chunk;
+        loff_t off_in = *offset;
+        ssize_t in_pipe = IO_TRACE(IO_OP_SPLICE, splice(fd_in, &off_in, pipefd[1], NULL, want, SPLICE_F_MOVE | SPLICE_F_MORE));
+        splice_calls++;
+        if (in_pipe == -1) {
+            if (errno == EINTR) continue;
+            if (*offset == 0 && is_unsupported(errno)) {
+                ret = 1;
+                break;
+            }
+            perror("Error en splice (entrada)");
+            ret = -1;
+            break;
+        }
+        if (in_pipe == 0) {
+            fprintf(stderr, "Error: fin de archivo inesperado en el offset %ld\n", (long)*offset);
+            ret = -1;
+            break;
+        }
+
+        // Vaciar la tubería en el destino
+        ssize_t remaining = in_pipe;
+        while (remaining > 0) {
+            ssize_t out = IO_TRACE(IO_OP_SPLICE, splice(pipefd[0], NULL, fd_out, NULL, remaining, SPLICE_F_MOVE | SPLICE_F_MORE));
+            splice_calls++;
+            if (out == -1) {
+                if (errno == EINTR) continue;
+                perror("Error en splice (salida)");
+                ret = -1;
+                break;
+            }
+            remaining -= out;
+        }
+        if (ret == -1) {
+            break;
+        }
+        *offset = off_in;
+        if (write_layout_wrote(&layout, fd_out, in_pipe) == -1) {
+            ret = -1;
+            break;
+        }
+    }
+
+    close(pipefd[0]);
+    close(pipefd[1]);
+    return ret;
 }
 
 int main(int argc, char *argv[]) {
-    if (argc < 3 || argc > 4) {
+    enum cache_state cache_state = CACHE_STATE_DEFAULT;
+    enum copy_method method = METHOD_SENDFILE;
+    long chunk_size = MAX_CHUNK;
+
+    static struct option long_options[] = {
+        {"sync", no_argument, NULL, 's'},
+        {"method", required_argument, NULL, 'm'},
+        {"chunk", required_argument, NULL, 'c'},
+        WRITE_LAYOUT_LONG_OPTIONS,
+        CACHE_STATE_LONG_OPTIONS,
+        REPORT_LONG_OPTIONS,
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 's': write_layout_set_sync(&layout); break;
+            case 'c': chunk_size = atol(optarg); break;
+            case 'm':
+                if (strcmp(optarg, "sendfile") == 0) {
+                    method = METHOD_SENDFILE;
+                } else if (strcmp(optarg, "copy_file_range") == 0) {
+                    method = METHOD_COPY_FILE_RANGE;
+                } else if (strcmp(optarg, "splice") == 0) {
+                    method = METHOD_SPLICE;
+                } else {
+                    fprintf(stderr, "Error: Método desconocido '%s'.\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            default:
+                if (report_parse_option(opt, optarg) == 1) break;
+                if (cache_state_parse_option(opt, &cache_state)) break;
+                if (write_layout_parse_option(opt, optarg, &layout) == 1) break;
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 2) {
         print_usage(argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    const char *input_path = argv[1];
-    const char *output_path = argv[2];
-    int use_fsync = (argc == 4 && strcmp(argv[3], "--sync") == 0);
+    const char *input_path = argv[optind];
+    const char *output_path = argv[optind + 1];
+    report_path("Input", input_path);
+    report_path("Output", output_path);
+    report_start(argc, argv);
+
+    if (chunk_size <= 0 || chunk_size > MAX_CHUNK) {
+        fprintf(stderr, "Error: El tamaño de bloque debe estar entre 1 y %ld.\n", MAX_CHUNK);
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Estado del cache de la entrada ---
+    struct cache_report cache_report;
+    if (cache_state_prepare(cache_state, input_path, &cache_report) == -1) {
+        exit(EXIT_FAILURE);
+    }
 
     // --- Apertura de archivos ---
     int fd_in = open(input_path, O_RDONLY);
@@ -57,7 +287,7 @@ int main(int argc, char *argv[]) {
         close(fd_in);
         exit(EXIT_FAILURE);
     }
-    
+
     // --- Obtener tamaño del archivo de entrada ---
     struct stat file_stat;
     if (fstat(fd_in, &file_stat) == -1) {
@@ -70,41 +300,73 @@ int main(int argc, char *argv[]) {
 
     // --- Medición de tiempo y copia ---
     struct timespec start, end;
-    
+    off_t offset = 0;
+    int ret;
+    const char *fallback_from = NULL;
+
+    io_trace_begin();
     clock_gettime(CLOCK_MONOTONIC, &start);
 
-    ssize_t sent_bytes = sendfile(fd_out, fd_in, NULL, file_size);
-    if (sent_bytes != file_size) {
-        perror("Error en sendfile o escritura incompleta");
-        fprintf(stderr, "Bytes enviados: %ld de %ld\n", sent_bytes, file_size);
+    if (write_layout_begin(&layout, fd_out, file_size) == -1) {
         close(fd_in);
         close(fd_out);
         exit(EXIT_FAILURE);
     }
 
-    if (use_fsync) {
-        if (fsync(fd_out) == -1) {
-            perror("Error en fsync");
-        }
+    switch (method) {
+        case METHOD_COPY_FILE_RANGE:
+            ret = copy_cfr(fd_in, fd_out, &offset, file_size, chunk_size);
+            break;
+        case METHOD_SPLICE:
+            ret = copy_splice(fd_in, fd_out, &offset, file_size, &chunk_size);
+            break;
+        default:
+            ret = copy_sendfile(fd_in, fd_out, &offset, file_size, chunk_size);
+            break;
+    }
+    if (ret == 1) {
+        // Método no soportado para estos archivos: recurrir a sendfile()
+        fallback_from = method_names[method];
+        method = METHOD_SENDFILE;
+        ret = copy_sendfile(fd_in, fd_out, &offset, file_size, chunk_size);
+    }
+    if (ret == -1) {
+        fprintf(stderr, "Bytes copiados: %ld de %ld\n", (long)offset, (long)file_size);
+        close(fd_in);
+        close(fd_out);
+        exit(EXIT_FAILURE);
     }
 
+    write_layout_finish(&layout, fd_out);
+
     clock_gettime(CLOCK_MONOTONIC, &end);
-    
+    io_trace_end();
+
     // --- Cálculo de tiempo y resultados ---
     double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
 
+    write_layout_report(&layout, fd_out);
+
     // --- Limpieza ---
     close(fd_in);
     close(fd_out);
 
     // --- Imprimir resultados para el parser ---
-    printf("Mechanism: sendfile\n");
-    // BufferSize es N/A para sendfile, pero lo incluimos por consistencia.
-    printf("BufferSize: 0\n"); 
-    printf("SyncMode: %s\n", use_fsync ? "sync" : "nosync");
+    printf("Mechanism: %s\n", method_names[method]);
+    // BufferSize es N/A para los mecanismos zero-copy, pero lo incluimos por consistencia.
+    printf("BufferSize: 0\n");
+    printf("SyncMode: %s\n", write_layout_syncs(&layout) ? "sync" : "nosync");
     printf("TimeTaken: %.6f\n", time_taken);
-    // sendfile es una sola llamada, strace lo confirmará.
-    printf("SendfileCalls: 1\n");
+    cache_state_print(&cache_report);
+    write_layout_print(&layout);
+    printf("ChunkSize: %ld\n", chunk_size);
+    printf("SendfileCalls: %ld\n", sendfile_calls);
+    printf("CopyFileRangeCalls: %ld\n", copy_file_range_calls);
+    printf("SpliceCalls: %ld\n", splice_calls);
+    if (fallback_from != NULL) {
+        printf("FallbackFrom: %s\n", fallback_from);
+    }
+    io_trace_print();
 
     return 0;
-} 
\ No newline at end of file
+}
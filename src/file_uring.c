@@ -0,0 +1,557 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#include "cache_state.h"
+#include "dio_align.h"
+#include "write_layout.h"
+#include "io_trace.h"
+#include "report.h"
+
+/**
+ * file_uring.c
+ *
+ * Realiza una copia de archivo utilizando io_uring. A diferencia de
+ * file_buffered.c y file_direct.c, que emiten una lectura bloqueante y luego
+ * una escritura bloqueante por cada búfer (profundidad de cola 1), aquí se
+ * mantienen hasta <qd> búferes en vuelo simultáneamente: mientras un búfer se
+ * escribe en el destino, otros se están leyendo del origen. Esto permite que
+ * el dispositivo vea varias peticiones pendientes, que es lo que necesitan los
+ * SSD NVMe para acercarse a su ancho de banda nominal.
+ *
+ * Los búferes y los descriptores se registran en el anillo
+ * (IORING_REGISTER_BUFFERS / IORING_REGISTER_FILES) para que el kernel no
+ * tenga que fijar páginas ni resolver descriptores en cada petición. Si el
+ * registro de búferes falla (p. ej. por RLIMIT_MEMLOCK), se continúa con
+ * operaciones no registradas.
+ *
+ * Se usa la interfaz de llamadas al sistema directamente (sin liburing) para
+ * no añadir dependencias de compilación.
+ *
+ * Referencia teórica: Stallings, Cap. 11.4 (Circular Buffer). Cada búfer del
+ * anillo pasa por los estados "leyendo" y "escribiendo", igual que en el
+ * esquema de búfer circular, pero la concurrencia la gestiona el kernel.
+ *
+ * Argumentos:
+ *  - <fichero_entrada>: Ruta al archivo de origen.
+ *  - <fichero_salida>: Ruta al archivo de destino.
+ *  - <tam_buffer>: Tamaño de cada búfer del anillo en bytes.
+ *  - [--sync]: Opcional. Si se especifica, se llama a fsync() al final.
+ *  - [--qd N]: Opcional. Profundidad de cola (búferes en vuelo). Por defecto 8.
+ *  - [--direct]: Opcional. Abre ambos archivos con O_DIRECT. tam_buffer debe
+ *                ser múltiplo de la alineación de ambos archivos, consultada
+ *                con statx(STATX_DIOALIGN) como en file_direct (ver
+ *                common/dio_align.h).
+ *  - [--prealloc=M] [--fsync=M]: Opcionales. Reserva y volcado a disco del
+ *                                destino (ver common/write_layout.h).
+ *  - [--cold|--warm]: Opcional. Desalojar o precargar solo el archivo de
+ *                     entrada antes de medir (ver common/cache_state.h).
+ *  - [--json] [--json-out F] [--tag K=V]: Opcionales. Resultados en JSON, una
+ *                     línea por bloque con los metadatos de la ejecución (ver common/report.h).
+ */
+
+#define DEFAULT_QUEUE_DEPTH 8
+
+// Índices de los archivos registrados en el anillo
+#define FIXED_FD_IN 0
+#define FIXED_FD_OUT 1
+
+enum slot_state { SLOT_IDLE, SLOT_READING, SLOT_WRITING };
+
+// Un búfer del anillo y la operación que tiene en curso
+struct slot {
+    char *buf;
+    off_t offset;      // Posición del bloque en el archivo
+    size_t len;        // Bytes de datos útiles del bloque
+    size_t io_len;     // Bytes a transferir (len redondeado a offset_align en modo O_DIRECT)
+    size_t done;       // Bytes ya transferidos en la fase actual
+    enum slot_state state;
+};
+
+// Vista en espacio de usuario de las colas de envío y finalización
+struct uring {
+    int fd;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr, *cq_ptr;
+    size_t sq_size, cq_size, sqes_size;
+    unsigned to_submit;
+};
+
+static long submit_calls = 0;
+
+void print_usage(const char *prog_name) {
+    fprintf(stderr, "Uso: %s <fichero_entrada> <fichero_salida> <tam_buffer> [--sync] [--qd N] [--direct] "
+                    WRITE_LAYOUT_USAGE " " CACHE_STATE_USAGE " " REPORT_USAGE "\n", prog_name);
+    fprintf(stderr, "Nota: con --direct, tam_buffer debe ser múltiplo de la alineación O_DIRECT de ambos archivos.\n");
+}
+
+static size_t align_up(size_t len, unsigned align) {
+    return (len + align - 1) / align * align;
+}
+
+static int uring_setup(struct uring *ring, unsigned entries) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(ring, 0, sizeof(*ring));
+
+    ring->fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (ring->fd < 0) {
+        return -1;
+    }
+
+    ring->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    // Con IORING_FEAT_SINGLE_MMAP ambas colas comparten una sola proyección
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_size > ring->sq_size) ring->sq_size = ring->cq_size;
+        ring->cq_size = ring->sq_size;
+    }
+
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) {
+        close(ring->fd);
+        return -1;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else {
+        ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) {
+            munmap(ring->sq_ptr, ring->sq_size);
+            close(ring->fd);
+            return -1;
+        }
+    }
+
+    ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        if (ring->cq_ptr != ring->sq_ptr) munmap(ring->cq_ptr, ring->cq_size);
+        munmap(ring->sq_ptr, ring->sq_size);
+        close(ring->fd);
+        return -1;
+    }
+
+    char *sq = ring->sq_ptr;
+    char *cq = ring->cq_ptr;
+    ring->sq_head = (unsigned *)(sq + p.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + p.sq_off.array);
+    ring->cq_head = (unsigned *)(cq + p.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 0;
+}
+
+static void uring_teardown(struct uring *ring) {
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ptr != ring->sq_ptr) munmap(ring->cq_ptr, ring->cq_size);
+    munmap(ring->sq_ptr, ring->sq_size);
+    close(ring->fd);
+}
+
+// Obtiene la siguiente entrada libre de la cola de envío.
+// Nunca hay más de qd operaciones en vuelo, así que siempre hay hueco.
+static struct io_uring_sqe *uring_get_sqe(struct uring *ring) {
+    unsigned tail = *ring->sq_tail;
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->to_submit++;
+    return sqe;
+}
+
+// Envía las entradas pendientes y espera al menos una finalización
+static int uring_submit_and_wait(struct uring *ring) {
+    int ret;
+    do {
+        ret = IO_TRACE(IO_OP_IO_URING_ENTER, syscall(__NR_io_uring_enter, ring->fd, ring->to_submit, 1, IORING_ENTER_GETEVENTS, NULL, 0));
+        submit_calls++;
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0) {
+        return -1;
+    }
+    ring->to_submit -= ret;
+    return 0;
+}
+
+static void queue_io(struct uring *ring, struct slot *s, int slot_index, int fixed_buffers) {
+    struct io_uring_sqe *sqe = uring_get_sqe(ring);
+    int reading = (s->state == SLOT_READING);
+
+    if (fixed_buffers) {
+        sqe->opcode = reading ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+        sqe->buf_index = slot_index;
+    } else {
+        sqe->opcode = reading ? IORING_OP_READ : IORING_OP_WRITE;
+    }
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->fd = reading ? FIXED_FD_IN : FIXED_FD_OUT;
+    sqe->addr = (unsigned long)(s->buf + s->done);
+    sqe->len = s->io_len - s->done;
+    sqe->off = s->offset + s->done;
+    sqe->user_data = slot_index;
+}
+
+int main(int argc, char *argv[]) {
+    enum cache_state cache_state = CACHE_STATE_DEFAULT;
+    struct write_layout layout;
+    memset(&layout, 0, sizeof(layout));
+    int use_direct = 0;
+    long queue_depth = DEFAULT_QUEUE_DEPTH;
+
+    static struct option long_options[] = {
+        {"sync", no_argument, NULL, 's'},
+        {"direct", no_argument, NULL, 'd'},
+        {"qd", required_argument, NULL, 'q'},
+        WRITE_LAYOUT_LONG_OPTIONS,
+        CACHE_STATE_LONG_OPTIONS,
+        REPORT_LONG_OPTIONS,
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 's': write_layout_set_sync(&layout); break;
+            case 'd': use_direct = 1; break;
+            case 'q': queue_depth = atol(optarg); break;
+            default:
+                if (report_parse_option(opt, optarg) == 1) break;
+                if (cache_state_parse_option(opt, &cache_state)) break;
+                if (write_layout_parse_option(opt, optarg, &layout) == 1) break;
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 3) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    const char *input_path = argv[optind];
+    const char *output_path = argv[optind + 1];
+    long buffer_size = atol(argv[optind + 2]);
+    report_path("Input", input_path);
+    report_path("Output", output_path);
+    report_start(argc, argv);
+
+    if (buffer_size <= 0) {
+        fprintf(stderr, "Error: El tamaño del buffer debe ser un entero positivo.\n");
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (queue_depth <= 0 || queue_depth > 4096) {
+        fprintf(stderr, "Error: La profundidad de cola debe estar entre 1 y 4096.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Estado del cache de la entrada ---
+    struct cache_report cache_report;
+    if (cache_state_prepare(cache_state, input_path, &cache_report) == -1) {
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Apertura de archivos ---
+    int direct_flag = use_direct ? O_DIRECT : 0;
+    int fd_in = open(input_path, O_RDONLY | direct_flag);
+    if (fd_in == -1) {
+        perror("Error al abrir el archivo de entrada");
+        exit(EXIT_FAILURE);
+    }
+
+    int fd_out = open(output_path, O_WRONLY | O_CREAT | O_TRUNC | direct_flag, 0644);
+    if (fd_out == -1) {
+        perror("Error al abrir el archivo de salida");
+        close(fd_in);
+        exit(EXIT_FAILURE);
+    }
+
+    struct stat file_stat;
+    if (fstat(fd_in, &file_stat) == -1) {
+        perror("Error en fstat");
+        close(fd_in);
+        close(fd_out);
+        exit(EXIT_FAILURE);
+    }
+    off_t file_size = file_stat.st_size;
+
+    // --- Alineación exigida por ambos archivos en modo O_DIRECT ---
+    // Sin --direct los búferes se alinean igualmente a página
+    struct dio_align align = { .mem_align = DIO_ALIGN_FALLBACK, .offset_align = 1 };
+    if (use_direct) {
+        struct dio_align out_align;
+        if (dio_align_probe(fd_in, &align) == -1 || dio_align_probe(fd_out, &out_align) == -1) {
+            fprintf(stderr, "Error: El sistema de archivos no admite O_DIRECT para estos archivos.\n");
+            close(fd_in);
+            close(fd_out);
+            exit(EXIT_FAILURE);
+        }
+        dio_align_merge(&align, &out_align);
+
+        if (buffer_size % align.offset_align != 0) {
+            fprintf(stderr, "Error: El tamaño del buffer debe ser un múltiplo de %u.\n", align.offset_align);
+            close(fd_in);
+            close(fd_out);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // --- Asignación de los búferes del anillo (una sola región alineada) ---
+    void *pool;
+    int ret = posix_memalign(&pool, align.mem_align, (size_t)buffer_size * queue_depth);
+    if (ret != 0) {
+        errno = ret;
+        perror("Error en posix_memalign");
+        close(fd_in);
+        close(fd_out);
+        exit(EXIT_FAILURE);
+    }
+
+    struct slot *slots = calloc(queue_depth, sizeof(struct slot));
+    struct iovec *iovecs = calloc(queue_depth, sizeof(struct iovec));
+    if (slots == NULL || iovecs == NULL) {
+        perror("Error al asignar memoria para el anillo");
+        free(pool);
+        close(fd_in);
+        close(fd_out);
+        exit(EXIT_FAILURE);
+    }
+    for (long i = 0; i < queue_depth; i++) {
+        slots[i].buf = (char *)pool + i * buffer_size;
+        slots[i].state = SLOT_IDLE;
+        iovecs[i].iov_base = slots[i].buf;
+        iovecs[i].iov_len = buffer_size;
+    }
+
+    // --- Configuración de io_uring ---
+    struct uring ring;
+    if (uring_setup(&ring, queue_depth) == -1) {
+        perror("Error en io_uring_setup");
+        free(iovecs);
+        free(slots);
+        free(pool);
+        close(fd_in);
+        close(fd_out);
+        exit(EXIT_FAILURE);
+    }
+
+    int fds[2] = { fd_in, fd_out };
+    if (syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_FILES, fds, 2) == -1) {
+        perror("Error al registrar los descriptores en io_uring");
+        uring_teardown(&ring);
+        free(iovecs);
+        free(slots);
+        free(pool);
+        close(fd_in);
+        close(fd_out);
+        exit(EXIT_FAILURE);
+    }
+
+    int fixed_buffers = 1;
+    if (syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_BUFFERS, iovecs, queue_depth) == -1) {
+        // No es fatal: se usan lecturas/escrituras no registradas.
+        perror("Aviso: no se pudieron registrar los búferes en io_uring");
+        fixed_buffers = 0;
+    }
+
+    // --- Medición de tiempo y copia ---
+    struct timespec start, end;
+    long read_ops = 0;
+    long write_ops = 0;
+    off_t next_offset = 0;
+    long inflight = 0;
+    int failed = 0;
+
+    io_trace_begin();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (write_layout_begin(&layout, fd_out, file_size) == -1) {
+        failed = 1;
+    }
+
+    // Cebar el anillo: una lectura por búfer mientras quede archivo
+    for (long i = 0; !failed && i < queue_depth && next_offset < file_size; i++) {
+        struct slot *s = &slots[i];
+        s->offset = next_offset;
+        s->len = (file_size - next_offset < buffer_size) ? (size_t)(file_size - next_offset) : (size_t)buffer_size;
+        s->io_len = align_up(s->len, align.offset_align);
+        s->done = 0;
+        s->state = SLOT_READING;
+        next_offset += s->len;
+        queue_io(&ring, s, i, fixed_buffers);
+        read_ops++;
+        inflight++;
+    }
+
+    while (inflight > 0 && !failed) {
+        if (uring_submit_and_wait(&ring) == -1) {
+            perror("Error en io_uring_enter");
+            failed = 1;
+            break;
+        }
+
+        unsigned head = *ring.cq_head;
+        unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+            long index = (long)cqe->user_data;
+            int res = cqe->res;
+            struct slot *s = &slots[index];
+
+            if (res == -EAGAIN || res == -EINTR) {
+                // Reintentar la misma operación (es otro SQE: cuenta como operación)
+                queue_io(&ring, s, index, fixed_buffers);
+                if (s->state == SLOT_READING) {
+                    read_ops++;
+                } else {
+                    write_ops++;
+                }
+                continue;
+            }
+            if (res < 0) {
+                errno = -res;
+                perror(s->state == SLOT_READING ? "Error de lectura" : "Error de escritura");
+                failed = 1;
+                break;
+            }
+
+            if (s->state == SLOT_READING) {
+                s->done += res;
+                if (s->done < s->len) {
+                    if (res == 0) {
+                        fprintf(stderr, "Error: fin de archivo inesperado en el offset %ld\n",
+                                (long)(s->offset + s->done));
+                        failed = 1;
+                        break;
+                    }
+                    if (use_direct) {
+                        // Con O_DIRECT el resto empezaría en un offset y una dirección
+                        // no alineados, y el kernel lo rechazaría con EINVAL
+                        fprintf(stderr, "Error: Lectura corta antes del final del archivo de entrada (offset %ld).\n",
+                                (long)(s->offset + s->done));
+                        failed = 1;
+                        break;
+                    }
+                    // Lectura corta: pedir el resto del bloque
+                    queue_io(&ring, s, index, fixed_buffers);
+                    read_ops++;
+                    continue;
+                }
+                // Bloque completo: pasa a escribirse en el mismo offset
+                s->state = SLOT_WRITING;
+                s->done = 0;
+                queue_io(&ring, s, index, fixed_buffers);
+                write_ops++;
+            } else {
+                s->done += res;
+                if (s->done < s->io_len) {
+                    if (res == 0) {
+                        fprintf(stderr, "Error de escritura incompleta\n");
+                        failed = 1;
+                        break;
+                    }
+                    queue_io(&ring, s, index, fixed_buffers);
+                    write_ops++;
+                    continue;
+                }
+                if (write_layout_wrote(&layout, fd_out, s->len) == -1) {
+                    failed = 1;
+                    break;
+                }
+                // Búfer libre: reutilizarlo para el siguiente bloque pendiente
+                if (next_offset < file_size) {
+                    s->offset = next_offset;
+                    s->len = (file_size - next_offset < buffer_size) ? (size_t)(file_size - next_offset) : (size_t)buffer_size;
+                    s->io_len = align_up(s->len, align.offset_align);
+                    s->done = 0;
+                    s->state = SLOT_READING;
+                    next_offset += s->len;
+                    queue_io(&ring, s, index, fixed_buffers);
+                    read_ops++;
+                } else {
+                    s->state = SLOT_IDLE;
+                    inflight--;
+                }
+            }
+        }
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    // En modo O_DIRECT el último bloque se escribe rellenado hasta
+    // offset_align y después se recorta el archivo a su tamaño real.
+    if (!failed && file_size % align.offset_align != 0) {
+        if (ftruncate(fd_out, file_size) == -1) {
+            perror("Error en ftruncate");
+            failed = 1;
+        }
+    }
+
+    if (!failed) {
+        write_layout_finish(&layout, fd_out);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    io_trace_end();
+
+    // --- Cálculo de tiempo y resultados ---
+    double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    write_layout_report(&layout, fd_out);
+
+    // --- Limpieza ---
+    uring_teardown(&ring);
+    free(iovecs);
+    free(slots);
+    free(pool);
+    close(fd_in);
+    close(fd_out);
+
+    if (failed) {
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Imprimir resultados para el parser ---
+    printf("Mechanism: io_uring\n");
+    printf("BufferSize: %ld\n", buffer_size);
+    printf("SyncMode: %s\n", write_layout_syncs(&layout) ? "sync" : "nosync");
+    printf("TimeTaken: %.6f\n", time_taken);
+    cache_state_print(&cache_report);
+    write_layout_print(&layout);
+    printf("QueueDepth: %ld\n", queue_depth);
+    printf("DirectIO: %s\n", use_direct ? "yes" : "no");
+    if (use_direct) {
+        printf("DioMemAlign: %u\n", align.mem_align);
+        printf("DioOffsetAlign: %u\n", align.offset_align);
+        printf("DioAlignSource: %s\n", align.from_statx ? "statx" : "fallback");
+    }
+    printf("RegisteredBuffers: %s\n", fixed_buffers ? "yes" : "no");
+    printf("ReadOps: %ld\n", read_ops);
+    printf("WriteOps: %ld\n", write_ops);
+    printf("SubmitCalls: %ld\n", submit_calls);
+    io_trace_print();
+
+    return 0;
+}
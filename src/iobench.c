@@ -0,0 +1,593 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <getopt.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <math.h>
+
+#include "cache_state.h"
+#include "write_layout.h"
+#include "iobench/engine.h"
+#include "report.h"
+#include "stats.h"
+
+/**
+ * iobench.c
+ *
+ * Copia de archivos con varios motores en un solo proceso. Los programas
+ * file_* repiten cada uno el análisis de argumentos, la apertura, la medición
+ * y el bloque de resultados; aquí todo eso es común y cada mecanismo es un
+ * motor de src/iobench (ver iobench/engine.h) que solo implementa la copia.
+ *
+ * Un barrido (motores x tamaños de búfer x repeticiones) se ejecuta sin
+ * lanzar un proceso por prueba ni esperar entre ellas. Como no hay
+ * drop_caches entre ejecuciones, --cold es el equivalente dentro del
+ * proceso: desaloja el archivo de entrada antes de cada una.
+ *
+ * Cada ejecución imprime un bloque Clave: valor con las mismas claves que
+ * los programas file_* (bloques separados por una línea en blanco). Con
+ * --results-dir, cada bloque se guarda en
+ *   <dir>/iobench_<motor>/<tamaño>/<buf>KB/<sync|nosync>/run_<n>/app.log
+ * que es el árbol que recorre stats_parser.py.
+ *
+ * Repeticiones adaptativas: con --ci-target P cada combinación se repite
+ * hasta que la semiamplitud del intervalo de confianza del 95% (t de
+ * Student) del rendimiento sea como mucho el P% de la media, con un mínimo
+ * de --repetitions (al menos 3) y un máximo de --max-repetitions. Las
+ * combinaciones estables terminan pronto y las ruidosas siguen hasta
+ * converger o agotar el máximo. Antes de medir, --warmup N ejecuta N veces
+ * cada combinación sin registrar nada (cache, asignación de bloques,
+ * frecuencia de la CPU).
+ *
+ * Al final, si hubo más de una repetición, se imprime un bloque de resumen
+ * por combinación (con --results-dir, en .../<sync|nosync>/summary.log):
+ * mediana, cuartiles e IQR del rendimiento, y media, desviación e intervalo
+ * de confianza calculados sin los valores atípicos (fuera de Q1 - 1.5 IQR y
+ * Q3 + 1.5 IQR, con al menos 5 ejecuciones), que se cuentan en Outliers.
+ *
+ * Argumentos:
+ *  - <fichero_entrada>: Ruta al archivo de origen.
+ *  - <fichero_salida>: Ruta al archivo de destino (se reescribe en cada ejecución).
+ *  - [--engine L]: Opcional. Motores separados por comas. Por defecto todos.
+ *  - [--buffer-sizes L]: Opcional. Tamaños de búfer en bytes separados por
+ *                        comas (admiten sufijo K o M). Por defecto 65536.
+ *  - [--repetitions N]: Opcional. Repeticiones de cada combinación. Por defecto 1.
+ *                       Con --ci-target, el mínimo.
+ *  - [--ci-target P]: Opcional. Repetir hasta que el IC95 sea como mucho el P% de la media.
+ *  - [--max-repetitions M]: Opcional. Máximo de repeticiones con --ci-target. Por defecto 30.
+ *  - [--warmup N]: Opcional. Ejecuciones sin medir de cada combinación. Por defecto 0.
+ *  - [--sync]: Opcional. fsync() al final de cada copia.
+ *  - [--results-dir D]: Opcional. Guardar cada bloque en el árbol de resultados.
+ *  - [--size-label S]: Opcional. Nombre del tamaño en ese árbol (p. ej. 100M).
+ *                      Por defecto se deduce del tamaño de la entrada.
+ *  - [--list]: Opcional. Mostrar los motores disponibles y salir.
+ *  - [--prealloc=M] [--fsync=M]: Opcionales. Reserva y volcado a disco del
+ *                                destino (ver common/write_layout.h).
+ *  - [--cold|--warm]: Opcional. Desalojar o precargar solo el archivo de
+ *                     entrada antes de cada ejecución (ver common/cache_state.h).
+ *  - [--json] [--json-out F] [--tag K=V]: Opcionales. Resultados en JSON, una
+ *                     línea por bloque con los metadatos de la ejecución (ver common/report.h).
+ */
+
+#define MAX_ENGINES 16
+#define MAX_BUFFER_SIZES 32
+#define MIN_ADAPTIVE_REPETITIONS 3
+
+void print_usage(const char *prog_name) {
+    fprintf(stderr, "Uso: %s <fichero_entrada> <fichero_salida> [--engine L] [--buffer-sizes L] [--repetitions N] "
+                    "[--ci-target P] [--max-repetitions M] [--warmup N] [--sync] [--results-dir D] [--size-label S] [--list] "
+                    WRITE_LAYOUT_USAGE " " CACHE_STATE_USAGE " " REPORT_USAGE "\n", prog_name);
+}
+
+static void list_engines(void) {
+    for (int i = 0; io_engines[i] != NULL; i++) {
+        printf("%-16s %s\n", io_engines[i]->name, io_engines[i]->mechanism);
+    }
+}
+
+// Convierte "64K", "1M" o "4096" a bytes; -1 si no es válido
+static long parse_size(const char *s) {
+    char *end;
+    long v = strtol(s, &end, 10);
+    if (end == s || v <= 0) return -1;
+    if (*end == 'K' || *end == 'k') { v *= 1024; end++; }
+    else if (*end == 'M' || *end == 'm') { v *= 1024 * 1024; end++; }
+    return *end == '\0' ? v : -1;
+}
+
+// Nombre del tamaño como en test_data (10M, 1G...); bytes si no es exacto
+static void size_label(off_t size, char *out, size_t len) {
+    if (size > 0 && size % (1024L * 1024 * 1024) == 0) {
+        snprintf(out, len, "%ldG", (long)(size / (1024L * 1024 * 1024)));
+    } else if (size > 0 && size % (1024L * 1024) == 0) {
+        snprintf(out, len, "%ldM", (long)(size / (1024L * 1024)));
+    } else if (size > 0 && size % 1024 == 0) {
+        snprintf(out, len, "%ldK", (long)(size / 1024));
+    } else {
+        snprintf(out, len, "%ld", (long)size);
+    }
+}
+
+// mkdir -p
+static int make_dirs(const char *path) {
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s", path);
+    for (char *p = tmp + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(tmp, 0755) == -1 && errno != EEXIST) return -1;
+            *p = '/';
+        }
+    }
+    if (mkdir(tmp, 0755) == -1 && errno != EEXIST) return -1;
+    return 0;
+}
+
+static double timeval_to_sec(const struct timeval *tv) {
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+// Valor crítico de la t de Student a dos colas para el 95%
+static double t_critical_95(int df) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+    };
+    if (df < 1) return NAN;
+    if (df <= 30) return table[df - 1];
+    return 1.96 + 2.4 / df; // Aproximación, error < 0.005 para df > 30
+}
+
+// Rendimientos (MB/s) de una combinación motor x búfer y su resumen
+struct config_stats {
+    double *throughput;
+    int runs;
+    int converged;
+    // Calculado por config_summarize()
+    double median, q1, q3;
+    double mean, stddev, ci95;
+    int outliers;
+};
+
+static void config_summarize(struct config_stats *c) {
+    int n = c->runs;
+    double *sorted = malloc(n * sizeof(double));
+    if (sorted == NULL) return;
+    memcpy(sorted, c->throughput, n * sizeof(double));
+    qsort(sorted, n, sizeof(double), compare_doubles);
+    c->median = percentile_interp(sorted, n, 50);
+    c->q1 = percentile_interp(sorted, n, 25);
+    c->q3 = percentile_interp(sorted, n, 75);
+
+    // Valores atípicos: fuera de las vallas de Tukey (con pocas ejecuciones
+    // los cuartiles no significan nada y no se descarta ninguna)
+    double lo = -INFINITY, hi = INFINITY;
+    if (n >= 5) {
+        lo = c->q1 - 1.5 * (c->q3 - c->q1);
+        hi = c->q3 + 1.5 * (c->q3 - c->q1);
+    }
+    double sum = 0, sum_sq = 0;
+    int kept = 0;
+    for (int i = 0; i < n; i++) {
+        if (sorted[i] < lo || sorted[i] > hi) continue;
+        sum += sorted[i];
+        kept++;
+    }
+    c->outliers = n - kept;
+    c->mean = kept ? sum / kept : 0.0;
+    for (int i = 0; i < n; i++) {
+        if (sorted[i] < lo || sorted[i] > hi) continue;
+        sum_sq += (sorted[i] - c->mean) * (sorted[i] - c->mean);
+    }
+    c->stddev = kept > 1 ? sqrt(sum_sq / (kept - 1)) : 0.0;
+    c->ci95 = kept > 1 ? t_critical_95(kept - 1) * c->stddev / sqrt(kept) : NAN;
+    free(sorted);
+}
+
+// Resultado de una ejecución, impreso después de cerrar los archivos
+struct run_result {
+    double time_taken;
+    double user_time;
+    double sys_time;
+    long major_faults;
+    long minor_faults;
+    struct cache_report cache;
+};
+
+// Una ejecución completa de un motor. Devuelve 0 o -1.
+static int run_once(const struct io_engine *eng, struct io_job *job, enum cache_state cache_state,
+                    struct run_result *res) {
+    if (cache_state_prepare(cache_state, job->input_path, &res->cache) == -1) {
+        return -1;
+    }
+
+    job->fd_in = job->fd_out = -1;
+    if ((eng->open ? eng->open(job) : engine_open_default(job)) == -1) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(job->fd_in, &st) == -1) {
+        perror("Error en fstat");
+        close(job->fd_in);
+        close(job->fd_out);
+        return -1;
+    }
+    job->file_size = st.st_size;
+    job->priv = NULL;
+    if (eng->prepare && eng->prepare(job) == -1) {
+        close(job->fd_in);
+        close(job->fd_out);
+        return -1;
+    }
+
+    // --- Medición de tiempo y copia ---
+    struct timespec start, end;
+    struct rusage ru_start, ru_end;
+    io_trace_begin();
+    getrusage(RUSAGE_SELF, &ru_start);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int failed = write_layout_begin(job->layout, job->fd_out, job->file_size) == -1;
+    if (!failed) {
+        failed = eng->transfer(job) == -1;
+    }
+    if (!failed) {
+        write_layout_finish(job->layout, job->fd_out);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    getrusage(RUSAGE_SELF, &ru_end);
+    io_trace_end();
+
+    res->time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    res->user_time = timeval_to_sec(&ru_end.ru_utime) - timeval_to_sec(&ru_start.ru_utime);
+    res->sys_time = timeval_to_sec(&ru_end.ru_stime) - timeval_to_sec(&ru_start.ru_stime);
+    res->major_faults = ru_end.ru_majflt - ru_start.ru_majflt;
+    res->minor_faults = ru_end.ru_minflt - ru_start.ru_minflt;
+
+    if (!failed) {
+        write_layout_report(job->layout, job->fd_out);
+    }
+    close(job->fd_in);
+    close(job->fd_out);
+    if (failed && eng->finish) {
+        eng->finish(job);
+    }
+    return failed ? -1 : 0;
+}
+
+static void print_result(const struct io_engine *eng, const struct io_job *job, const struct run_result *res,
+                         int repetition) {
+    printf("Mechanism: %s\n", eng->mechanism);
+    printf("Engine: %s\n", eng->name);
+    printf("BufferSize: %ld\n", job->buffer_size);
+    printf("SyncMode: %s\n", write_layout_syncs(job->layout) ? "sync" : "nosync");
+    printf("TimeTaken: %.6f\n", res->time_taken);
+    cache_state_print(&res->cache);
+    write_layout_print(job->layout);
+    printf("Repetition: %d\n", repetition);
+    printf("BytesCopied: %lld\n", job->bytes_copied);
+    printf("ReadCalls: %ld\n", job->read_calls);
+    printf("WriteCalls: %ld\n", job->write_calls);
+    printf("EngineCalls: %ld\n", job->other_calls);
+    printf("UserTime: %.6f\n", res->user_time);
+    printf("SysTime: %.6f\n", res->sys_time);
+    printf("CpuNsPerByte: %.4f\n",
+           job->bytes_copied > 0 ? (res->user_time + res->sys_time) * 1e9 / job->bytes_copied : 0.0);
+    printf("MajorFaults: %ld\n", res->major_faults);
+    printf("MinorFaults: %ld\n", res->minor_faults);
+    if (eng->print) {
+        eng->print(job);
+    }
+    io_trace_print();
+}
+
+static void print_summary(const struct io_engine *eng, long buffer_size, const struct write_layout *layout,
+                          const struct config_stats *c, long warmup, double ci_target) {
+    printf("Mechanism: %s\n", eng->mechanism);
+    printf("Engine: %s\n", eng->name);
+    printf("BufferSize: %ld\n", buffer_size);
+    printf("SyncMode: %s\n", write_layout_syncs(layout) ? "sync" : "nosync");
+    printf("WarmupRuns: %ld\n", warmup);
+    printf("Runs: %d\n", c->runs);
+    printf("Outliers: %d\n", c->outliers);
+    if (ci_target > 0) {
+        printf("CiTargetPct: %.2f\n", ci_target);
+        printf("Converged: %s\n", c->converged ? "yes" : "no");
+    }
+    printf("ThroughputMedianMBs: %.2f\n", c->median);
+    printf("ThroughputQ1MBs: %.2f\n", c->q1);
+    printf("ThroughputQ3MBs: %.2f\n", c->q3);
+    printf("ThroughputIqrMBs: %.2f\n", c->q3 - c->q1);
+    printf("ThroughputMeanMBs: %.2f\n", c->mean);
+    printf("ThroughputStdMBs: %.2f\n", c->stddev);
+    printf("ThroughputCi95MBs: %.2f\n", c->ci95);
+    printf("ThroughputCi95Pct: %.2f\n", c->mean > 0 ? 100.0 * c->ci95 / c->mean : NAN);
+}
+
+// Redirige stdout a <dir>/<name> (los motores imprimen con printf()).
+// Devuelve el descriptor del stdout anterior para stdout_restore(), o -1.
+static int stdout_to_file(const char *dir, const char *name) {
+    if (make_dirs(dir) == -1) {
+        perror("Error al crear el directorio de resultados");
+        return -1;
+    }
+    char path[4200];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        perror("Error al abrir el archivo de resultados");
+        return -1;
+    }
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    dup2(fd, STDOUT_FILENO);
+    close(fd);
+    return saved;
+}
+
+static void stdout_restore(int saved) {
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+}
+
+// Imprime el bloque en <dir>/iobench_<motor>/<tamaño>/<buf>KB/<sync>/run_<n>/app.log
+static int save_result(const char *results_dir, const char *label, const struct io_engine *eng,
+                       const struct io_job *job, const struct run_result *res, int repetition) {
+    char dir[4096];
+    snprintf(dir, sizeof(dir), "%s/iobench_%s/%s/%ldKB/%s/run_%d", results_dir, eng->name, label,
+             job->buffer_size / 1024, write_layout_syncs(job->layout) ? "sync" : "nosync", repetition);
+    int saved = stdout_to_file(dir, "app.log");
+    if (saved == -1) return -1;
+    print_result(eng, job, res, repetition);
+    stdout_restore(saved);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    enum cache_state cache_state = CACHE_STATE_DEFAULT;
+    struct write_layout layout;
+    memset(&layout, 0, sizeof(layout));
+    const struct io_engine *engines[MAX_ENGINES];
+    int engine_count = 0;
+    long buffer_sizes[MAX_BUFFER_SIZES];
+    int buffer_count = 0;
+    long repetitions = 1;
+    long max_repetitions = 30;
+    long warmup = 0;
+    double ci_target = 0; // 0: número fijo de repeticiones
+    const char *results_dir = NULL;
+    const char *label_arg = NULL;
+
+    static struct option long_options[] = {
+        {"engine", required_argument, NULL, 'e'},
+        {"buffer-sizes", required_argument, NULL, 'b'},
+        {"repetitions", required_argument, NULL, 'r'},
+        {"ci-target", required_argument, NULL, 'c'},
+        {"max-repetitions", required_argument, NULL, 'm'},
+        {"warmup", required_argument, NULL, 'w'},
+        {"sync", no_argument, NULL, 's'},
+        {"results-dir", required_argument, NULL, 'd'},
+        {"size-label", required_argument, NULL, 'l'},
+        {"list", no_argument, NULL, 'L'},
+        WRITE_LAYOUT_LONG_OPTIONS,
+        CACHE_STATE_LONG_OPTIONS,
+        REPORT_LONG_OPTIONS,
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'e': {
+                char *list = strdup(optarg);
+                for (char *tok = strtok(list, ","); tok != NULL; tok = strtok(NULL, ",")) {
+                    const struct io_engine *eng = engine_find(tok);
+                    if (eng == NULL) {
+                        fprintf(stderr, "Error: Motor desconocido '%s' (ver --list).\n", tok);
+                        exit(EXIT_FAILURE);
+                    }
+                    if (engine_count == MAX_ENGINES) {
+                        fprintf(stderr, "Error: Demasiados motores (máximo %d).\n", MAX_ENGINES);
+                        exit(EXIT_FAILURE);
+                    }
+                    engines[engine_count++] = eng;
+                }
+                free(list);
+                break;
+            }
+            case 'b': {
+                char *list = strdup(optarg);
+                for (char *tok = strtok(list, ","); tok != NULL; tok = strtok(NULL, ",")) {
+                    long size = parse_size(tok);
+                    if (size <= 0) {
+                        fprintf(stderr, "Error: Tamaño de buffer no válido '%s'.\n", tok);
+                        exit(EXIT_FAILURE);
+                    }
+                    if (buffer_count == MAX_BUFFER_SIZES) {
+                        fprintf(stderr, "Error: Demasiados tamaños de buffer (máximo %d).\n", MAX_BUFFER_SIZES);
+                        exit(EXIT_FAILURE);
+                    }
+                    buffer_sizes[buffer_count++] = size;
+                }
+                free(list);
+                break;
+            }
+            case 'r': repetitions = atol(optarg); break;
+            case 'c': ci_target = atof(optarg); break;
+            case 'm': max_repetitions = atol(optarg); break;
+            case 'w': warmup = atol(optarg); break;
+            case 's': write_layout_set_sync(&layout); break;
+            case 'd': results_dir = optarg; break;
+            case 'l': label_arg = optarg; break;
+            case 'L':
+                list_engines();
+                return 0;
+            default:
+                if (report_parse_option(opt, optarg) == 1) break;
+                if (cache_state_parse_option(opt, &cache_state)) break;
+                if (write_layout_parse_option(opt, optarg, &layout) == 1) break;
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 2) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (repetitions <= 0) {
+        fprintf(stderr, "Error: --repetitions debe ser un entero positivo.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (ci_target < 0 || warmup < 0) {
+        fprintf(stderr, "Error: --ci-target y --warmup no pueden ser negativos.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (ci_target > 0) {
+        if (repetitions < MIN_ADAPTIVE_REPETITIONS) {
+            repetitions = MIN_ADAPTIVE_REPETITIONS;
+        }
+        if (max_repetitions < repetitions) {
+            fprintf(stderr, "Error: --max-repetitions debe ser al menos %ld.\n", repetitions);
+            exit(EXIT_FAILURE);
+        }
+    } else {
+        max_repetitions = repetitions;
+    }
+
+    const char *input_path = argv[optind];
+    const char *output_path = argv[optind + 1];
+    report_path("Input", input_path);
+    report_path("Output", output_path);
+    report_start(argc, argv);
+
+    if (engine_count == 0) {
+        for (int i = 0; io_engines[i] != NULL && engine_count < MAX_ENGINES; i++) {
+            engines[engine_count++] = io_engines[i];
+        }
+    }
+    if (buffer_count == 0) {
+        buffer_sizes[buffer_count++] = 65536;
+    }
+
+    char label[32];
+    if (label_arg != NULL) {
+        snprintf(label, sizeof(label), "%s", label_arg);
+    } else {
+        struct stat st;
+        if (stat(input_path, &st) == -1) {
+            perror("Error al abrir el archivo de entrada");
+            exit(EXIT_FAILURE);
+        }
+        size_label(st.st_size, label, sizeof(label));
+    }
+
+    struct config_stats *configs = calloc(engine_count * buffer_count, sizeof(*configs));
+    if (configs == NULL) {
+        perror("Error al asignar memoria");
+        exit(EXIT_FAILURE);
+    }
+    for (int c = 0; c < engine_count * buffer_count; c++) {
+        configs[c].throughput = malloc(max_repetitions * sizeof(double));
+        if (configs[c].throughput == NULL) {
+            perror("Error al asignar memoria");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // --- Barrido: repeticiones x motores x tamaños de búfer ---
+    // Las repeticiones van por fuera para que las de una misma combinación no
+    // se ejecuten seguidas con el sistema en el mismo estado. Las rondas de
+    // calentamiento (rep <= 0) no se registran.
+    int first_block = 1;
+    for (long rep = 1 - warmup; rep <= max_repetitions; rep++) {
+        int pending = 0;
+        for (int e = 0; e < engine_count; e++) {
+            for (int b = 0; b < buffer_count; b++) {
+                struct config_stats *cfg = &configs[e * buffer_count + b];
+                if (cfg->converged) continue;
+
+                const struct io_engine *eng = engines[e];
+                struct io_job job;
+                memset(&job, 0, sizeof(job));
+                job.input_path = input_path;
+                job.output_path = output_path;
+                job.buffer_size = buffer_sizes[b];
+                job.layout = &layout;
+
+                struct run_result res;
+                if (run_once(eng, &job, cache_state, &res) == -1) {
+                    fprintf(stderr, "Error: Falló el motor %s con buffer %ld.\n", eng->name, job.buffer_size);
+                    exit(EXIT_FAILURE);
+                }
+                if (rep <= 0) {
+                    if (eng->finish) eng->finish(&job);
+                    continue;
+                }
+                cfg->throughput[cfg->runs++] =
+                    res.time_taken > 0 ? job.bytes_copied / (1024.0 * 1024.0) / res.time_taken : 0.0;
+
+                if (results_dir != NULL &&
+                    save_result(results_dir, label, eng, &job, &res, (int)rep) == -1) {
+                    if (eng->finish) eng->finish(&job);
+                    exit(EXIT_FAILURE);
+                }
+                // Con JSON cada bloque también va a stdout, donde se convierte en una línea
+                if (results_dir == NULL || report_json_enabled()) {
+                    if (!first_block) printf("\n");
+                    print_result(eng, &job, &res, (int)rep);
+                    fflush(stdout);
+                }
+                first_block = 0;
+                if (eng->finish) {
+                    eng->finish(&job);
+                }
+
+                if (ci_target > 0 && rep >= repetitions) {
+                    config_summarize(cfg);
+                    cfg->converged = cfg->mean > 0 && 100.0 * cfg->ci95 / cfg->mean <= ci_target;
+                }
+                pending += !cfg->converged;
+            }
+        }
+        if (rep > 0 && pending == 0) break;
+    }
+
+    // --- Resumen por combinación ---
+    if (max_repetitions > 1) {
+        for (int e = 0; e < engine_count; e++) {
+            for (int b = 0; b < buffer_count; b++) {
+                struct config_stats *cfg = &configs[e * buffer_count + b];
+                config_summarize(cfg);
+                if (results_dir != NULL) {
+                    char dir[4096];
+                    snprintf(dir, sizeof(dir), "%s/iobench_%s/%s/%ldKB/%s", results_dir, engines[e]->name, label,
+                             buffer_sizes[b] / 1024, write_layout_syncs(&layout) ? "sync" : "nosync");
+                    int saved = stdout_to_file(dir, "summary.log");
+                    if (saved == -1) exit(EXIT_FAILURE);
+                    print_summary(engines[e], buffer_sizes[b], &layout, cfg, warmup, ci_target);
+                    stdout_restore(saved);
+                }
+                if (results_dir == NULL || report_json_enabled()) {
+                    printf("\n");
+                    print_summary(engines[e], buffer_sizes[b], &layout, cfg, warmup, ci_target);
+                    fflush(stdout);
+                }
+            }
+        }
+    }
+
+    for (int c = 0; c < engine_count * buffer_count; c++) {
+        free(configs[c].throughput);
+    }
+    free(configs);
+    return 0;
+}
@@ -0,0 +1,67 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "engine.h"
+
+/**
+ * eng_buffered.c
+ *
+ * Motor "buffered": bucle read()/write() con un búfer de usuario, igual que
+ * file_buffered sin opciones.
+ */
+
+static int buffered_prepare(struct io_job *job) {
+    job->priv = malloc(job->buffer_size);
+    if (job->priv == NULL) {
+        perror("Error al asignar memoria para el buffer");
+        return -1;
+    }
+    return 0;
+}
+
+static int buffered_transfer(struct io_job *job) {
+    char *buffer = job->priv;
+    ssize_t bytes_read;
+
+    while ((bytes_read = IO_TRACE(IO_OP_READ, read(job->fd_in, buffer, job->buffer_size))) != 0) {
+        job->read_calls++;
+        if (bytes_read == -1) {
+            if (errno == EINTR) continue;
+            perror("Error de lectura");
+            return -1;
+        }
+        ssize_t done = 0;
+        while (done < bytes_read) {
+            ssize_t n = IO_TRACE(IO_OP_WRITE, write(job->fd_out, buffer + done, bytes_read - done));
+            job->write_calls++;
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                perror("Error de escritura");
+                return -1;
+            }
+            done += n;
+        }
+        job->bytes_copied += bytes_read;
+        if (write_layout_wrote(job->layout, job->fd_out, bytes_read) == -1) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void buffered_finish(struct io_job *job) {
+    free(job->priv);
+}
+
+const struct io_engine engine_buffered = {
+    .name = "buffered",
+    .mechanism = "Buffered I/O",
+    .open = engine_open_default,
+    .prepare = buffered_prepare,
+    .transfer = buffered_transfer,
+    .finish = buffered_finish,
+    .print = NULL,
+};
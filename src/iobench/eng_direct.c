@@ -0,0 +1,134 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "engine.h"
+#include "dio_align.h"
+
+/**
+ * eng_direct.c
+ *
+ * Motor "direct": read()/write() con O_DIRECT sobre un búfer alineado, igual
+ * que file_direct en su modo serial. La alineación se consulta con
+ * dio_align_probe() y la cola no alineada se escribe rellenada y se recorta
+ * con ftruncate() (--tail pad de file_direct).
+ */
+
+struct direct_state {
+    char *buffer;
+    struct dio_align align;
+    long tail_bytes;
+};
+
+static int direct_open(struct io_job *job) {
+    return engine_open_files(job, O_DIRECT);
+}
+
+static int direct_prepare(struct io_job *job) {
+    struct direct_state *st = calloc(1, sizeof(*st));
+    if (st == NULL) {
+        perror("Error al asignar memoria");
+        return -1;
+    }
+    struct dio_align out_align;
+    if (dio_align_probe(job->fd_in, &st->align) == -1 || dio_align_probe(job->fd_out, &out_align) == -1) {
+        fprintf(stderr, "Error: El sistema de archivos no admite O_DIRECT para estos archivos.\n");
+        free(st);
+        return -1;
+    }
+    dio_align_merge(&st->align, &out_align);
+    if (job->buffer_size % st->align.offset_align != 0) {
+        fprintf(stderr, "Error: Con el motor direct el tamaño del buffer debe ser un múltiplo de %u.\n",
+                st->align.offset_align);
+        free(st);
+        return -1;
+    }
+    void *buffer;
+    int ret = posix_memalign(&buffer, st->align.mem_align, job->buffer_size);
+    if (ret != 0) {
+        errno = ret;
+        perror("Error en posix_memalign");
+        free(st);
+        return -1;
+    }
+    st->buffer = buffer;
+    job->priv = st;
+    return 0;
+}
+
+static int direct_transfer(struct io_job *job) {
+    struct direct_state *st = job->priv;
+    ssize_t bytes_read;
+
+    while ((bytes_read = IO_TRACE(IO_OP_READ, read(job->fd_in, st->buffer, job->buffer_size))) != 0) {
+        job->read_calls++;
+        if (bytes_read == -1) {
+            if (errno == EINTR) continue;
+            perror("Error de lectura");
+            return -1;
+        }
+        if (st->tail_bytes > 0) {
+            fprintf(stderr, "Error: Lectura corta antes del final del archivo de entrada.\n");
+            return -1;
+        }
+        size_t write_len = bytes_read;
+        long unaligned = bytes_read % st->align.offset_align;
+        if (unaligned != 0) {
+            st->tail_bytes = unaligned;
+            write_len = bytes_read - unaligned + st->align.offset_align;
+            memset(st->buffer + bytes_read, 0, write_len - bytes_read);
+        }
+        size_t done = 0;
+        while (done < write_len) {
+            ssize_t n = IO_TRACE(IO_OP_WRITE, write(job->fd_out, st->buffer + done, write_len - done));
+            job->write_calls++;
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                perror("Error de escritura");
+                return -1;
+            }
+            done += n;
+        }
+        job->bytes_copied += bytes_read;
+        if (write_layout_wrote(job->layout, job->fd_out, bytes_read) == -1) {
+            return -1;
+        }
+    }
+
+    // Recortar el relleno de la última escritura
+    if (st->tail_bytes > 0) {
+        job->other_calls++;
+        if (ftruncate(job->fd_out, job->bytes_copied) == -1) {
+            perror("Error en ftruncate del archivo de salida");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void direct_finish(struct io_job *job) {
+    struct direct_state *st = job->priv;
+    free(st->buffer);
+    free(st);
+}
+
+static void direct_print(const struct io_job *job) {
+    const struct direct_state *st = job->priv;
+    printf("DioMemAlign: %u\n", st->align.mem_align);
+    printf("DioOffsetAlign: %u\n", st->align.offset_align);
+    printf("TailBytes: %ld\n", st->tail_bytes);
+}
+
+const struct io_engine engine_direct = {
+    .name = "direct",
+    .mechanism = "Direct I/O",
+    .open = direct_open,
+    .prepare = direct_prepare,
+    .transfer = direct_transfer,
+    .finish = direct_finish,
+    .print = direct_print,
+};
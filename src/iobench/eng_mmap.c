@@ -0,0 +1,63 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+#include "engine.h"
+
+/**
+ * eng_mmap.c
+ *
+ * Motor "mmap": el origen se proyecta completo y se escribe con write()
+ * directamente desde la proyección, en bloques de buffer_size (file_mmap
+ * --method write). mmap() y munmap() quedan dentro del intervalo medido.
+ */
+
+static int mmap_transfer(struct io_job *job) {
+    if (job->file_size == 0) {
+        return 0;
+    }
+    char *src = mmap(NULL, job->file_size, PROT_READ, MAP_SHARED, job->fd_in, 0);
+    job->other_calls++;
+    if (src == MAP_FAILED) {
+        perror("Error en mmap del archivo de entrada");
+        return -1;
+    }
+
+    int failed = 0;
+    off_t copied = 0;
+    while (copied < job->file_size) {
+        size_t chunk = (job->file_size - copied < job->buffer_size) ? (size_t)(job->file_size - copied)
+                                                                    : (size_t)job->buffer_size;
+        ssize_t n = IO_TRACE(IO_OP_WRITE, write(job->fd_out, src + copied, chunk));
+        job->write_calls++;
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            perror("Error de escritura");
+            failed = 1;
+            break;
+        }
+        copied += n;
+        if (write_layout_wrote(job->layout, job->fd_out, n) == -1) {
+            failed = 1;
+            break;
+        }
+    }
+    job->bytes_copied = copied;
+
+    munmap(src, job->file_size);
+    job->other_calls++;
+    return failed ? -1 : 0;
+}
+
+const struct io_engine engine_mmap = {
+    .name = "mmap",
+    .mechanism = "Memory-Mapped I/O (write)",
+    .open = engine_open_default,
+    .prepare = NULL,
+    .transfer = mmap_transfer,
+    .finish = NULL,
+    .print = NULL,
+};
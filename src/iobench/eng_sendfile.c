@@ -0,0 +1,85 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/sendfile.h>
+
+#include "engine.h"
+
+/**
+ * eng_sendfile.c
+ *
+ * Motores zero-copy "sendfile" y "copy_file_range" (file_sendfile --method).
+ * buffer_size es el máximo de bytes por llamada. Aquí no se recurre a
+ * sendfile() si copy_file_range() no está soportado: el error se informa.
+ */
+
+static int sendfile_transfer(struct io_job *job) {
+    off_t offset = 0;
+    while (offset < job->file_size) {
+        size_t want = (job->file_size - offset < job->buffer_size) ? (size_t)(job->file_size - offset)
+                                                                  : (size_t)job->buffer_size;
+        ssize_t sent = IO_TRACE(IO_OP_SENDFILE, sendfile(job->fd_out, job->fd_in, &offset, want));
+        job->other_calls++;
+        if (sent == -1) {
+            if (errno == EINTR) continue;
+            perror("Error en sendfile");
+            return -1;
+        }
+        if (sent == 0) {
+            fprintf(stderr, "Error: fin de archivo inesperado en el offset %ld\n", (long)offset);
+            return -1;
+        }
+        job->bytes_copied += sent;
+        if (write_layout_wrote(job->layout, job->fd_out, sent) == -1) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int cfr_transfer(struct io_job *job) {
+    loff_t off_in = 0;
+    loff_t off_out = 0;
+    while (off_in < job->file_size) {
+        size_t want = (job->file_size - off_in < job->buffer_size) ? (size_t)(job->file_size - off_in)
+                                                                  : (size_t)job->buffer_size;
+        ssize_t copied = IO_TRACE(IO_OP_COPY_FILE_RANGE, copy_file_range(job->fd_in, &off_in, job->fd_out, &off_out, want, 0));
+        job->other_calls++;
+        if (copied == -1) {
+            if (errno == EINTR) continue;
+            perror("Error en copy_file_range");
+            return -1;
+        }
+        if (copied == 0) {
+            fprintf(stderr, "Error: fin de archivo inesperado en el offset %ld\n", (long)off_in);
+            return -1;
+        }
+        job->bytes_copied += copied;
+        if (write_layout_wrote(job->layout, job->fd_out, copied) == -1) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+const struct io_engine engine_sendfile = {
+    .name = "sendfile",
+    .mechanism = "sendfile",
+    .open = engine_open_default,
+    .prepare = NULL,
+    .transfer = sendfile_transfer,
+    .finish = NULL,
+    .print = NULL,
+};
+
+const struct io_engine engine_copy_file_range = {
+    .name = "copy_file_range",
+    .mechanism = "copy_file_range",
+    .open = engine_open_default,
+    .prepare = NULL,
+    .transfer = cfr_transfer,
+    .finish = NULL,
+    .print = NULL,
+};
@@ -0,0 +1,59 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "engine.h"
+
+/**
+ * engine.c
+ *
+ * Registro de motores de iobench y apertura común de archivos. Para añadir
+ * un motor: crear eng_<nombre>.c con su struct io_engine, declararla aquí y
+ * añadirla a io_engines.
+ */
+
+extern const struct io_engine engine_buffered;
+extern const struct io_engine engine_direct;
+extern const struct io_engine engine_mmap;
+extern const struct io_engine engine_sendfile;
+extern const struct io_engine engine_copy_file_range;
+
+const struct io_engine *const io_engines[] = {
+    &engine_buffered,
+    &engine_direct,
+    &engine_mmap,
+    &engine_sendfile,
+    &engine_copy_file_range,
+    NULL
+};
+
+const struct io_engine *engine_find(const char *name) {
+    for (int i = 0; io_engines[i] != NULL; i++) {
+        if (strcmp(io_engines[i]->name, name) == 0) {
+            return io_engines[i];
+        }
+    }
+    return NULL;
+}
+
+int engine_open_files(struct io_job *job, int extra_flags) {
+    job->fd_in = open(job->input_path, O_RDONLY | extra_flags);
+    if (job->fd_in == -1) {
+        perror("Error al abrir el archivo de entrada");
+        return -1;
+    }
+    job->fd_out = open(job->output_path, O_WRONLY | O_CREAT | O_TRUNC | extra_flags, 0644);
+    if (job->fd_out == -1) {
+        perror("Error al abrir el archivo de salida");
+        close(job->fd_in);
+        job->fd_in = -1;
+        return -1;
+    }
+    return 0;
+}
+
+int engine_open_default(struct io_job *job) {
+    return engine_open_files(job, 0);
+}
@@ -0,0 +1,66 @@
+#ifndef IOBENCH_ENGINE_H
+#define IOBENCH_ENGINE_H
+
+#include <sys/types.h>
+
+#include "write_layout.h"
+#include "io_trace.h"
+
+/**
+ * engine.h
+ *
+ * Interfaz de los motores de copia de iobench. Cada motor es un archivo
+ * eng_<nombre>.c que define una struct io_engine y la añade a la tabla de
+ * engine.c. El programa principal se encarga de lo común a todos: argumentos,
+ * estado del cache, apertura, medición de tiempo y de CPU, --prealloc/--fsync
+ * e impresión de resultados. El motor solo implementa la copia.
+ *
+ * Ciclo de cada ejecución:
+ *   open()     abre job->fd_in y job->fd_out (engine_open_default si es NULL)
+ *   prepare()  reserva búferes u otros recursos, fuera del intervalo medido
+ *   transfer() copia job->file_size bytes; es lo único que se mide
+ *   print()    claves Clave: valor propias del motor (opcional; aún puede usar priv)
+ *   finish()   libera lo reservado en prepare()
+ */
+
+// Parámetros y resultados de una ejecución
+struct io_job {
+    const char *input_path;
+    const char *output_path;
+    long buffer_size;             // Tamaño del búfer o del bloque por llamada
+    int fd_in;
+    int fd_out;
+    off_t file_size;
+    struct write_layout *layout;  // Los motores llaman a write_layout_wrote() tras cada escritura
+    void *priv;                   // Estado propio del motor entre prepare() y finish()
+
+    // Contadores que rellena el motor
+    long long bytes_copied;
+    long read_calls;
+    long write_calls;
+    long other_calls;             // Llamadas propias del motor (sendfile, madvise...)
+};
+
+struct io_engine {
+    const char *name;             // Valor de --engine y sufijo del directorio de resultados
+    const char *mechanism;        // Valor de la clave Mechanism
+    int (*open)(struct io_job *job);
+    int (*prepare)(struct io_job *job);
+    int (*transfer)(struct io_job *job);
+    void (*finish)(struct io_job *job);
+    void (*print)(const struct io_job *job);
+};
+
+// Motores disponibles, terminados en NULL
+extern const struct io_engine *const io_engines[];
+
+const struct io_engine *engine_find(const char *name);
+
+// Abre la entrada en solo lectura y la salida con O_CREAT|O_TRUNC, añadiendo
+// extra_flags a ambas. Devuelve 0 o -1 (con perror y sin descriptores abiertos).
+int engine_open_files(struct io_job *job, int extra_flags);
+
+// open() por defecto: engine_open_files(job, 0)
+int engine_open_default(struct io_job *job);
+
+#endif
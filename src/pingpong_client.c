@@ -0,0 +1,441 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <errno.h>
+#include <getopt.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "histogram.h"
+#include "report.h"
+
+/**
+ * pingpong_client.c
+ *
+ * Benchmark de latencia petición/respuesta. Envía un mensaje de tamaño fijo,
+ * espera a recibirlo de vuelta y registra el tiempo de ida y vuelta de cada
+ * iteración en un histograma log-lineal (estilo HDR, error < 1%). Informa los
+ * percentiles p50/p90/p99/p99.9 y el máximo.
+ *
+ * Referencia teórica: Stallings, Cap. 18. Los demás programas miden el
+ * tiempo de transferir un archivo completo; aquí la métrica es la latencia de
+ * mensajes pequeños, dominada por las llamadas al sistema y por el coste de
+ * despertar al proceso que espera la respuesta.
+ *
+ * Transportes:
+ *  - unix: socket de dominio UNIX contra pingpong_server (destino = ruta).
+ *  - tcp: socket TCP contra pingpong_server (destino = ip:puerto), con
+ *         TCP_NODELAY.
+ *  - socketpair: par de sockets UNIX con un proceso hijo de eco (línea base
+ *                sin conexión; destino se ignora, p. ej. "-").
+ *  - pipe: dos tuberías con un proceso hijo de eco (línea base).
+ *
+ * Con --spin las lecturas se hacen no bloqueantes en un bucle activo, lo que
+ * elimina la espera dormida; la diferencia con el modo normal es la parte de
+ * la cola que se debe a despertar al proceso. --busy-poll fija SO_BUSY_POLL
+ * (solo útil en interfaces con NAPI). Se informan los cambios de contexto
+ * voluntarios (getrusage) como indicador de cuántas veces se durmió.
+ *
+ * Argumentos:
+ *  - <transporte>: unix, tcp, socketpair o pipe.
+ *  - <destino>: Ruta del socket, ip:puerto, o "-" para socketpair/pipe.
+ *  - <tam_mensaje>: Bytes por mensaje (1 a 65536).
+ *  - [--iterations N]: Opcional. Idas y vueltas medidas. Por defecto 100000.
+ *  - [--warmup N]: Opcional. Idas y vueltas previas sin medir. Por defecto 1000.
+ *  - [--spin]: Opcional. Lecturas en bucle activo.
+ *  - [--busy-poll US]: Opcional. SO_BUSY_POLL en microsegundos.
+ *  - [--cpu N]: Opcional. Fijar el cliente a la CPU N.
+ *  - [--peer-cpu N]: Opcional. Fijar el hijo de eco (socketpair/pipe) a la CPU N.
+ *  - [--json] [--json-out F] [--tag K=V]: Opcionales. Resultados en JSON, una
+ *                     línea por bloque con los metadatos de la ejecución (ver common/report.h).
+ */
+
+#define MAX_MESSAGE_SIZE (64 * 1024)
+#define DEFAULT_ITERATIONS 100000
+#define DEFAULT_WARMUP 1000
+
+enum transport { TRANSPORT_UNIX, TRANSPORT_TCP, TRANSPORT_SOCKETPAIR, TRANSPORT_PIPE };
+
+static const char *transport_names[] = { "unix", "tcp", "socketpair", "pipe" };
+
+void print_usage(const char *prog_name) {
+    fprintf(stderr, "Uso: %s <unix|tcp|socketpair|pipe> <socket_path|ip:puerto|-> <tam_mensaje> "
+                    "[--iterations N] [--warmup N] [--spin] [--busy-poll US] [--cpu N] [--peer-cpu N] " REPORT_USAGE "\n", prog_name);
+}
+
+static double timeval_to_sec(const struct timeval *tv) {
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+static int pin_to_cpu(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) == -1) {
+        perror("Error en sched_setaffinity");
+        return -1;
+    }
+    return 0;
+}
+
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+        perror("Error al poner el descriptor en modo no bloqueante");
+        return -1;
+    }
+    return 0;
+}
+
+// Escribe len bytes completos. Con --spin el descriptor es no bloqueante.
+static int write_full(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n == -1) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// Lee exactamente len bytes. Devuelve 0, 1 si hubo EOF o -1 si hubo error.
+static int read_full(int fd, char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = read(fd, buf, len);
+        if (n == -1) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return -1;
+        }
+        if (n == 0) {
+            return 1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// Proceso hijo de las líneas base: devuelve lo leído de fd_in por fd_out
+static void echo_child(int fd_in, int fd_out, int cpu) {
+    if (cpu >= 0 && pin_to_cpu(cpu) == -1) {
+        _exit(EXIT_FAILURE);
+    }
+    char *buffer = malloc(MAX_MESSAGE_SIZE);
+    if (buffer == NULL) {
+        _exit(EXIT_FAILURE);
+    }
+    for (;;) {
+        ssize_t n = read(fd_in, buffer, MAX_MESSAGE_SIZE);
+        if (n == -1) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            _exit(EXIT_FAILURE);
+        }
+        if (n == 0) {
+            _exit(EXIT_SUCCESS);
+        }
+        if (write_full(fd_out, buffer, n) == -1) {
+            _exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// Se conecta a pingpong_server. Devuelve el socket o -1.
+static int connect_server(enum transport transport, const char *endpoint) {
+    int sock;
+    if (transport == TRANSPORT_UNIX) {
+        struct sockaddr_un addr;
+        sock = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (sock == -1) {
+            perror("Error al crear el socket del cliente");
+            return -1;
+        }
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, endpoint, sizeof(addr.sun_path) - 1);
+        if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+            perror("Error al conectar con el servidor");
+            close(sock);
+            return -1;
+        }
+        return sock;
+    }
+
+    // TCP: destino con formato ip:puerto
+    char host[64];
+    const char *colon = strrchr(endpoint, ':');
+    if (colon == NULL || colon == endpoint || (size_t)(colon - endpoint) >= sizeof(host)) {
+        fprintf(stderr, "Error: El destino TCP debe tener el formato ip:puerto.\n");
+        return -1;
+    }
+    memcpy(host, endpoint, colon - endpoint);
+    host[colon - endpoint] = '\0';
+    int port = atoi(colon + 1);
+    if (port <= 0 || port > 65535) {
+        fprintf(stderr, "Error: El puerto debe ser un número entre 1 y 65535.\n");
+        return -1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &addr.sin_addr) <= 0) {
+        perror("Dirección IP inválida o no soportada");
+        return -1;
+    }
+    sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock == -1) {
+        perror("Error al crear el socket del cliente");
+        return -1;
+    }
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        perror("Error al conectar con el servidor");
+        close(sock);
+        return -1;
+    }
+    int one = 1;
+    if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) == -1) {
+        perror("setsockopt(TCP_NODELAY)");
+    }
+    return sock;
+}
+
+int main(int argc, char *argv[]) {
+    long iterations = DEFAULT_ITERATIONS;
+    long warmup = DEFAULT_WARMUP;
+    int spin = 0;
+    int busy_poll = 0;
+    int cpu = -1;
+    int peer_cpu = -1;
+
+    static struct option long_options[] = {
+        {"iterations", required_argument, NULL, 'n'},
+        {"warmup", required_argument, NULL, 'w'},
+        {"spin", no_argument, NULL, 's'},
+        {"busy-poll", required_argument, NULL, 'b'},
+        {"cpu", required_argument, NULL, 'c'},
+        {"peer-cpu", required_argument, NULL, 'p'},
+        REPORT_LONG_OPTIONS,
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'n': iterations = atol(optarg); break;
+            case 'w': warmup = atol(optarg); break;
+            case 's': spin = 1; break;
+            case 'b': busy_poll = atoi(optarg); break;
+            case 'c': cpu = atoi(optarg); break;
+            case 'p': peer_cpu = atoi(optarg); break;
+            default:
+                if (report_parse_option(opt, optarg) == 1) break;
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 3) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    enum transport transport;
+    const char *name = argv[optind];
+    if (strcmp(name, "unix") == 0) {
+        transport = TRANSPORT_UNIX;
+    } else if (strcmp(name, "tcp") == 0) {
+        transport = TRANSPORT_TCP;
+    } else if (strcmp(name, "socketpair") == 0) {
+        transport = TRANSPORT_SOCKETPAIR;
+    } else if (strcmp(name, "pipe") == 0) {
+        transport = TRANSPORT_PIPE;
+    } else {
+        fprintf(stderr, "Error: Transporte desconocido '%s'.\n", name);
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    const char *endpoint = argv[optind + 1];
+    long message_size = atol(argv[optind + 2]);
+    report_start(argc, argv);
+
+    if (message_size <= 0 || message_size > MAX_MESSAGE_SIZE) {
+        fprintf(stderr, "Error: El tamaño de mensaje debe estar entre 1 y %d.\n", MAX_MESSAGE_SIZE);
+        exit(EXIT_FAILURE);
+    }
+    if (iterations <= 0 || warmup < 0) {
+        fprintf(stderr, "Error: --iterations debe ser positivo y --warmup no negativo.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (busy_poll < 0) {
+        fprintf(stderr, "Error: --busy-poll debe ser un entero no negativo.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Establecer el canal ---
+    // fd_out: por donde se envía el mensaje; fd_in: por donde vuelve.
+    int fd_out, fd_in;
+    pid_t child = -1;
+    if (transport == TRANSPORT_UNIX || transport == TRANSPORT_TCP) {
+        fd_out = fd_in = connect_server(transport, endpoint);
+        if (fd_out == -1) {
+            exit(EXIT_FAILURE);
+        }
+    } else if (transport == TRANSPORT_SOCKETPAIR) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
+            perror("Error en socketpair");
+            exit(EXIT_FAILURE);
+        }
+        child = fork();
+        if (child == -1) {
+            perror("Error en fork");
+            exit(EXIT_FAILURE);
+        }
+        if (child == 0) {
+            close(sv[0]);
+            echo_child(sv[1], sv[1], peer_cpu);
+        }
+        close(sv[1]);
+        fd_out = fd_in = sv[0];
+    } else {
+        int to_child[2], from_child[2];
+        if (pipe(to_child) == -1 || pipe(from_child) == -1) {
+            perror("Error al crear las tuberías");
+            exit(EXIT_FAILURE);
+        }
+        child = fork();
+        if (child == -1) {
+            perror("Error en fork");
+            exit(EXIT_FAILURE);
+        }
+        if (child == 0) {
+            close(to_child[1]);
+            close(from_child[0]);
+            echo_child(to_child[0], from_child[1], peer_cpu);
+        }
+        close(to_child[0]);
+        close(from_child[1]);
+        fd_out = to_child[1];
+        fd_in = from_child[0];
+    }
+
+    if (cpu >= 0 && pin_to_cpu(cpu) == -1) {
+        exit(EXIT_FAILURE);
+    }
+
+    // SO_BUSY_POLL solo existe para sockets; se lee de vuelta el valor efectivo
+    int busy_poll_effective = 0;
+    if (transport != TRANSPORT_PIPE) {
+        if (busy_poll > 0 && setsockopt(fd_in, SOL_SOCKET, SO_BUSY_POLL, &busy_poll, sizeof(busy_poll)) == -1) {
+            perror("setsockopt(SO_BUSY_POLL)");
+            exit(EXIT_FAILURE);
+        }
+        socklen_t len = sizeof(busy_poll_effective);
+        getsockopt(fd_in, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_effective, &len);
+    } else if (busy_poll > 0) {
+        fprintf(stderr, "Aviso: --busy-poll no se aplica a tuberías.\n");
+    }
+    if (spin && set_nonblocking(fd_in) == -1) {
+        exit(EXIT_FAILURE);
+    }
+
+    char *message = malloc(message_size);
+    struct histogram *hist = malloc(sizeof(struct histogram));
+    if (message == NULL || hist == NULL) {
+        perror("Error al asignar memoria");
+        exit(EXIT_FAILURE);
+    }
+    memset(message, 'p', message_size);
+    hist_init(hist);
+
+    // --- Idas y vueltas ---
+    struct timespec start, end, t0, t1;
+    struct rusage ru_start, ru_end;
+    int failed = 0;
+
+    for (long i = 0; i < warmup + iterations; i++) {
+        if (i == warmup) {
+            getrusage(RUSAGE_SELF, &ru_start);
+            clock_gettime(CLOCK_MONOTONIC, &start);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (write_full(fd_out, message, message_size) == -1) {
+            perror("Error al enviar el mensaje");
+            failed = 1;
+            break;
+        }
+        int r = read_full(fd_in, message, message_size);
+        if (r != 0) {
+            if (r == -1) perror("Error al recibir la respuesta");
+            else fprintf(stderr, "Error: el otro extremo cerró la conexión\n");
+            failed = 1;
+            break;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        if (i >= warmup) {
+            hist_record(hist, (uint64_t)(t1.tv_sec - t0.tv_sec) * 1000000000ULL + (t1.tv_nsec - t0.tv_nsec));
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    getrusage(RUSAGE_SELF, &ru_end);
+
+    // --- Limpieza ---
+    close(fd_out);
+    if (fd_in != fd_out) {
+        close(fd_in);
+    }
+    if (child > 0) {
+        waitpid(child, NULL, 0);
+    }
+    free(message);
+
+    if (failed) {
+        free(hist);
+        exit(EXIT_FAILURE);
+    }
+
+    double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    double user_time = timeval_to_sec(&ru_end.ru_utime) - timeval_to_sec(&ru_start.ru_utime);
+    double sys_time = timeval_to_sec(&ru_end.ru_stime) - timeval_to_sec(&ru_start.ru_stime);
+
+    // --- Imprimir resultados para el parser ---
+    printf("Mechanism: PingPong (%s)\n", transport_names[transport]);
+    printf("Transport: %s\n", transport_names[transport]);
+    printf("MessageSize: %ld\n", message_size);
+    printf("Iterations: %ld\n", iterations);
+    printf("TimeTaken: %.6f\n", time_taken);
+    printf("RoundTripsPerSec: %.0f\n", time_taken > 0 ? iterations / time_taken : 0.0);
+    printf("LatencyMinUs: %.3f\n", hist->min / 1000.0);
+    printf("LatencyMeanUs: %.3f\n", hist_mean(hist) / 1000.0);
+    printf("LatencyP50Us: %.3f\n", hist_percentile(hist, 50) / 1000.0);
+    printf("LatencyP90Us: %.3f\n", hist_percentile(hist, 90) / 1000.0);
+    printf("LatencyP99Us: %.3f\n", hist_percentile(hist, 99) / 1000.0);
+    printf("LatencyP999Us: %.3f\n", hist_percentile(hist, 99.9) / 1000.0);
+    printf("LatencyMaxUs: %.3f\n", hist->max / 1000.0);
+    printf("Spin: %d\n", spin);
+    printf("BusyPoll: %d\n", busy_poll_effective);
+    printf("Cpu: %d\n", cpu);
+    printf("PeerCpu: %d\n", peer_cpu);
+    printf("VoluntaryCtxSwitches: %ld\n", ru_end.ru_nvcsw - ru_start.ru_nvcsw);
+    printf("InvoluntaryCtxSwitches: %ld\n", ru_end.ru_nivcsw - ru_start.ru_nivcsw);
+    printf("UserTime: %.6f\n", user_time);
+    printf("SysTime: %.6f\n", sys_time);
+
+    free(hist);
+    return 0;
+}
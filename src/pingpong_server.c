@@ -0,0 +1,274 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <getopt.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "report.h"
+
+/**
+ * pingpong_server.c
+ *
+ * Servidor de eco para el benchmark de latencia petición/respuesta
+ * (pingpong_client). Acepta una única conexión por un socket de dominio UNIX
+ * o TCP y devuelve cada byte recibido hasta que el cliente cierra. No
+ * necesita conocer el tamaño de mensaje: lo que llega se reenvía tal cual.
+ *
+ * Referencia teórica: Stallings, Cap. 18. En mensajes pequeños el coste no
+ * está en copiar los datos sino en las llamadas al sistema y, sobre todo, en
+ * despertar al proceso que espera. Las opciones --spin y --busy-poll
+ * permiten medir cuánto de la cola de latencia se debe a esa espera.
+ *
+ * Argumentos:
+ *  - <transporte>: unix o tcp.
+ *  - <destino>: Ruta del socket (unix) o puerto (tcp).
+ *  - [--spin]: Opcional. Lecturas no bloqueantes en bucle activo en lugar de
+ *              dormir en read().
+ *  - [--busy-poll US]: Opcional. SO_BUSY_POLL en microsegundos (solo tiene
+ *                      efecto en interfaces con NAPI; no en loopback).
+ *  - [--cpu N]: Opcional. Fijar el proceso a la CPU N.
+ *  - [--json] [--json-out F] [--tag K=V]: Opcionales. Resultados en JSON, una
+ *                     línea por bloque con los metadatos de la ejecución (ver common/report.h).
+ */
+
+#define ECHO_BUFFER_SIZE (64 * 1024)
+
+enum transport { TRANSPORT_UNIX, TRANSPORT_TCP };
+
+static const char *transport_names[] = { "unix", "tcp" };
+
+// Contadores del bucle de eco
+static long read_calls = 0;
+static long write_calls = 0;
+
+void print_usage(const char *prog_name) {
+    fprintf(stderr, "Uso: %s <unix|tcp> <socket_path|puerto> [--spin] [--busy-poll US] [--cpu N] " REPORT_USAGE "\n", prog_name);
+}
+
+static int pin_to_cpu(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) == -1) {
+        perror("Error en sched_setaffinity");
+        return -1;
+    }
+    return 0;
+}
+
+// Escribe len bytes completos. Con spin, el descriptor es no bloqueante.
+static int write_full(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        write_calls++;
+        if (n == -1) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// Devuelve cada bloque recibido hasta EOF. Devuelve los bytes reenviados o -1.
+static long long echo_loop(int fd) {
+    char *buffer = malloc(ECHO_BUFFER_SIZE);
+    if (buffer == NULL) {
+        perror("Error al asignar memoria para el buffer");
+        return -1;
+    }
+
+    long long total = 0;
+    for (;;) {
+        ssize_t n = read(fd, buffer, ECHO_BUFFER_SIZE);
+        read_calls++;
+        if (n == -1) {
+            if (errno == EINTR || errno == EAGAIN) continue; // EAGAIN: modo --spin
+            perror("Error en read del servidor");
+            total = -1;
+            break;
+        }
+        if (n == 0) {
+            break; // El cliente cerró la conexión
+        }
+        if (write_full(fd, buffer, n) == -1) {
+            perror("Error en write del servidor");
+            total = -1;
+            break;
+        }
+        total += n;
+    }
+
+    free(buffer);
+    return total;
+}
+
+int main(int argc, char *argv[]) {
+    int spin = 0;
+    int busy_poll = 0;
+    int cpu = -1;
+
+    static struct option long_options[] = {
+        {"spin", no_argument, NULL, 's'},
+        {"busy-poll", required_argument, NULL, 'b'},
+        {"cpu", required_argument, NULL, 'c'},
+        REPORT_LONG_OPTIONS,
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 's': spin = 1; break;
+            case 'b': busy_poll = atoi(optarg); break;
+            case 'c': cpu = atoi(optarg); break;
+            default:
+                if (report_parse_option(opt, optarg) == 1) break;
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 2) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    enum transport transport;
+    if (strcmp(argv[optind], "unix") == 0) {
+        transport = TRANSPORT_UNIX;
+    } else if (strcmp(argv[optind], "tcp") == 0) {
+        transport = TRANSPORT_TCP;
+    } else {
+        fprintf(stderr, "Error: Transporte desconocido '%s'.\n", argv[optind]);
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    const char *endpoint = argv[optind + 1];
+    report_start(argc, argv);
+
+    if (busy_poll < 0) {
+        fprintf(stderr, "Error: --busy-poll debe ser un entero no negativo.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (cpu >= 0 && pin_to_cpu(cpu) == -1) {
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Configuración del socket ---
+    int server_sock;
+    if (transport == TRANSPORT_UNIX) {
+        struct sockaddr_un server_addr;
+        server_sock = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (server_sock == -1) {
+            perror("Error al crear el socket");
+            exit(EXIT_FAILURE);
+        }
+        memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sun_family = AF_UNIX;
+        strncpy(server_addr.sun_path, endpoint, sizeof(server_addr.sun_path) - 1);
+        unlink(endpoint);
+        if (bind(server_sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+            perror("Error en bind");
+            close(server_sock);
+            exit(EXIT_FAILURE);
+        }
+    } else {
+        int port = atoi(endpoint);
+        if (port <= 0 || port > 65535) {
+            fprintf(stderr, "Error: El puerto debe ser un número entre 1 y 65535.\n");
+            exit(EXIT_FAILURE);
+        }
+        struct sockaddr_in server_addr;
+        server_sock = socket(AF_INET, SOCK_STREAM, 0);
+        if (server_sock == -1) {
+            perror("Error al crear el socket");
+            exit(EXIT_FAILURE);
+        }
+        int reuse = 1;
+        if (setsockopt(server_sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
+            perror("setsockopt(SO_REUSEADDR) failed");
+        }
+        memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        server_addr.sin_port = htons(port);
+        if (bind(server_sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+            perror("Error en bind");
+            close(server_sock);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (listen(server_sock, 1) == -1) {
+        perror("Error en listen");
+        close(server_sock);
+        exit(EXIT_FAILURE);
+    }
+
+    int client_sock = accept(server_sock, NULL, NULL);
+    if (client_sock == -1) {
+        perror("Error en accept");
+        close(server_sock);
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Opciones de latencia ---
+    if (transport == TRANSPORT_TCP) {
+        // Sin Nagle: cada respuesta sale en cuanto se escribe
+        int one = 1;
+        if (setsockopt(client_sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) == -1) {
+            perror("setsockopt(TCP_NODELAY)");
+        }
+    }
+    if (busy_poll > 0 && setsockopt(client_sock, SOL_SOCKET, SO_BUSY_POLL, &busy_poll, sizeof(busy_poll)) == -1) {
+        perror("setsockopt(SO_BUSY_POLL)");
+        close(client_sock);
+        close(server_sock);
+        exit(EXIT_FAILURE);
+    }
+    if (spin) {
+        int flags = fcntl(client_sock, F_GETFL, 0);
+        if (flags == -1 || fcntl(client_sock, F_SETFL, flags | O_NONBLOCK) == -1) {
+            perror("Error al poner el socket en modo no bloqueante");
+            close(client_sock);
+            close(server_sock);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // --- Eco ---
+    long long bytes = echo_loop(client_sock);
+
+    // --- Limpieza ---
+    close(client_sock);
+    close(server_sock);
+    if (transport == TRANSPORT_UNIX) {
+        unlink(endpoint);
+    }
+
+    if (bytes < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Imprimir resultados para el parser ---
+    printf("Mechanism: PingPong Server\n");
+    printf("Transport: %s\n", transport_names[transport]);
+    printf("BytesEchoed: %lld\n", bytes);
+    printf("ReadCalls: %ld\n", read_calls);
+    printf("WriteCalls: %ld\n", write_calls);
+    printf("Spin: %d\n", spin);
+    printf("BusyPoll: %d\n", busy_poll);
+    printf("Cpu: %d\n", cpu);
+
+    return 0;
+}
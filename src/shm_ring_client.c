@@ -0,0 +1,174 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <errno.h>
+#include <getopt.h>
+#include <sys/resource.h>
+
+#include "shm_ring.h"
+#include "cache_state.h"
+#include "io_trace.h"
+#include "report.h"
+
+/**
+ * shm_ring_client.c
+ *
+ * Cliente que lee un archivo local y lo envía a shm_ring_server a través del
+ * anillo en memoria compartida.
+ *
+ * Referencia teórica: Complementa al servidor (Stallings, Cap. 5 y 18). Cada
+ * bloque se lee con read() directamente sobre el espacio libre del anillo, de
+ * modo que no hay búfer de usuario ni copia a un búfer de socket: es la misma
+ * forma de línea de comandos y las mismas claves de salida que
+ * unix_socket_client, para comparar ambos caminos.
+ *
+ * Argumentos:
+ *  - <nombre_shm>: Nombre del segmento creado por el servidor (p. ej. /io_ring).
+ *  - <fichero_entrada>: Ruta al archivo que se va a enviar.
+ *  - <tam_buffer>: Bytes máximos por read().
+ *  - [--cold|--warm]: Opcional. Desalojar o precargar solo el archivo de
+ *                     entrada antes de medir (ver common/cache_state.h).
+ *  - [--json] [--json-out F] [--tag K=V]: Opcionales. Resultados en JSON, una
+ *                     línea por bloque con los metadatos de la ejecución (ver common/report.h).
+ */
+
+void print_usage(const char *prog_name) {
+    fprintf(stderr, "Uso: %s <nombre_shm> <fichero_entrada> <tam_buffer> " CACHE_STATE_USAGE " " REPORT_USAGE "\n", prog_name);
+}
+
+static double timeval_to_sec(const struct timeval *tv) {
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    enum cache_state cache_state = CACHE_STATE_DEFAULT;
+
+    static struct option long_options[] = {
+        CACHE_STATE_LONG_OPTIONS,
+        REPORT_LONG_OPTIONS,
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        if (cache_state_parse_option(opt, &cache_state)) continue;
+        if (report_parse_option(opt, optarg) == 1) continue;
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (argc - optind != 3) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    const char *shm_name = argv[optind];
+    const char *input_path = argv[optind + 1];
+    long buffer_size = atol(argv[optind + 2]);
+    report_path("Input", input_path);
+    report_start(argc, argv);
+
+    if (buffer_size <= 0) {
+        fprintf(stderr, "Error: El tamaño del buffer debe ser un entero positivo.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Estado del cache de la entrada ---
+    struct cache_report cache_report;
+    if (cache_state_prepare(cache_state, input_path, &cache_report) == -1) {
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Abrir archivo de entrada ---
+    int fd_in = open(input_path, O_RDONLY);
+    if (fd_in == -1) {
+        perror("Error al abrir el archivo de entrada");
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Conectarse al anillo del servidor ---
+    size_t map_len;
+    struct shm_ring *ring = shm_ring_attach(shm_name, &map_len);
+    if (ring == NULL) {
+        close(fd_in);
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Enviar datos ---
+    struct shm_ring_stats st = {0};
+    struct timespec start, end;
+    struct rusage ru_start, ru_end;
+    long long bytes_sent = 0;
+    long read_calls = 0;
+    int failed = 0;
+
+    io_trace_begin();
+    getrusage(RUSAGE_SELF, &ru_start);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (;;) {
+        size_t len;
+        char *space = shm_ring_reserve(ring, buffer_size, &len, &st);
+        if (space == NULL) {
+            fprintf(stderr, "Error: Transferencia abortada por el servidor.\n");
+            failed = 1;
+            break;
+        }
+        ssize_t bytes_read = IO_TRACE(IO_OP_READ, read(fd_in, space, len));
+        read_calls++;
+        if (bytes_read == -1) {
+            if (errno == EINTR) continue;
+            perror("Error de lectura del archivo de entrada");
+            failed = 1;
+            break;
+        }
+        if (bytes_read == 0) {
+            break;
+        }
+        shm_ring_publish(ring, bytes_read, &st);
+        bytes_sent += bytes_read;
+    }
+    // En caso de error se aborta en vez de cerrar: el servidor no debe
+    // tomar un archivo truncado por uno completo
+    if (failed) {
+        shm_ring_abort(ring, &st);
+    } else {
+        shm_ring_close(ring, &st);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    getrusage(RUSAGE_SELF, &ru_end);
+    io_trace_end();
+    double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    double user_time = timeval_to_sec(&ru_end.ru_utime) - timeval_to_sec(&ru_start.ru_utime);
+    double sys_time = timeval_to_sec(&ru_end.ru_stime) - timeval_to_sec(&ru_start.ru_stime);
+    long ring_size = (long)ring->capacity;
+
+    // --- Limpieza ---
+    close(fd_in);
+    shm_ring_unmap(ring, map_len);
+
+    if (failed) {
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Imprimir resultados para el parser ---
+    printf("Mechanism: Shared Memory Ring Client\n");
+    printf("BufferSize: %ld\n", buffer_size);
+    printf("TimeTakenClient: %.6f\n", time_taken);
+    cache_state_print(&cache_report);
+    printf("RingSize: %ld\n", ring_size);
+    printf("BytesSent: %lld\n", bytes_sent);
+    printf("ReadCalls: %ld\n", read_calls);
+    printf("FutexWaits: %ld\n", st.futex_waits);
+    printf("FutexWakes: %ld\n", st.futex_wakes);
+    printf("UserTime: %.6f\n", user_time);
+    printf("SysTime: %.6f\n", sys_time);
+    printf("CpuNsPerByte: %.4f\n", bytes_sent > 0 ? (user_time + sys_time) * 1e9 / bytes_sent : 0.0);
+    io_trace_print();
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <getopt.h>
+#include <sys/resource.h>
+
+#include "shm_ring.h"
+#include "io_trace.h"
+#include "report.h"
+
+/**
+ * shm_ring_server.c
+ *
+ * Servidor que recibe un archivo a través de un anillo de bytes en memoria
+ * compartida (shm_open + mmap) y lo escribe en un archivo de salida.
+ *
+ * Referencia teórica: Stallings, Cap. 5 y 18. Es el límite inferior del coste
+ * de una transferencia local frente a los sockets UNIX y TCP: los datos no
+ * atraviesan ningún búfer del kernel, solo el segmento compartido, y el
+ * kernel interviene únicamente para despertar a un lado cuando el otro lo
+ * deja esperando (futex). Se informa cuántas veces ocurrió.
+ *
+ * El servidor crea el segmento, espera a que el cliente se conecte (como
+ * accept()) y escribe con write() directamente desde el anillo hasta que el
+ * cliente marca el fin de datos. Atiende un único cliente. Si la escritura
+ * falla aborta el anillo para que el cliente no quede esperando espacio, y
+ * si el cliente falla o muere a mitad de la transferencia termina con error.
+ *
+ * Argumentos:
+ *  - <nombre_shm>: Nombre del segmento POSIX (p. ej. /io_ring).
+ *  - <fichero_salida>: Ruta al archivo donde se guardarán los datos recibidos.
+ *  - <tam_buffer>: Bytes máximos por write().
+ *  - [--ring-size N]: Opcional. Capacidad del anillo en bytes (>= tam_buffer).
+ *                     Por defecto 4 MiB.
+ *  - [--json] [--json-out F] [--tag K=V]: Opcionales. Resultados en JSON, una
+ *                     línea por bloque con los metadatos de la ejecución (ver common/report.h).
+ */
+
+#define DEFAULT_RING_SIZE (4 * 1024 * 1024)
+
+void print_usage(const char *prog_name) {
+    fprintf(stderr, "Uso: %s <nombre_shm> <fichero_salida> <tam_buffer> [--ring-size N] " REPORT_USAGE "\n", prog_name);
+}
+
+static double timeval_to_sec(const struct timeval *tv) {
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    long ring_size = DEFAULT_RING_SIZE;
+
+    static struct option long_options[] = {
+        {"ring-size", required_argument, NULL, 'r'},
+        REPORT_LONG_OPTIONS,
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'r': ring_size = atol(optarg); break;
+            default:
+                if (report_parse_option(opt, optarg) == 1) break;
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 3) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    const char *shm_name = argv[optind];
+    const char *output_path = argv[optind + 1];
+    long buffer_size = atol(argv[optind + 2]);
+    report_path("Output", output_path);
+    report_start(argc, argv);
+
+    if (buffer_size <= 0) {
+        fprintf(stderr, "Error: El tamaño del buffer debe ser un entero positivo.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (ring_size < buffer_size) {
+        fprintf(stderr, "Error: --ring-size debe ser al menos el tamaño del buffer.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Abrir archivo de salida ---
+    int fd_out = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_out == -1) {
+        perror("Error al abrir el archivo de salida");
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Crear el anillo y esperar al cliente ---
+    size_t map_len;
+    struct shm_ring *ring = shm_ring_create(shm_name, ring_size, &map_len);
+    if (ring == NULL) {
+        close(fd_out);
+        exit(EXIT_FAILURE);
+    }
+    shm_ring_wait_client(ring);
+
+    // --- Recibir datos ---
+    struct shm_ring_stats st = {0};
+    struct timespec start, end;
+    struct rusage ru_start, ru_end;
+    long long bytes_received = 0;
+    long write_calls = 0;
+    int failed = 0;
+
+    io_trace_begin();
+    getrusage(RUSAGE_SELF, &ru_start);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (;;) {
+        size_t len;
+        char *data = shm_ring_peek(ring, buffer_size, &len, &st);
+        if (len == 0) {
+            // Fin de datos marcado por el cliente, o el cliente falló o murió
+            failed = shm_ring_aborted(ring);
+            break;
+        }
+        ssize_t written = IO_TRACE(IO_OP_WRITE, write(fd_out, data, len));
+        write_calls++;
+        if (written <= 0) {
+            perror("Error de escritura en el archivo de salida");
+            shm_ring_abort(ring, &st); // Despierta al cliente si espera espacio
+            failed = 1;
+            break;
+        }
+        shm_ring_consume(ring, written, &st);
+        bytes_received += written;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    getrusage(RUSAGE_SELF, &ru_end);
+    io_trace_end();
+    double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    double user_time = timeval_to_sec(&ru_end.ru_utime) - timeval_to_sec(&ru_start.ru_utime);
+    double sys_time = timeval_to_sec(&ru_end.ru_stime) - timeval_to_sec(&ru_start.ru_stime);
+
+    // --- Limpieza ---
+    close(fd_out);
+    shm_ring_unmap(ring, map_len);
+    shm_ring_unlink(shm_name);
+
+    if (failed) {
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Imprimir resultados para el parser ---
+    printf("Mechanism: Shared Memory Ring Server\n");
+    printf("BufferSize: %ld\n", buffer_size);
+    printf("TimeTakenServer: %.6f\n", time_taken);
+    printf("RingSize: %ld\n", ring_size);
+    printf("BytesReceived: %lld\n", bytes_received);
+    printf("WriteCalls: %ld\n", write_calls);
+    printf("FutexWaits: %ld\n", st.futex_waits);
+    printf("FutexWakes: %ld\n", st.futex_wakes);
+    printf("UserTime: %.6f\n", user_time);
+    printf("SysTime: %.6f\n", sys_time);
+    printf("CpuNsPerByte: %.4f\n", bytes_received > 0 ? (user_time + sys_time) * 1e9 / bytes_received : 0.0);
+    io_trace_print();
+
+    return 0;
+}
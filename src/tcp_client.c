@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -5,9 +6,22 @@
 #include <fcntl.h>
 #include <time.h>
 #include <errno.h>
+#include <stdint.h>
+#include <endian.h>
+#include <getopt.h>
 #include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
 #include <arpa/inet.h>
 
+#include "tcp_tuning.h"
+#include "cache_state.h"
+#include "io_trace.h"
+#include "report.h"
+#include "sampler.h"
+#include "send_paths.h"
+
 /**
  * tcp_client.c
  *
@@ -18,27 +32,291 @@
  * en red (Stallings, Cap. 18). El rendimiento medido aquí incluirá la
  * latencia de la red y la sobrecarga del protocolo TCP/IP.
  *
+ * Por defecto cada bloque se lee con read() a un búfer de usuario y se envía
+ * con send(), es decir, dos copias por byte. Con --zerocopy el archivo se
+ * entrega al socket sin pasar por un búfer de usuario (ver common/send_paths.h):
+ *  - sendfile:     sendfile() del archivo al socket.
+ *  - splice:       splice() del archivo a una tubería y de ésta al socket.
+ *  - msg_zerocopy: send(MSG_ZEROCOPY) desde una proyección mmap del archivo;
+ *                  las notificaciones de finalización se leen de la cola de
+ *                  errores del socket antes de liberar la proyección.
+ * Como la métrica relevante es la CPU ahorrada, se informa el tiempo de CPU
+ * de usuario y de sistema (getrusage) del intervalo medido y su coste por
+ * byte enviado.
+ *
+ * Con --connections M se abren M conexiones simultáneas, cada una desde su
+ * propio hilo y enviando el archivo completo (para ejercitar el modo --epoll
+ * del servidor). Se informa el rendimiento agregado y los percentiles de la
+ * duración de cada conexión.
+ *
+ * Con --stripes K el archivo se reparte en K rangos contiguos que se envían
+ * en paralelo por K conexiones (contra un tcp_server --stripes K). Cada
+ * conexión empieza con una cabecera (offset, longitud, tamaño total) y el
+ * servidor escribe su rango con pwrite() en la posición indicada. Se informa
+ * el rendimiento de cada flujo (Stream<i>ThroughputMBs) y el agregado. Solo
+ * admite el envío por defecto o --zerocopy=sendfile.
+ *
+ * Las opciones de ajuste TCP (--sndbuf, --rcvbuf, --nodelay, --cork,
+ * --notsent-lowat, --quickack, --cc) se aplican a cada socket antes de
+ * connect(), y los valores efectivos leídos con getsockopt() al final de la
+ * primera conexión se imprimen junto con los resultados.
+ *
  * Argumentos:
  *  - <ip_servidor>: Dirección IP del servidor.
  *  - <puerto>: Puerto en el que el servidor está escuchando.
  *  - <fichero_entrada>: Ruta al archivo que se va a enviar.
- *  - <tam_buffer>: Tamaño del búfer de lectura/envío en bytes.
+ *  - <tam_buffer>: Tamaño del búfer de lectura/envío en bytes (con
+ *                  --zerocopy, bytes por llamada).
+ *  - [--zerocopy=M]: Opcional. sendfile, splice o msg_zerocopy.
+ *  - [--connections M]: Opcional. Conexiones paralelas. Por defecto 1.
+ *  - [--stripes K]: Opcional. Transferencia repartida en K flujos.
+ *  - [--sndbuf N] [--rcvbuf N]: Opcional. SO_SNDBUF / SO_RCVBUF en bytes.
+ *  - [--nodelay] [--cork] [--quickack]: Opcional. TCP_NODELAY, TCP_CORK y
+ *                                       TCP_QUICKACK.
+ *  - [--notsent-lowat N]: Opcional. TCP_NOTSENT_LOWAT en bytes.
+ *  - [--cc ALG]: Opcional. Algoritmo de control de congestión (p. ej. bbr).
+ *  - [--cold|--warm]: Opcional. Desalojar o precargar solo el archivo de
+ *                     entrada antes de medir (ver common/cache_state.h).
+ *  - [--sample-ms N]: Opcional. Cada N ms anota los bytes transferidos e informa
+ *                     la serie de MB/s y el mayor parón (ver common/sampler.h).
+ *  - [--json] [--json-out F] [--tag K=V]: Opcionales. Resultados en JSON, una
+ *                     línea por bloque con los metadatos de la ejecución (ver common/report.h).
  */
 
+#define MAX_CONNECTIONS 1024
+
+// Cabecera de cada flujo en el modo --stripes (campos en orden de red).
+// Debe coincidir con la de tcp_server.c.
+struct stripe_header {
+    uint64_t offset;
+    uint64_t length;
+    uint64_t total;           // Tamaño total del archivo
+};
+
+enum zerocopy_mode { ZC_NONE, ZC_SENDFILE, ZC_SPLICE, ZC_MSG_ZEROCOPY };
+
+static const char *zerocopy_names[] = { "none", "sendfile", "splice", "msg_zerocopy" };
+
+// Parámetros y resultados de una conexión
+struct connection {
+    const struct sockaddr_in *server_addr;
+    const char *input_path;
+    long buffer_size;
+    enum zerocopy_mode zerocopy;
+    // Modo --stripes: rango [offset, offset + length) de un archivo de total bytes
+    int striped;
+    off_t offset;
+    off_t length;
+    off_t total;
+    const struct tcp_tuning *tuning;
+
+    struct send_stats stats;
+    struct tcp_effective effective; // Ajustes leídos al terminar
+    long long bytes_sent;
+    double time_taken;
+};
+
 void print_usage(const char *prog_name) {
-    fprintf(stderr, "Uso: %s <ip_servidor> <puerto> <fichero_entrada> <tam_buffer>\n", prog_name);
+    fprintf(stderr, "Uso: %s <ip_servidor> <puerto> <fichero_entrada> <tam_buffer> "
+                    "[--zerocopy=sendfile|splice|msg_zerocopy] [--connections M] [--stripes K]\n"
+                    "       " TCP_TUNING_USAGE " " CACHE_STATE_USAGE " " SAMPLER_USAGE " " REPORT_USAGE "\n", prog_name);
+}
+
+static double timeval_to_sec(const struct timeval *tv) {
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+// Modo --stripes: envía la cabecera y el rango [offset, offset + length)
+static long long send_stripe(int sock, int fd_in, struct connection *c) {
+    struct stripe_header hdr = {
+        .offset = htobe64((uint64_t)c->offset),
+        .length = htobe64((uint64_t)c->length),
+        .total = htobe64((uint64_t)c->total),
+    };
+    if (send_all(sock, &hdr, sizeof(hdr), &c->stats) == -1) {
+        perror("Error al enviar la cabecera del flujo");
+        return -1;
+    }
+
+    off_t offset = c->offset;
+    off_t end = c->offset + c->length;
+    if (c->zerocopy == ZC_SENDFILE) {
+        while (offset < end) {
+            size_t want = (end - offset < c->buffer_size) ? (size_t)(end - offset) : (size_t)c->buffer_size;
+            ssize_t sent = IO_TRACE(IO_OP_SENDFILE, sendfile(sock, fd_in, &offset, want));
+            c->stats.sendfile_calls++;
+            if (sent == -1) {
+                if (errno == EINTR) continue;
+                perror("Error en sendfile del cliente");
+                return -1;
+            }
+            if (sent == 0) {
+                break;
+            }
+            sampler_add(sent);
+        }
+        return offset - c->offset;
+    }
+
+    char *buffer = malloc(c->buffer_size);
+    if (buffer == NULL) {
+        perror("Error al asignar memoria para el buffer");
+        return -1;
+    }
+    while (offset < end) {
+        size_t want = (end - offset < c->buffer_size) ? (size_t)(end - offset) : (size_t)c->buffer_size;
+        ssize_t bytes_read = IO_TRACE(IO_OP_READ, pread(fd_in, buffer, want, offset));
+        c->stats.read_calls++;
+        if (bytes_read == -1) {
+            if (errno == EINTR) continue;
+            perror("Error en pread del cliente");
+            break;
+        }
+        if (bytes_read == 0) {
+            break;
+        }
+        if (send_all(sock, buffer, bytes_read, &c->stats) == -1) {
+            perror("Error en send del cliente");
+            break;
+        }
+        offset += bytes_read;
+        sampler_add(bytes_read);
+    }
+    free(buffer);
+    return offset - c->offset;
+}
+
+// Abre el archivo, se conecta y envía. El tiempo medido empieza tras connect(),
+// igual que en el modo de una sola conexión. Devuelve NULL (uso con pthread).
+static void *run_connection(void *arg) {
+    struct connection *c = arg;
+    c->bytes_sent = -1;
+
+    // --- Abrir archivo de entrada ---
+    // Cada conexión usa su propio descriptor para tener su propio offset.
+    int fd_in = open(c->input_path, O_RDONLY);
+    if (fd_in == -1) {
+        perror("Error al abrir el archivo de entrada");
+        return NULL;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd_in, &file_stat) == -1) {
+        perror("Error en fstat");
+        close(fd_in);
+        return NULL;
+    }
+    off_t file_size = file_stat.st_size;
+
+    // --- Configuración del socket ---
+    int client_sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (client_sock == -1) {
+        perror("Error al crear el socket del cliente");
+        close(fd_in);
+        return NULL;
+    }
+    if (tcp_tuning_apply(client_sock, c->tuning) == -1) {
+        close(fd_in);
+        close(client_sock);
+        return NULL;
+    }
+
+    // Conectarse al servidor
+    if (connect(client_sock, (const struct sockaddr *)c->server_addr, sizeof(*c->server_addr)) == -1) {
+        perror("Error al conectar con el servidor");
+        close(fd_in);
+        close(client_sock);
+        return NULL;
+    }
+
+    // --- Enviar datos ---
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (c->striped) {
+        c->bytes_sent = send_stripe(client_sock, fd_in, c);
+        if (c->bytes_sent != c->length) {
+            fprintf(stderr, "Error: el flujo en el offset %ld envió %lld de %ld bytes\n",
+                    (long)c->offset, c->bytes_sent, (long)c->length);
+            c->bytes_sent = -1;
+        }
+    } else {
+        switch (c->zerocopy) {
+            case ZC_SENDFILE:     c->bytes_sent = send_with_sendfile(client_sock, fd_in, file_size, c->buffer_size, &c->stats); break;
+            case ZC_SPLICE:       c->bytes_sent = send_with_splice(client_sock, fd_in, file_size, c->buffer_size, &c->stats); break;
+            case ZC_MSG_ZEROCOPY: c->bytes_sent = send_with_msg_zerocopy(client_sock, fd_in, file_size, c->buffer_size, &c->stats); break;
+            default:              c->bytes_sent = send_copy(client_sock, fd_in, c->buffer_size, &c->stats); break;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    c->time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    tcp_tuning_read(client_sock, &c->effective);
+
+    // --- Limpieza ---
+    close(fd_in);
+    close(client_sock);
+    return NULL;
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 5) {
+    enum cache_state cache_state = CACHE_STATE_DEFAULT;
+    enum zerocopy_mode zerocopy = ZC_NONE;
+    long connections = 1;
+    long stripes = 0;
+    struct tcp_tuning tuning;
+    memset(&tuning, 0, sizeof(tuning));
+
+    static struct option long_options[] = {
+        {"zerocopy", required_argument, NULL, 'z'},
+        {"connections", required_argument, NULL, 'c'},
+        {"stripes", required_argument, NULL, 'k'},
+        TCP_TUNING_LONG_OPTIONS,
+        CACHE_STATE_LONG_OPTIONS,
+        REPORT_LONG_OPTIONS,
+        SAMPLER_LONG_OPTIONS,
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'z':
+                if (strcmp(optarg, "sendfile") == 0) {
+                    zerocopy = ZC_SENDFILE;
+                } else if (strcmp(optarg, "splice") == 0) {
+                    zerocopy = ZC_SPLICE;
+                } else if (strcmp(optarg, "msg_zerocopy") == 0) {
+                    zerocopy = ZC_MSG_ZEROCOPY;
+                } else {
+                    fprintf(stderr, "Error: Modo zero-copy desconocido '%s'.\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'c': connections = atol(optarg); break;
+            case 'k': stripes = atol(optarg); break;
+            default:
+                if (report_parse_option(opt, optarg) == 1) break;
+                if (sampler_parse_option(opt, optarg) == 1) break;
+                if (cache_state_parse_option(opt, &cache_state)) break;
+                if (tcp_tuning_parse_option(opt, optarg, &tuning) == 1) break;
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 4) {
         print_usage(argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    const char *server_ip = argv[1];
-    int port = atoi(argv[2]);
-    const char *input_path = argv[3];
-    long buffer_size = atol(argv[4]);
+    const char *server_ip = argv[optind];
+    int port = atoi(argv[optind + 1]);
+    const char *input_path = argv[optind + 2];
+    long buffer_size = atol(argv[optind + 3]);
+    report_path("Input", input_path);
+    report_start(argc, argv);
 
     if (port <= 0 || port > 65535) {
         fprintf(stderr, "Error: El puerto debe ser un número entre 1 y 65535.\n");
@@ -48,86 +326,152 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "Error: El tamaño del buffer debe ser un entero positivo.\n");
         exit(EXIT_FAILURE);
     }
-
-    // --- Abrir archivo de entrada ---
-    int fd_in = open(input_path, O_RDONLY);
-    if (fd_in == -1) {
-        perror("Error al abrir el archivo de entrada");
+    if (connections <= 0 || connections > MAX_CONNECTIONS) {
+        fprintf(stderr, "Error: El número de conexiones debe estar entre 1 y %d.\n", MAX_CONNECTIONS);
         exit(EXIT_FAILURE);
     }
+    if (stripes != 0) {
+        if (stripes < 1 || stripes > MAX_CONNECTIONS) {
+            fprintf(stderr, "Error: El número de flujos debe estar entre 1 y %d.\n", MAX_CONNECTIONS);
+            exit(EXIT_FAILURE);
+        }
+        if (connections != 1) {
+            fprintf(stderr, "Error: --stripes y --connections son incompatibles.\n");
+            exit(EXIT_FAILURE);
+        }
+        if (zerocopy != ZC_NONE && zerocopy != ZC_SENDFILE) {
+            fprintf(stderr, "Error: --stripes solo admite --zerocopy=sendfile.\n");
+            exit(EXIT_FAILURE);
+        }
+        connections = stripes;
+    }
 
-    // --- Configuración del socket ---
-    int client_sock;
-    struct sockaddr_in server_addr;
+    // --- Reparto en rangos (modo --stripes) ---
+    // Cada rango es múltiplo de tam_buffer; con archivos pequeños algunos
+    // flujos pueden quedar vacíos, pero igualmente se conectan.
+    off_t file_size = 0;
+    off_t range_size = 0;
+    if (stripes > 0) {
+        struct stat file_stat;
+        if (stat(input_path, &file_stat) == -1) {
+            perror("Error en stat");
+            exit(EXIT_FAILURE);
+        }
+        file_size = file_stat.st_size;
+        long long blocks = (file_size + buffer_size - 1) / buffer_size;
+        long long blocks_per_stripe = (blocks + stripes - 1) / stripes;
+        range_size = (off_t)blocks_per_stripe * buffer_size;
+    }
 
-    client_sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (client_sock == -1) {
-        perror("Error al crear el socket del cliente");
-        close(fd_in);
+    // --- Estado del cache de la entrada ---
+    struct cache_report cache_report;
+    if (cache_state_prepare(cache_state, input_path, &cache_report) == -1) {
         exit(EXIT_FAILURE);
     }
 
+    struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
     server_addr.sin_port = htons(port);
     if (inet_pton(AF_INET, server_ip, &server_addr.sin_addr) <= 0) {
         perror("Dirección IP inválida o no soportada");
-        close(fd_in);
-        close(client_sock);
         exit(EXIT_FAILURE);
     }
 
-    // Conectarse al servidor
-    if (connect(client_sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        perror("Error al conectar con el servidor");
-        close(fd_in);
-        close(client_sock);
+    struct connection *conns = calloc(connections, sizeof(struct connection));
+    if (conns == NULL) {
+        perror("Error al asignar memoria para las conexiones");
         exit(EXIT_FAILURE);
     }
-    
-    // --- Asignar búfer y enviar datos ---
-    char *buffer = malloc(buffer_size);
-    if (buffer == NULL) {
-        perror("Error al asignar memoria para el buffer");
-        close(fd_in);
-        close(client_sock);
-        exit(EXIT_FAILURE);
+    for (long i = 0; i < connections; i++) {
+        conns[i].server_addr = &server_addr;
+        conns[i].input_path = input_path;
+        conns[i].buffer_size = buffer_size;
+        conns[i].zerocopy = zerocopy;
+        conns[i].tuning = &tuning;
+        if (stripes > 0) {
+            conns[i].striped = 1;
+            conns[i].total = file_size;
+            conns[i].offset = (i * range_size < file_size) ? i * range_size : file_size;
+            conns[i].length = ((conns[i].offset + range_size < file_size) ? conns[i].offset + range_size : file_size) - conns[i].offset;
+        }
     }
 
+    // --- Enviar datos ---
     struct timespec start, end;
-    long read_calls = 0;
-    long send_calls = 0;
-    ssize_t bytes_read;
+    struct rusage ru_start, ru_end;
+    int failed = 0;
 
+    io_trace_begin();
+    sampler_start();
+    getrusage(RUSAGE_SELF, &ru_start);
     clock_gettime(CLOCK_MONOTONIC, &start);
 
-    while ((bytes_read = read(fd_in, buffer, buffer_size)) > 0) {
-        read_calls++;
-        if (send(client_sock, buffer, bytes_read, 0) == -1) {
-            perror("Error en send del cliente");
-            break;
-        }
-        send_calls++;
-    }
-
-    if (bytes_read == -1) {
-        perror("Error de lectura del archivo de entrada");
+    if (send_run_connections(run_connection, conns, sizeof(struct connection), connections) == -1) {
+        failed = 1;
     }
 
     clock_gettime(CLOCK_MONOTONIC, &end);
-    double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    getrusage(RUSAGE_SELF, &ru_end);
+    io_trace_end();
+    sampler_stop();
+    double wall_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    double user_time = timeval_to_sec(&ru_end.ru_utime) - timeval_to_sec(&ru_start.ru_utime);
+    double sys_time = timeval_to_sec(&ru_end.ru_stime) - timeval_to_sec(&ru_start.ru_stime);
 
-    // --- Limpieza ---
-    free(buffer);
-    close(fd_in);
-    close(client_sock);
+    // --- Agregar resultados de todas las conexiones ---
+    struct send_stats total = {0};
+    long long bytes_sent = 0;
+    double *latencies = calloc(connections, sizeof(double));
+    for (long i = 0; i < connections; i++) {
+        struct connection *c = &conns[i];
+        if (c->bytes_sent < 0) {
+            failed = 1;
+            continue;
+        }
+        bytes_sent += c->bytes_sent;
+        send_stats_add(&total, &c->stats);
+        if (latencies != NULL) latencies[i] = c->time_taken;
+    }
+    // Con una sola conexión se mantiene el tiempo medido tras connect()
+    double time_taken = connections == 1 ? conns[0].time_taken : wall_time;
+
+    if (failed) {
+        free(latencies);
+        free(conns);
+        exit(EXIT_FAILURE);
+    }
 
     // --- Imprimir resultados ---
     printf("Mechanism: TCP Client\n");
     printf("BufferSize: %ld\n", buffer_size);
     printf("TimeTakenClient: %.6f\n", time_taken);
-    printf("ReadCalls: %ld\n", read_calls);
-    printf("SendCalls: %ld\n", send_calls);
+    cache_state_print(&cache_report);
+    printf("ZeroCopy: %s\n", zerocopy_names[zerocopy]);
+    printf("BytesSent: %lld\n", bytes_sent);
+    send_stats_print(&total, zerocopy == ZC_MSG_ZEROCOPY);
+    if (connections > 1 && latencies != NULL) {
+        send_print_connections(latencies, connections, bytes_sent, wall_time);
+    }
+    if (stripes > 0) {
+        printf("Stripes: %ld\n", stripes);
+        for (long i = 0; i < stripes; i++) {
+            struct connection *c = &conns[i];
+            printf("Stream%ldOffset: %ld\n", i, (long)c->offset);
+            printf("Stream%ldBytes: %lld\n", i, c->bytes_sent);
+            printf("Stream%ldTime: %.6f\n", i, c->time_taken);
+            printf("Stream%ldThroughputMBs: %.2f\n", i,
+                   c->time_taken > 0 ? c->bytes_sent / (1024.0 * 1024.0) / c->time_taken : 0.0);
+        }
+    }
+    tcp_tuning_print(&conns[0].effective);
+    printf("UserTime: %.6f\n", user_time);
+    printf("SysTime: %.6f\n", sys_time);
+    printf("CpuNsPerByte: %.4f\n", bytes_sent > 0 ? (user_time + sys_time) * 1e9 / bytes_sent : 0.0);
+    sampler_print();
+    io_trace_print();
 
+    free(latencies);
+    free(conns);
     return 0;
-} 
\ No newline at end of file
+}
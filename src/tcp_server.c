@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -5,9 +6,24 @@
 #include <fcntl.h>
 #include <time.h>
 #include <errno.h>
+#include <stdint.h>
+#include <endian.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
 #include <sys/socket.h>
+#include <sys/resource.h>
 #include <arpa/inet.h>
 
+#include "tcp_tuning.h"
+#include "dio_align.h"
+#include "epoll_server.h"
+#include "recv_paths.h"
+#include "io_trace.h"
+#include "report.h"
+#include "sampler.h"
+
 /**
  * tcp_server.c
  *
@@ -21,27 +37,612 @@
  * lento para comunicación en la misma máquina, pero es necesario para la
  * comunicación entre máquinas distintas.
  *
+ * Por defecto cada bloque se recibe con recv() a un búfer de usuario y se
+ * escribe con write(). Con --recv se puede elegir un camino que no toque
+ * los datos desde el espacio de usuario o que evite el cache de página:
+ *  - splice: splice() del socket a una tubería y de ésta al archivo; el
+ *            servidor nunca copia los bytes de la carga útil.
+ *  - direct: el archivo de salida se abre con O_DIRECT y los datos se
+ *            reciben en un anillo de búferes alineados que un hilo escritor
+ *            vuelca mientras se recibe el siguiente, de modo que cada
+ *            write() es de tamaño y dirección alineados (alineación de
+ *            statx(STATX_DIOALIGN), ver common/recv_paths.h). El último
+ *            bloque se rellena y el archivo se recorta al final.
+ * Se informa el tiempo de CPU de usuario y de sistema (getrusage) del
+ * intervalo medido y su coste por byte recibido.
+ *
+ * Con --epoll el servidor deja de atender una única conexión y pasa a ser
+ * persistente: un bucle de eventos epoll (edge-triggered, sockets no
+ * bloqueantes) atiende muchas subidas simultáneas, cada una escrita en su
+ * propio archivo <fichero_salida>.<n>. Termina tras --max-conns conexiones
+ * completadas o al recibir SIGINT/SIGTERM, e informa el rendimiento agregado
+ * y los percentiles de la duración de cada conexión.
+ *
+ * Con --workers N (implica --epoll) se crean N hilos, cada uno con su propio
+ * socket de escucha SO_REUSEPORT en el mismo puerto y fijado a una CPU
+ * distinta. El kernel reparte las conexiones entrantes entre los sockets, sin
+ * un accept() compartido, lo que permite ver cómo escala la recepción con el
+ * número de núcleos. Además del resultado agregado se informa, por hilo, la
+ * CPU asignada, las conexiones atendidas, los bytes recibidos y su tiempo de
+ * CPU, y el total de softirqs NET_RX del sistema durante la prueba (una
+ * proporción alta de tiempo de sistema con pocas softirqs extra apunta a la
+ * pila de red, no a la copia, como límite).
+ *
+ * Con --stripes K el servidor recibe un único archivo repartido en K flujos
+ * paralelos (tcp_client --stripes K). Acepta K conexiones, cada una atendida
+ * por un hilo que lee la cabecera (offset, longitud, tamaño total) y escribe
+ * los datos con pwrite() en su posición, reconstruyendo el archivo en
+ * <fichero_salida>. Se informa el rendimiento de cada flujo y el agregado.
+ *
+ * Las opciones de ajuste TCP (--sndbuf, --rcvbuf, --nodelay, --cork,
+ * --notsent-lowat, --quickack, --cc) se aplican al socket de escucha antes
+ * de listen() y de nuevo a cada conexión aceptada. Con --quickack, el ACK
+ * inmediato se reactiva tras cada recv(). Los valores efectivos de la
+ * primera conexión (getsockopt) se imprimen junto con los resultados.
+ *
  * Argumentos:
  *  - <puerto>: Puerto en el que el servidor escuchará.
  *  - <fichero_salida>: Ruta al archivo donde se guardarán los datos recibidos.
- *  - <tam_buffer>: Tamaño del búfer de recepción/escritura en bytes.
+ *  - <tam_buffer>: Tamaño del búfer de recepción/escritura en bytes (con
+ *                  --recv=direct, múltiplo de la alineación).
+ *  - [--recv=M]: Opcional. splice o direct.
+ *  - [--epoll]: Opcional. Modo persistente multi-cliente.
+ *  - [--max-conns K]: Opcional. Con --epoll, terminar tras K conexiones
+ *                     (0 = hasta recibir una señal). Por defecto 0.
+ *  - [--workers N]: Opcional. N hilos con SO_REUSEPORT, uno por CPU.
+ *  - [--stripes K]: Opcional. Recibir un archivo repartido en K flujos.
+ *  - [--sndbuf N] [--rcvbuf N]: Opcional. SO_SNDBUF / SO_RCVBUF en bytes.
+ *  - [--nodelay] [--cork] [--quickack]: Opcional. TCP_NODELAY, TCP_CORK y
+ *                                       TCP_QUICKACK.
+ *  - [--notsent-lowat N]: Opcional. TCP_NOTSENT_LOWAT en bytes.
+ *  - [--cc ALG]: Opcional. Algoritmo de control de congestión (p. ej. bbr).
+ *  - [--sample-ms N]: Opcional. Cada N ms anota los bytes transferidos e informa
+ *                     la serie de MB/s y el mayor parón (ver common/sampler.h).
+ *  - [--json] [--json-out F] [--tag K=V]: Opcionales. Resultados en JSON, una
+ *                     línea por bloque con los metadatos de la ejecución (ver common/report.h).
  */
 
 #define MAX_PENDING_CONNECTIONS 5
+#define EPOLL_BACKLOG SOMAXCONN
+#define MAX_WORKERS 256
+#define MAX_STRIPES 1024
+
+enum recv_mode { RECV_COPY, RECV_SPLICE, RECV_DIRECT };
+
+static const char *recv_mode_names[] = { "copy", "splice", "direct" };
+
+// Ajustes TCP pedidos en la línea de comandos
+static struct tcp_tuning tuning;
+
+// Contadores de llamadas al sistema del bucle de recepción
+static struct recv_stats stats;
+
+// Un hilo del modo --workers con su propio socket de escucha
+struct worker {
+    int id;
+    int cpu;                  // CPU a la que se fijó el hilo (-1 si no se pudo)
+    int listen_sock;
+    struct epoll_server srv;
+    struct epoll_stats st;
+    struct tcp_effective effective; // Ajustes de la primera conexión del hilo
+    double cpu_time;          // Tiempo de CPU del hilo (s)
+    int ret;
+    pthread_t tid;
+};
+
+// Cabecera de cada flujo en el modo --stripes (campos en orden de red).
+// Debe coincidir con la de tcp_client.c.
+struct stripe_header {
+    uint64_t offset;
+    uint64_t length;
+    uint64_t total;           // Tamaño total del archivo
+};
+
+// Un flujo del modo --stripes
+struct stream {
+    int sock;
+    int fd_out;
+    long buffer_size;
+    off_t offset;
+    long long bytes;
+    struct tcp_effective effective;
+    long recv_calls;
+    long write_calls;
+    double time_taken;
+    int ret;
+    pthread_t tid;
+};
+
+static volatile sig_atomic_t stop_requested = 0;
 
 void print_usage(const char *prog_name) {
-    fprintf(stderr, "Uso: %s <puerto> <fichero_salida> <tam_buffer>\n", prog_name);
+    fprintf(stderr, "Uso: %s <puerto> <fichero_salida> <tam_buffer> [--recv=splice|direct] "
+                    "[--epoll] [--max-conns K] [--workers N] [--stripes K]\n"
+                    "       " TCP_TUNING_USAGE " " SAMPLER_USAGE " " REPORT_USAGE "\n", prog_name);
+}
+
+static void handle_stop_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static double timespec_diff(const struct timespec *a, const struct timespec *b) {
+    return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) / 1e9;
+}
+
+static double timeval_to_sec(const struct timeval *tv) {
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+// Ganchos del modo epoll (y rearm_quickack también en recv_paths): los ajustes
+// TCP de cada conexión. arg es el struct tcp_effective donde se guardan los
+// de la primera que termina.
+static void epoll_setup(int sock, void *arg) {
+    (void)arg;
+    tcp_tuning_apply(sock, &tuning);
+}
+
+static void rearm_quickack(int sock, void *arg) {
+    (void)arg;
+    tcp_tuning_rearm_quickack(sock, &tuning);
+}
+
+static void epoll_finish(int sock, void *arg) {
+    struct tcp_effective *effective = arg;
+    if (!effective->valid) {
+        tcp_tuning_read(sock, effective);
+    }
+}
+
+static void epoll_print(void *arg) {
+    tcp_tuning_print(arg);
+}
+
+static const struct epoll_server_hooks epoll_hooks = {
+    .setup = epoll_setup,
+    .rearm = rearm_quickack,
+    .finish = epoll_finish,
+    .print = epoll_print,
+};
+
+// Crea un socket TCP de escucha en el puerto dado. Devuelve -1 si falla.
+static int create_listen_socket(int port, int reuseport, int backlog) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock == -1) {
+        perror("Error al crear el socket");
+        return -1;
+    }
+
+    // Permite reutilizar el puerto inmediatamente después de cerrar el servidor
+    int reuse = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
+        perror("setsockopt(SO_REUSEADDR) failed");
+    }
+    // Las conexiones aceptadas heredan los ajustes del socket de escucha
+    if (tcp_tuning_apply(sock, &tuning) == -1) {
+        close(sock);
+        return -1;
+    }
+    // Varios sockets en el mismo puerto; el kernel reparte las conexiones
+    if (reuseport && setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) < 0) {
+        perror("setsockopt(SO_REUSEPORT) failed");
+        close(sock);
+        return -1;
+    }
+
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = htonl(INADDR_ANY); // Escuchar en todas las interfaces
+    server_addr.sin_port = htons(port);
+
+    if (bind(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+        perror("Error en bind");
+        close(sock);
+        return -1;
+    }
+
+    if (listen(sock, backlog) == -1) {
+        perror("Error en listen");
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// Suma las softirqs NET_RX de todas las CPU (/proc/softirqs). -1 si no se pudo leer.
+static long long read_net_rx_softirqs(void) {
+    FILE *f = fopen("/proc/softirqs", "r");
+    if (f == NULL) {
+        return -1;
+    }
+    char line[8192];
+    long long total = -1;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char *p = strstr(line, "NET_RX:");
+        if (p == NULL) continue;
+        p += strlen("NET_RX:");
+        total = 0;
+        char *end;
+        for (;;) {
+            long long v = strtoll(p, &end, 10);
+            if (end == p) break;
+            total += v;
+            p = end;
+        }
+        break;
+    }
+    fclose(f);
+    return total;
+}
+
+// Hilo del modo --workers: se fija a su CPU y ejecuta el bucle epoll
+static void *worker_main(void *arg) {
+    struct worker *w = arg;
+
+    if (w->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(w->cpu, &set);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err != 0) {
+            fprintf(stderr, "Aviso: no se pudo fijar el hilo %d a la CPU %d: %s\n", w->id, w->cpu, strerror(err));
+            w->cpu = -1;
+        }
+    }
+
+    w->ret = epoll_server_run(w->listen_sock, &w->srv, &w->st);
+
+    struct timespec cpu;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+    w->cpu_time = cpu.tv_sec + cpu.tv_nsec / 1e9;
+    return NULL;
+}
+
+// Modo --workers: N sockets SO_REUSEPORT, cada uno atendido por un hilo fijado a una CPU
+static int run_reuseport_workers(int port, const char *output_path, long buffer_size,
+                                 long max_conns, long num_workers) {
+    struct worker *workers = calloc(num_workers, sizeof(struct worker));
+    if (workers == NULL) {
+        perror("Error al asignar memoria para los hilos");
+        return -1;
+    }
+
+    // CPUs permitidas al proceso, asignadas en orden a los hilos
+    cpu_set_t allowed;
+    int cpus[CPU_SETSIZE];
+    int num_cpus = 0;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &allowed)) cpus[num_cpus++] = c;
+        }
+    }
+
+    // Todos los sockets se enlazan antes de arrancar los hilos, para que el
+    // grupo SO_REUSEPORT esté completo cuando lleguen los clientes.
+    int ret = 0;
+    long created = 0;
+    for (long i = 0; i < num_workers; i++) {
+        struct worker *w = &workers[i];
+        w->id = i;
+        w->cpu = num_cpus > 0 ? cpus[i % num_cpus] : -1;
+        w->srv = (struct epoll_server){
+            .output_path = output_path,
+            .buffer_size = buffer_size,
+            .max_conns = max_conns,
+            .stop = &stop_requested,
+            .hooks = &epoll_hooks,
+            .hook_arg = &w->effective,
+        };
+        w->listen_sock = create_listen_socket(port, 1, EPOLL_BACKLOG);
+        if (w->listen_sock == -1) {
+            ret = -1;
+            break;
+        }
+        created++;
+    }
+
+    struct rusage ru_start, ru_end;
+    long long softirq_start = read_net_rx_softirqs();
+    io_trace_begin();
+    sampler_start();
+    getrusage(RUSAGE_SELF, &ru_start);
+
+    long started = 0;
+    if (ret == 0) {
+        for (long i = 0; i < num_workers; i++) {
+            if (pthread_create(&workers[i].tid, NULL, worker_main, &workers[i]) != 0) {
+                fprintf(stderr, "Error al crear el hilo %ld\n", i);
+                stop_requested = 1;
+                ret = -1;
+                break;
+            }
+            started++;
+        }
+    }
+    for (long i = 0; i < started; i++) {
+        pthread_join(workers[i].tid, NULL);
+        if (workers[i].ret == -1) ret = -1;
+    }
+
+    getrusage(RUSAGE_SELF, &ru_end);
+    io_trace_end();
+    sampler_stop();
+    long long softirq_end = read_net_rx_softirqs();
+    for (long i = 0; i < created; i++) {
+        close(workers[i].listen_sock);
+    }
+
+    if (ret == 0) {
+        struct epoll_stats total;
+        struct tcp_effective effective;
+        memset(&total, 0, sizeof(total));
+        memset(&effective, 0, sizeof(effective));
+        for (long i = 0; i < num_workers; i++) {
+            epoll_stats_merge(&total, &workers[i].st);
+            if (!effective.valid && workers[i].effective.valid) {
+                effective = workers[i].effective;
+            }
+        }
+        struct epoll_server srv = workers[0].srv;
+        srv.hook_arg = &effective;
+        epoll_stats_print("TCP Server (reuseport)", &srv, &total,
+                          timeval_to_sec(&ru_end.ru_utime) - timeval_to_sec(&ru_start.ru_utime),
+                          timeval_to_sec(&ru_end.ru_stime) - timeval_to_sec(&ru_start.ru_stime));
+        printf("Workers: %ld\n", num_workers);
+        if (softirq_start >= 0 && softirq_end >= 0) {
+            printf("NetRxSoftirqs: %lld\n", softirq_end - softirq_start);
+        }
+        for (long i = 0; i < num_workers; i++) {
+            struct worker *w = &workers[i];
+            printf("Worker%ldCpu: %d\n", i, w->cpu);
+            printf("Worker%ldConnections: %ld\n", i, w->st.connections);
+            printf("Worker%ldBytesReceived: %lld\n", i, w->st.bytes);
+            printf("Worker%ldCpuTime: %.6f\n", i, w->cpu_time);
+        }
+        free(total.latencies);
+    }
+
+    for (long i = 0; i < num_workers; i++) {
+        free(workers[i].st.latencies);
+    }
+    free(workers);
+    return ret;
+}
+
+// Hilo del modo --stripes: lee la cabecera y escribe el rango con pwrite()
+static void *stream_main(void *arg) {
+    struct stream *sm = arg;
+    sm->ret = -1;
+
+    struct stripe_header hdr;
+    size_t got = 0;
+    while (got < sizeof(hdr)) {
+        ssize_t n = IO_TRACE(IO_OP_RECV, recv(sm->sock, (char *)&hdr + got, sizeof(hdr) - got, MSG_WAITALL));
+        if (n == -1 && errno == EINTR) continue;
+        if (n <= 0) {
+            if (n == -1) perror("Error al recibir la cabecera del flujo");
+            else fprintf(stderr, "Error: conexión cerrada antes de la cabecera del flujo\n");
+            return NULL;
+        }
+        got += n;
+    }
+    off_t offset = (off_t)be64toh(hdr.offset);
+    off_t length = (off_t)be64toh(hdr.length);
+    off_t total = (off_t)be64toh(hdr.total);
+    if (offset < 0 || length < 0 || offset + length > total) {
+        fprintf(stderr, "Error: cabecera de flujo inválida (offset %ld, longitud %ld, total %ld)\n",
+                (long)offset, (long)length, (long)total);
+        return NULL;
+    }
+    sm->offset = offset;
+
+    // Todos los flujos fijan el mismo tamaño final, incluidos los vacíos
+    if (ftruncate(sm->fd_out, total) == -1) {
+        perror("Error en ftruncate");
+        return NULL;
+    }
+
+    char *buffer = malloc(sm->buffer_size);
+    if (buffer == NULL) {
+        perror("Error al asignar memoria para el buffer");
+        return NULL;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (sm->bytes < length) {
+        size_t want = (length - sm->bytes < sm->buffer_size) ? (size_t)(length - sm->bytes) : (size_t)sm->buffer_size;
+        ssize_t n = IO_TRACE(IO_OP_RECV, recv(sm->sock, buffer, want, 0));
+        sm->recv_calls++;
+        tcp_tuning_rearm_quickack(sm->sock, &tuning);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            perror("Error en recv del servidor");
+            break;
+        }
+        if (n == 0) {
+            fprintf(stderr, "Error: el flujo en el offset %ld terminó tras %lld de %ld bytes\n",
+                    (long)offset, sm->bytes, (long)length);
+            break;
+        }
+        ssize_t bytes_written = IO_TRACE(IO_OP_WRITE, pwrite(sm->fd_out, buffer, n, offset + sm->bytes));
+        sm->write_calls++;
+        if (bytes_written != n) {
+            perror("Error de escritura incompleta en el servidor");
+            break;
+        }
+        sm->bytes += n;
+        sampler_add(n);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    sm->time_taken = timespec_diff(&start, &end);
+    tcp_tuning_read(sm->sock, &sm->effective);
+    free(buffer);
+    if (sm->bytes == length) {
+        sm->ret = 0;
+    }
+    return NULL;
+}
+
+// Modo --stripes: acepta K conexiones y reconstruye el archivo con un hilo por flujo
+static int run_striped_server(int listen_sock, const char *output_path, long buffer_size, long stripes) {
+    int fd_out = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_out == -1) {
+        perror("Error al abrir el archivo de salida");
+        return -1;
+    }
+
+    struct stream *streams = calloc(stripes, sizeof(struct stream));
+    if (streams == NULL) {
+        perror("Error al asignar memoria para los flujos");
+        close(fd_out);
+        return -1;
+    }
+
+    struct timespec start, end;
+    struct rusage ru_start, ru_end;
+    int ret = 0;
+    long started = 0;
+    for (long i = 0; i < stripes; i++) {
+        struct stream *sm = &streams[i];
+        sm->sock = accept(listen_sock, NULL, NULL);
+        if (sm->sock == -1) {
+            if (errno == EINTR) { i--; continue; }
+            perror("Error en accept");
+            ret = -1;
+            break;
+        }
+        // El tiempo agregado empieza con la primera conexión
+        if (i == 0) {
+            io_trace_begin();
+            sampler_start();
+            getrusage(RUSAGE_SELF, &ru_start);
+            clock_gettime(CLOCK_MONOTONIC, &start);
+        }
+        tcp_tuning_apply(sm->sock, &tuning);
+        sm->fd_out = fd_out;
+        sm->buffer_size = buffer_size;
+        if (pthread_create(&sm->tid, NULL, stream_main, sm) != 0) {
+            fprintf(stderr, "Error al crear el hilo del flujo %ld\n", i);
+            close(sm->sock);
+            ret = -1;
+            break;
+        }
+        started++;
+    }
+    for (long i = 0; i < started; i++) {
+        pthread_join(streams[i].tid, NULL);
+        close(streams[i].sock);
+        if (streams[i].ret == -1) ret = -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    getrusage(RUSAGE_SELF, &ru_end);
+    io_trace_end();
+    sampler_stop();
+    close(fd_out);
+
+    if (ret == 0) {
+        double time_taken = timespec_diff(&start, &end);
+        double user_time = timeval_to_sec(&ru_end.ru_utime) - timeval_to_sec(&ru_start.ru_utime);
+        double sys_time = timeval_to_sec(&ru_end.ru_stime) - timeval_to_sec(&ru_start.ru_stime);
+        long long bytes = 0;
+        long total_recv = 0, total_write = 0;
+        for (long i = 0; i < stripes; i++) {
+            bytes += streams[i].bytes;
+            total_recv += streams[i].recv_calls;
+            total_write += streams[i].write_calls;
+        }
+
+        printf("Mechanism: TCP Server (striped)\n");
+        printf("BufferSize: %ld\n", buffer_size);
+        printf("TimeTakenServer: %.6f\n", time_taken);
+        printf("Stripes: %ld\n", stripes);
+        printf("BytesReceived: %lld\n", bytes);
+        printf("AggregateThroughputMBs: %.2f\n", time_taken > 0 ? bytes / (1024.0 * 1024.0) / time_taken : 0.0);
+        printf("RecvCalls: %ld\n", total_recv);
+        printf("WriteCalls: %ld\n", total_write);
+        tcp_tuning_print(&streams[0].effective);
+        printf("UserTime: %.6f\n", user_time);
+        printf("SysTime: %.6f\n", sys_time);
+        printf("CpuNsPerByte: %.4f\n", bytes > 0 ? (user_time + sys_time) * 1e9 / bytes : 0.0);
+        for (long i = 0; i < stripes; i++) {
+            struct stream *sm = &streams[i];
+            printf("Stream%ldOffset: %ld\n", i, (long)sm->offset);
+            printf("Stream%ldBytes: %lld\n", i, sm->bytes);
+            printf("Stream%ldTime: %.6f\n", i, sm->time_taken);
+            printf("Stream%ldThroughputMBs: %.2f\n", i,
+                   sm->time_taken > 0 ? sm->bytes / (1024.0 * 1024.0) / sm->time_taken : 0.0);
+        }
+        sampler_print();
+        io_trace_print();
+    }
+
+    free(streams);
+    return ret;
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 4) {
+    enum recv_mode mode = RECV_COPY;
+    int use_epoll = 0;
+    long max_conns = 0;
+    long num_workers = 0;
+    long stripes = 0;
+
+    static struct option long_options[] = {
+        {"recv", required_argument, NULL, 'r'},
+        {"epoll", no_argument, NULL, 'e'},
+        {"max-conns", required_argument, NULL, 'k'},
+        {"workers", required_argument, NULL, 'w'},
+        {"stripes", required_argument, NULL, 's'},
+        TCP_TUNING_LONG_OPTIONS,
+        REPORT_LONG_OPTIONS,
+        SAMPLER_LONG_OPTIONS,
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'r':
+                if (strcmp(optarg, "splice") == 0) {
+                    mode = RECV_SPLICE;
+                } else if (strcmp(optarg, "direct") == 0) {
+                    mode = RECV_DIRECT;
+                } else {
+                    fprintf(stderr, "Error: Modo de recepción desconocido '%s'.\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'e': use_epoll = 1; break;
+            case 'k': max_conns = atol(optarg); break;
+            case 'w':
+                num_workers = atol(optarg);
+                use_epoll = 1;
+                break;
+            case 's': stripes = atol(optarg); break;
+            default:
+                if (report_parse_option(opt, optarg) == 1) break;
+                if (sampler_parse_option(opt, optarg) == 1) break;
+                if (tcp_tuning_parse_option(opt, optarg, &tuning) == 1) break;
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 3) {
         print_usage(argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    int port = atoi(argv[1]);
-    const char *output_path = argv[2];
-    long buffer_size = atol(argv[3]);
+    int port = atoi(argv[optind]);
+    const char *output_path = argv[optind + 1];
+    long buffer_size = atol(argv[optind + 2]);
+    report_path("Output", output_path);
+    report_start(argc, argv);
 
     if (port <= 0 || port > 65535) {
         fprintf(stderr, "Error: El puerto debe ser un número entre 1 y 65535.\n");
@@ -51,105 +652,192 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "Error: El tamaño del buffer debe ser un entero positivo.\n");
         exit(EXIT_FAILURE);
     }
+    if (use_epoll && mode != RECV_COPY) {
+        fprintf(stderr, "Error: --epoll solo admite el modo de recepción por defecto.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (max_conns < 0) {
+        fprintf(stderr, "Error: --max-conns debe ser un entero no negativo.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (use_epoll && num_workers != 0 && (num_workers < 1 || num_workers > MAX_WORKERS)) {
+        fprintf(stderr, "Error: El número de hilos debe estar entre 1 y %d.\n", MAX_WORKERS);
+        exit(EXIT_FAILURE);
+    }
+
+    if (stripes != 0) {
+        if (stripes < 1 || stripes > MAX_STRIPES) {
+            fprintf(stderr, "Error: El número de flujos debe estar entre 1 y %d.\n", MAX_STRIPES);
+            exit(EXIT_FAILURE);
+        }
+        if (use_epoll || mode != RECV_COPY) {
+            fprintf(stderr, "Error: --stripes no se puede combinar con --epoll, --workers ni --recv.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Sin SA_RESTART, para que epoll_wait vuelva al recibir la señal
+    if (use_epoll) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = handle_stop_signal;
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
+    }
+
+    if (num_workers > 0) {
+        if (run_reuseport_workers(port, output_path, buffer_size, max_conns, num_workers) == -1) {
+            exit(EXIT_FAILURE);
+        }
+        return 0;
+    }
 
     // --- Configuración del socket ---
     int server_sock, client_sock;
-    struct sockaddr_in server_addr, client_addr;
+    struct sockaddr_in client_addr;
     socklen_t client_addr_len = sizeof(client_addr);
 
-    server_sock = socket(AF_INET, SOCK_STREAM, 0);
+    server_sock = create_listen_socket(port, 0, (use_epoll || stripes > 0) ? EPOLL_BACKLOG : MAX_PENDING_CONNECTIONS);
     if (server_sock == -1) {
-        perror("Error al crear el socket");
         exit(EXIT_FAILURE);
     }
 
-    // Permite reutilizar el puerto inmediatamente después de cerrar el servidor
-    int opt = 1;
-    if (setsockopt(server_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-        perror("setsockopt(SO_REUSEADDR) failed");
+    if (stripes > 0) {
+        int ret = run_striped_server(server_sock, output_path, buffer_size, stripes);
+        close(server_sock);
+        if (ret == -1) {
+            exit(EXIT_FAILURE);
+        }
+        return 0;
     }
 
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = htonl(INADDR_ANY); // Escuchar en todas las interfaces
-    server_addr.sin_port = htons(port);
+    if (use_epoll) {
+        struct tcp_effective effective;
+        memset(&effective, 0, sizeof(effective));
+        struct epoll_server srv = {
+            .output_path = output_path,
+            .buffer_size = buffer_size,
+            .max_conns = max_conns,
+            .stop = &stop_requested,
+            .hooks = &epoll_hooks,
+            .hook_arg = &effective,
+        };
+        struct epoll_stats st;
+        struct rusage ru_start, ru_end;
+        memset(&st, 0, sizeof(st));
 
-    if (bind(server_sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        perror("Error en bind");
+        io_trace_begin();
+        sampler_start();
+        getrusage(RUSAGE_SELF, &ru_start);
+        int ret = epoll_server_run(server_sock, &srv, &st);
+        getrusage(RUSAGE_SELF, &ru_end);
+        io_trace_end();
+        sampler_stop();
         close(server_sock);
-        exit(EXIT_FAILURE);
-    }
 
-    if (listen(server_sock, MAX_PENDING_CONNECTIONS) == -1) {
-        perror("Error en listen");
-        close(server_sock);
-        exit(EXIT_FAILURE);
+        if (ret == -1) {
+            free(st.latencies);
+            exit(EXIT_FAILURE);
+        }
+        epoll_stats_print("TCP Server (epoll)", &srv, &st,
+                          timeval_to_sec(&ru_end.ru_utime) - timeval_to_sec(&ru_start.ru_utime),
+                          timeval_to_sec(&ru_end.ru_stime) - timeval_to_sec(&ru_start.ru_stime));
+        free(st.latencies);
+        return 0;
     }
     
-    // printf("Servidor TCP esperando conexión en el puerto %d\n", port);
-
-    client_sock = accept(server_sock, (struct sockaddr *)&client_addr, &client_addr_len);
-    if (client_sock == -1) {
-        perror("Error en accept");
-        close(server_sock);
-        exit(EXIT_FAILURE);
-    }
-
     // --- Abrir archivo de salida ---
-    int fd_out = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    // Antes de aceptar, para rechazar un búfer no alineado sin dejar al cliente a medias
+    int fd_out = open(output_path, O_WRONLY | O_CREAT | O_TRUNC | (mode == RECV_DIRECT ? O_DIRECT : 0), 0644);
     if (fd_out == -1) {
         perror("Error al abrir el archivo de salida");
-        close(client_sock);
         close(server_sock);
         exit(EXIT_FAILURE);
     }
-    
-    // --- Recibir datos ---
-    char *buffer = malloc(buffer_size);
-    if (!buffer) {
-        perror("malloc");
+    struct dio_align align;
+    if (mode == RECV_DIRECT) {
+        if (dio_align_probe(fd_out, &align) == -1) {
+            fprintf(stderr, "Error: El sistema de archivos de la salida no admite O_DIRECT.\n");
+            close(fd_out);
+            close(server_sock);
+            exit(EXIT_FAILURE);
+        }
+        if (buffer_size % align.offset_align != 0) {
+            fprintf(stderr, "Error: Con --recv=direct el tamaño del buffer debe ser múltiplo de %u.\n", align.offset_align);
+            close(fd_out);
+            close(server_sock);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // printf("Servidor TCP esperando conexión en el puerto %d\n", port);
+
+    client_sock = accept(server_sock, (struct sockaddr *)&client_addr, &client_addr_len);
+    if (client_sock == -1) {
+        perror("Error en accept");
         close(fd_out);
-        close(client_sock);
         close(server_sock);
         exit(EXIT_FAILURE);
     }
+    tcp_tuning_apply(client_sock, &tuning);
 
+    // --- Recibir datos ---
+    struct recv_hook hook = { .rearm = rearm_quickack };
     struct timespec start, end;
-    long recv_calls = 0;
-    long write_calls = 0;
-    ssize_t bytes_received;
+    struct rusage ru_start, ru_end;
+    long long bytes_received;
 
+    io_trace_begin();
+    sampler_start();
+    getrusage(RUSAGE_SELF, &ru_start);
     clock_gettime(CLOCK_MONOTONIC, &start);
 
-    while ((bytes_received = recv(client_sock, buffer, buffer_size, 0)) > 0) {
-        recv_calls++;
-        ssize_t bytes_written = write(fd_out, buffer, bytes_received);
-        write_calls++;
-        if (bytes_written != bytes_received) {
-            perror("Error de escritura incompleta en el servidor");
-            break;
-        }
-    }
-
-    if (bytes_received == -1) {
-        perror("Error en recv del servidor");
+    switch (mode) {
+        case RECV_SPLICE: bytes_received = recv_with_splice(client_sock, fd_out, buffer_size, &hook, &stats); break;
+        case RECV_DIRECT: bytes_received = recv_direct(client_sock, fd_out, buffer_size, &align, &hook, &stats); break;
+        default:          bytes_received = recv_copy(client_sock, fd_out, buffer_size, &hook, &stats); break;
     }
 
     clock_gettime(CLOCK_MONOTONIC, &end);
+    getrusage(RUSAGE_SELF, &ru_end);
+    io_trace_end();
+    sampler_stop();
     double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
-    
+    double user_time = timeval_to_sec(&ru_end.ru_utime) - timeval_to_sec(&ru_start.ru_utime);
+    double sys_time = timeval_to_sec(&ru_end.ru_stime) - timeval_to_sec(&ru_start.ru_stime);
+    struct tcp_effective effective;
+    tcp_tuning_read(client_sock, &effective);
+
     // --- Limpieza ---
-    free(buffer);
     close(fd_out);
     close(client_sock);
     close(server_sock);
 
+    if (bytes_received < 0) {
+        exit(EXIT_FAILURE);
+    }
+
     // --- Imprimir resultados ---
     printf("Mechanism: TCP Server\n");
     printf("BufferSize: %ld\n", buffer_size);
     printf("TimeTakenServer: %.6f\n", time_taken);
-    printf("RecvCalls: %ld\n", recv_calls);
-    printf("WriteCalls: %ld\n", write_calls);
+    printf("RecvMode: %s\n", recv_mode_names[mode]);
+    printf("BytesReceived: %lld\n", bytes_received);
+    printf("RecvCalls: %ld\n", stats.recv_calls);
+    printf("WriteCalls: %ld\n", stats.write_calls);
+    printf("SpliceCalls: %ld\n", stats.splice_calls);
+    if (mode == RECV_DIRECT) {
+        printf("RecvRingSlots: %d\n", RECV_RING_SLOTS);
+        printf("DioMemAlign: %u\n", align.mem_align);
+        printf("DioOffsetAlign: %u\n", align.offset_align);
+        printf("DioAlignSource: %s\n", align.from_statx ? "statx" : "fallback");
+    }
+    tcp_tuning_print(&effective);
+    printf("UserTime: %.6f\n", user_time);
+    printf("SysTime: %.6f\n", sys_time);
+    printf("CpuNsPerByte: %.4f\n", bytes_received > 0 ? (user_time + sys_time) * 1e9 / bytes_received : 0.0);
+    sampler_print();
+    io_trace_print();
 
     return 0;
 } 
\ No newline at end of file
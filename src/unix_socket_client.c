@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -5,9 +6,20 @@
 #include <fcntl.h>
 #include <time.h>
 #include <errno.h>
+#include <endian.h>
+#include <stdint.h>
+#include <getopt.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
 #include <sys/un.h>
 
+#include "cache_state.h"
+#include "io_trace.h"
+#include "report.h"
+#include "sampler.h"
+#include "send_paths.h"
+
 /**
  * unix_socket_client.c
  *
@@ -18,105 +30,325 @@
  * cliente-servidor para IPC local (Stallings, Cap. 18). Mide el rendimiento
  * desde la perspectiva del emisor.
  *
+ * Por defecto cada bloque se lee con read() a un búfer de usuario y se envía
+ * con send(), es decir, dos copias por byte. Con --zerocopy el archivo se
+ * entrega al socket sin pasar por un búfer de usuario (ver common/send_paths.h;
+ * msg_zerocopy, que Linux solo implementa para TCP/UDP, se rechaza al leer
+ * las opciones):
+ *  - sendfile:     sendfile() del archivo al socket.
+ *  - splice:       splice() del archivo a una tubería y de ésta al socket.
+ *  - fdpass:       no se envían bytes: el descriptor abierto del archivo se
+ *                  pasa al servidor con SCM_RIGHTS (servidor con --recv=fd),
+ *                  que materializa la salida a partir de él. El cliente espera
+ *                  la confirmación con los bytes materializados, de modo que
+ *                  el tiempo medido cubre el traspaso completo.
+ * Se informa el tiempo de CPU de usuario y de sistema (getrusage) del
+ * intervalo medido y su coste por byte enviado.
+ *
+ * Con --connections M se abren M conexiones simultáneas, cada una desde su
+ * propio hilo y enviando el archivo completo (para ejercitar el modo --epoll
+ * del servidor). Se informa el rendimiento agregado y los percentiles de la
+ * duración de cada conexión.
+ *
  * Argumentos:
  *  - <socket_path>: Ruta del sistema de archivos para el socket del servidor.
  *  - <fichero_entrada>: Ruta al archivo que se va a enviar.
- *  - <tam_buffer>: Tamaño del búfer de lectura/envío en bytes.
+ *  - <tam_buffer>: Tamaño del búfer de lectura/envío en bytes (con
+ *                  --zerocopy, bytes por llamada).
+ *  - [--zerocopy=M]: Opcional. sendfile, splice o fdpass.
+ *  - [--connections M]: Opcional. Conexiones paralelas. Por defecto 1.
+ *  - [--cold|--warm]: Opcional. Desalojar o precargar solo el archivo de
+ *                     entrada antes de medir (ver common/cache_state.h).
+ *  - [--sample-ms N]: Opcional. Cada N ms anota los bytes transferidos e informa
+ *                     la serie de MB/s y el mayor parón (ver common/sampler.h).
+ *  - [--json] [--json-out F] [--tag K=V]: Opcionales. Resultados en JSON, una
+ *                     línea por bloque con los metadatos de la ejecución (ver common/report.h).
  */
 
+#define MAX_CONNECTIONS 1024
+
+enum zerocopy_mode { ZC_NONE, ZC_SENDFILE, ZC_SPLICE, ZC_FDPASS };
+
+static const char *zerocopy_names[] = { "none", "sendfile", "splice", "fdpass" };
+
+// Parámetros y resultados de una conexión
+struct connection {
+    const struct sockaddr_un *server_addr;
+    const char *input_path;
+    long buffer_size;
+    enum zerocopy_mode zerocopy;
+
+    struct send_stats stats;
+    long long bytes_sent;
+    double time_taken;
+};
+
 void print_usage(const char *prog_name) {
-    fprintf(stderr, "Uso: %s <socket_path> <fichero_entrada> <tam_buffer>\n", prog_name);
+    fprintf(stderr, "Uso: %s <socket_path> <fichero_entrada> <tam_buffer> "
+                    "[--zerocopy=sendfile|splice|fdpass] [--connections M] " CACHE_STATE_USAGE " " SAMPLER_USAGE " " REPORT_USAGE "\n", prog_name);
 }
 
-int main(int argc, char *argv[]) {
-    if (argc != 4) {
-        print_usage(argv[0]);
-        exit(EXIT_FAILURE);
-    }
+static double timeval_to_sec(const struct timeval *tv) {
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
 
-    const char *socket_path = argv[1];
-    const char *input_path = argv[2];
-    long buffer_size = atol(argv[3]);
+// Pasa fd_in al servidor con SCM_RIGHTS y espera los bytes que materializó
+static long long send_with_fdpass(int sock, int fd_in, struct send_stats *st) {
+    char byte = 'F'; // SCM_RIGHTS necesita al menos un byte de datos
+    struct iovec iov = { .iov_base = &byte, .iov_len = 1 };
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
 
-    if (buffer_size <= 0) {
-        fprintf(stderr, "Error: El tamaño del buffer debe ser un entero positivo.\n");
-        exit(EXIT_FAILURE);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd_in, sizeof(int));
+
+    ssize_t n;
+    do {
+        n = IO_TRACE(IO_OP_SEND, sendmsg(sock, &msg, 0));
+    } while (n == -1 && errno == EINTR);
+    if (n == -1) {
+        perror("Error en sendmsg(SCM_RIGHTS) del cliente");
+        return -1;
     }
+    st->send_calls++;
+    // Nada más que enviar: un servidor sin --recv=fd verá EOF en vez de esperar
+    shutdown(sock, SHUT_WR);
+
+    uint64_t reply;
+    do {
+        n = IO_TRACE(IO_OP_RECV, recv(sock, &reply, sizeof(reply), MSG_WAITALL));
+    } while (n == -1 && errno == EINTR);
+    if (n != (ssize_t)sizeof(reply)) {
+        if (n == -1) perror("Error al recibir la confirmación del servidor");
+        else fprintf(stderr, "Error: El servidor cerró sin confirmar (¿falta --recv=fd?).\n");
+        return -1;
+    }
+    return (long long)be64toh(reply);
+}
+
+// Abre el archivo, se conecta y envía. El tiempo medido empieza tras connect(),
+// igual que en el modo de una sola conexión. Devuelve NULL (uso con pthread).
+static void *run_connection(void *arg) {
+    struct connection *c = arg;
+    c->bytes_sent = -1;
 
     // --- Abrir archivo de entrada ---
-    int fd_in = open(input_path, O_RDONLY);
+    // Cada conexión usa su propio descriptor para tener su propio offset.
+    int fd_in = open(c->input_path, O_RDONLY);
     if (fd_in == -1) {
         perror("Error al abrir el archivo de entrada");
-        exit(EXIT_FAILURE);
+        return NULL;
     }
 
-    // --- Configuración del socket ---
-    int client_sock;
-    struct sockaddr_un server_addr;
+    struct stat file_stat;
+    if (fstat(fd_in, &file_stat) == -1) {
+        perror("Error en fstat");
+        close(fd_in);
+        return NULL;
+    }
+    off_t file_size = file_stat.st_size;
 
-    client_sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    // --- Configuración del socket ---
+    int client_sock = socket(AF_UNIX, SOCK_STREAM, 0);
     if (client_sock == -1) {
         perror("Error al crear el socket del cliente");
         close(fd_in);
-        exit(EXIT_FAILURE);
+        return NULL;
     }
 
-    memset(&server_addr, 0, sizeof(struct sockaddr_un));
-    server_addr.sun_family = AF_UNIX;
-    strncpy(server_addr.sun_path, socket_path, sizeof(server_addr.sun_path) - 1);
-
     // Conectarse al servidor
-    if (connect(client_sock, (struct sockaddr *)&server_addr, sizeof(struct sockaddr_un)) == -1) {
+    if (connect(client_sock, (const struct sockaddr *)c->server_addr, sizeof(struct sockaddr_un)) == -1) {
         perror("Error al conectar con el servidor");
         close(fd_in);
         close(client_sock);
+        return NULL;
+    }
+
+    // --- Enviar datos ---
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    switch (c->zerocopy) {
+        case ZC_SENDFILE:     c->bytes_sent = send_with_sendfile(client_sock, fd_in, file_size, c->buffer_size, &c->stats); break;
+        case ZC_SPLICE:       c->bytes_sent = send_with_splice(client_sock, fd_in, file_size, c->buffer_size, &c->stats); break;
+        case ZC_FDPASS:       c->bytes_sent = send_with_fdpass(client_sock, fd_in, &c->stats); break;
+        default:              c->bytes_sent = send_copy(client_sock, fd_in, c->buffer_size, &c->stats); break;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    c->time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    // --- Limpieza ---
+    close(fd_in);
+    close(client_sock); // Cierra la conexión, el servidor verá EOF (recv retorna 0)
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    enum cache_state cache_state = CACHE_STATE_DEFAULT;
+    enum zerocopy_mode zerocopy = ZC_NONE;
+    long connections = 1;
+
+    static struct option long_options[] = {
+        {"zerocopy", required_argument, NULL, 'z'},
+        {"connections", required_argument, NULL, 'c'},
+        CACHE_STATE_LONG_OPTIONS,
+        REPORT_LONG_OPTIONS,
+        SAMPLER_LONG_OPTIONS,
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'z':
+                if (strcmp(optarg, "sendfile") == 0) {
+                    zerocopy = ZC_SENDFILE;
+                } else if (strcmp(optarg, "splice") == 0) {
+                    zerocopy = ZC_SPLICE;
+                } else if (strcmp(optarg, "msg_zerocopy") == 0) {
+                    // Fallaría tras connect() y el servidor daría por buena una subida vacía
+                    fprintf(stderr, "Error: MSG_ZEROCOPY solo está soportado en TCP/UDP, no en sockets UNIX.\n");
+                    exit(EXIT_FAILURE);
+                } else if (strcmp(optarg, "fdpass") == 0) {
+                    zerocopy = ZC_FDPASS;
+                } else {
+                    fprintf(stderr, "Error: Modo zero-copy desconocido '%s'.\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'c': connections = atol(optarg); break;
+            default:
+                if (report_parse_option(opt, optarg) == 1) break;
+                if (sampler_parse_option(opt, optarg) == 1) break;
+                if (cache_state_parse_option(opt, &cache_state)) break;
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 3) {
+        print_usage(argv[0]);
         exit(EXIT_FAILURE);
     }
-    
-    // --- Asignar búfer y enviar datos ---
-    char *buffer = malloc(buffer_size);
-    if (buffer == NULL) {
-        perror("Error al asignar memoria para el buffer");
-        close(fd_in);
-        close(client_sock);
+
+    const char *socket_path = argv[optind];
+    const char *input_path = argv[optind + 1];
+    long buffer_size = atol(argv[optind + 2]);
+    report_path("Input", input_path);
+    report_start(argc, argv);
+
+    if (buffer_size <= 0) {
+        fprintf(stderr, "Error: El tamaño del buffer debe ser un entero positivo.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (connections <= 0 || connections > MAX_CONNECTIONS) {
+        fprintf(stderr, "Error: El número de conexiones debe estar entre 1 y %d.\n", MAX_CONNECTIONS);
+        exit(EXIT_FAILURE);
+    }
+    if (zerocopy == ZC_FDPASS && connections > 1) {
+        fprintf(stderr, "Error: --zerocopy=fdpass requiere un servidor de una conexión (sin --connections).\n");
         exit(EXIT_FAILURE);
     }
 
-    struct timespec start, end;
-    long read_calls = 0;
-    long send_calls = 0;
-    ssize_t bytes_read;
+    // --- Estado del cache de la entrada ---
+    struct cache_report cache_report;
+    if (cache_state_prepare(cache_state, input_path, &cache_report) == -1) {
+        exit(EXIT_FAILURE);
+    }
 
-    clock_gettime(CLOCK_MONOTONIC, &start);
+    struct sockaddr_un server_addr;
+    memset(&server_addr, 0, sizeof(struct sockaddr_un));
+    server_addr.sun_family = AF_UNIX;
+    strncpy(server_addr.sun_path, socket_path, sizeof(server_addr.sun_path) - 1);
 
-    while ((bytes_read = read(fd_in, buffer, buffer_size)) > 0) {
-        read_calls++;
-        if (send(client_sock, buffer, bytes_read, 0) == -1) {
-            perror("Error en send del cliente");
-            // Salir del bucle en caso de error
-            break;
-        }
-        send_calls++;
+    struct connection *conns = calloc(connections, sizeof(struct connection));
+    if (conns == NULL) {
+        perror("Error al asignar memoria para las conexiones");
+        exit(EXIT_FAILURE);
     }
+    for (long i = 0; i < connections; i++) {
+        conns[i].server_addr = &server_addr;
+        conns[i].input_path = input_path;
+        conns[i].buffer_size = buffer_size;
+        conns[i].zerocopy = zerocopy;
+    }
+
+    // --- Enviar datos ---
+    struct timespec start, end;
+    struct rusage ru_start, ru_end;
+    int failed = 0;
+
+    io_trace_begin();
+    sampler_start();
+    getrusage(RUSAGE_SELF, &ru_start);
+    clock_gettime(CLOCK_MONOTONIC, &start);
 
-    if (bytes_read == -1) {
-        perror("Error de lectura del archivo de entrada");
+    if (send_run_connections(run_connection, conns, sizeof(struct connection), connections) == -1) {
+        failed = 1;
     }
 
     clock_gettime(CLOCK_MONOTONIC, &end);
-    double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    getrusage(RUSAGE_SELF, &ru_end);
+    io_trace_end();
+    sampler_stop();
+    double wall_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    double user_time = timeval_to_sec(&ru_end.ru_utime) - timeval_to_sec(&ru_start.ru_utime);
+    double sys_time = timeval_to_sec(&ru_end.ru_stime) - timeval_to_sec(&ru_start.ru_stime);
 
-    // --- Limpieza ---
-    free(buffer);
-    close(fd_in);
-    close(client_sock); // Cierra la conexión, el servidor verá EOF (recv retorna 0)
+    // --- Agregar resultados de todas las conexiones ---
+    struct send_stats total = {0};
+    long long bytes_sent = 0;
+    double *latencies = calloc(connections, sizeof(double));
+    for (long i = 0; i < connections; i++) {
+        struct connection *c = &conns[i];
+        if (c->bytes_sent < 0) {
+            failed = 1;
+            continue;
+        }
+        bytes_sent += c->bytes_sent;
+        send_stats_add(&total, &c->stats);
+        if (latencies != NULL) latencies[i] = c->time_taken;
+    }
+    // Con una sola conexión se mantiene el tiempo medido tras connect()
+    double time_taken = connections == 1 ? conns[0].time_taken : wall_time;
+
+    if (failed) {
+        free(latencies);
+        free(conns);
+        exit(EXIT_FAILURE);
+    }
 
     // --- Imprimir resultados para el parser ---
     printf("Mechanism: UNIX Socket Client\n");
     printf("BufferSize: %ld\n", buffer_size);
     printf("TimeTakenClient: %.6f\n", time_taken);
-    printf("ReadCalls: %ld\n", read_calls);
-    printf("SendCalls: %ld\n", send_calls);
+    cache_state_print(&cache_report);
+    printf("ZeroCopy: %s\n", zerocopy_names[zerocopy]);
+    printf("BytesSent: %lld\n", bytes_sent);
+    send_stats_print(&total, 0);
+    if (connections > 1 && latencies != NULL) {
+        send_print_connections(latencies, connections, bytes_sent, wall_time);
+    }
+    printf("UserTime: %.6f\n", user_time);
+    printf("SysTime: %.6f\n", sys_time);
+    printf("CpuNsPerByte: %.4f\n", bytes_sent > 0 ? (user_time + sys_time) * 1e9 / bytes_sent : 0.0);
+    sampler_print();
+    io_trace_print();
 
+    free(latencies);
+    free(conns);
     return 0;
-} 
\ No newline at end of file
+}
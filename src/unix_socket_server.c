@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -5,8 +6,24 @@
 #include <fcntl.h>
 #include <time.h>
 #include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <endian.h>
+#include <stdint.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
 #include <sys/socket.h>
+#include <sys/resource.h>
 #include <sys/un.h>
+#include <linux/fs.h>
+
+#include "dio_align.h"
+#include "epoll_server.h"
+#include "recv_paths.h"
+#include "io_trace.h"
+#include "report.h"
+#include "sampler.h"
 
 /**
  * unix_socket_server.c
@@ -21,33 +38,290 @@
  * que sean más rápidos que TCP/IP para comunicación local al evitar la
  * sobrecarga de la pila de red.
  *
+ * Por defecto cada bloque se recibe con recv() a un búfer de usuario y se
+ * escribe con write(). Con --recv se puede elegir un camino que no toque
+ * los datos desde el espacio de usuario o que evite el cache de página:
+ *  - splice: splice() del socket a una tubería y de ésta al archivo; el
+ *            servidor nunca copia los bytes de la carga útil.
+ *  - direct: el archivo de salida se abre con O_DIRECT y los datos se
+ *            reciben en un anillo de búferes alineados que un hilo escritor
+ *            vuelca mientras se recibe el siguiente, de modo que cada
+ *            write() es de tamaño y dirección alineados (alineación de
+ *            statx(STATX_DIOALIGN), ver common/recv_paths.h). El último
+ *            bloque se rellena y el archivo se recorta al final.
+ *  - fd:     no se reciben bytes: el cliente (--zerocopy=fdpass) envía el
+ *            descriptor abierto de su archivo con SCM_RIGHTS y el servidor
+ *            materializa la salida a partir de él con --fd-method: reflink
+ *            (ioctl FICLONE, comparte extents sin copiar), copy_file_range o
+ *            sendfile. Si el método no está soportado para estos archivos se
+ *            recurre al siguiente y se informa en FallbackFrom. Al terminar se
+ *            responde al cliente con los bytes materializados (8 bytes, big
+ *            endian) para que su tiempo cubra la operación completa.
+ * Se informa el tiempo de CPU de usuario y de sistema (getrusage) del
+ * intervalo medido y su coste por byte recibido.
+ *
+ * Con --epoll el servidor deja de atender una única conexión y pasa a ser
+ * persistente: un bucle de eventos epoll (edge-triggered, sockets no
+ * bloqueantes) atiende muchas subidas simultáneas, cada una escrita en su
+ * propio archivo <fichero_salida>.<n>. Termina tras --max-conns conexiones
+ * completadas o al recibir SIGINT/SIGTERM, e informa el rendimiento agregado
+ * y los percentiles de la duración de cada conexión.
+ *
  * Argumentos:
  *  - <socket_path>: Ruta del sistema de archivos para el socket.
  *  - <fichero_salida>: Ruta al archivo donde se guardarán los datos recibidos.
- *  - <tam_buffer>: Tamaño del búfer de recepción/escritura en bytes.
+ *  - <tam_buffer>: Tamaño del búfer de recepción/escritura en bytes (con
+ *                  --recv=direct, múltiplo de la alineación).
+ *  - [--recv=M]: Opcional. splice, direct o fd.
+ *  - [--fd-method M]: Opcional. Con --recv=fd: reflink, copy_file_range o
+ *                     sendfile. Por defecto reflink.
+ *  - [--epoll]: Opcional. Modo persistente multi-cliente.
+ *  - [--max-conns K]: Opcional. Con --epoll, terminar tras K conexiones
+ *                     (0 = hasta recibir una señal). Por defecto 0.
+ *  - [--sample-ms N]: Opcional. Cada N ms anota los bytes transferidos e informa
+ *                     la serie de MB/s y el mayor parón (ver common/sampler.h).
+ *  - [--json] [--json-out F] [--tag K=V]: Opcionales. Resultados en JSON, una
+ *                     línea por bloque con los metadatos de la ejecución (ver common/report.h).
  */
 
 #define MAX_PENDING_CONNECTIONS 1
+#define EPOLL_BACKLOG SOMAXCONN
+
+
+enum recv_mode { RECV_COPY, RECV_SPLICE, RECV_DIRECT, RECV_FD };
+
+static const char *recv_mode_names[] = { "copy", "splice", "direct", "fd" };
+
+// Formas de materializar la salida con --recv=fd, en orden de recurso
+enum fd_method { FD_REFLINK, FD_COPY_FILE_RANGE, FD_SENDFILE };
+
+static const char *fd_method_names[] = { "reflink", "copy_file_range", "sendfile" };
+
+// Contadores de llamadas al sistema del bucle de recepción
+static struct recv_stats stats;
+static long fd_copy_calls = 0;    // ioctl/copy_file_range/sendfile de --recv=fd
+
+static volatile sig_atomic_t stop_requested = 0;
 
 void print_usage(const char *prog_name) {
-    fprintf(stderr, "Uso: %s <socket_path> <fichero_salida> <tam_buffer>\n", prog_name);
+    fprintf(stderr, "Uso: %s <socket_path> <fichero_salida> <tam_buffer> [--recv=splice|direct|fd] "
+                    "[--fd-method reflink|copy_file_range|sendfile] [--epoll] [--max-conns K] " SAMPLER_USAGE " " REPORT_USAGE "\n", prog_name);
+}
+
+static void handle_stop_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static double timeval_to_sec(const struct timeval *tv) {
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+// Indica si un error significa "este método no sirve para estos archivos"
+static int is_unsupported(int err) {
+    return err == ENOSYS || err == EXDEV || err == EOPNOTSUPP || err == EINVAL || err == ENOTTY;
+}
+
+// Recibe el descriptor enviado por el cliente con SCM_RIGHTS. Devuelve -1 si hay error.
+static int recv_fd(int sock) {
+    char byte;
+    struct iovec iov = { .iov_base = &byte, .iov_len = 1 };
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t n;
+    do {
+        n = IO_TRACE(IO_OP_RECV, recvmsg(sock, &msg, MSG_CMSG_CLOEXEC));
+    } while (n == -1 && errno == EINTR);
+    stats.recv_calls++;
+    if (n == -1) {
+        perror("Error en recvmsg del servidor");
+        return -1;
+    }
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (n == 0 || cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+        cmsg->cmsg_len != CMSG_LEN(sizeof(int))) {
+        fprintf(stderr, "Error: El cliente no envió un descriptor (¿falta --zerocopy=fdpass?).\n");
+        return -1;
+    }
+    int fd;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return fd;
+}
+
+// Materializa la salida a partir del descriptor recibido, empezando por
+// *method y recurriendo a los siguientes si no está soportado. Siempre se
+// usan offsets explícitos: el descriptor comparte offset con el del cliente.
+static long long materialize_fd(int fd_in, int fd_out, long chunk, enum fd_method *method) {
+    struct stat st;
+    if (fstat(fd_in, &st) == -1) {
+        perror("Error en fstat del descriptor recibido");
+        return -1;
+    }
+    off_t file_size = st.st_size;
+
+    if (*method == FD_REFLINK) {
+        fd_copy_calls++;
+        if (ioctl(fd_out, FICLONE, fd_in) == 0) {
+            return file_size;
+        }
+        if (!is_unsupported(errno)) {
+            perror("Error en ioctl(FICLONE)");
+            return -1;
+        }
+        *method = FD_COPY_FILE_RANGE;
+    }
+
+    if (*method == FD_COPY_FILE_RANGE) {
+        loff_t off_in = 0, off_out = 0;
+        while (off_in < file_size) {
+            size_t want = (file_size - off_in < chunk) ? (size_t)(file_size - off_in) : (size_t)chunk;
+            ssize_t copied = IO_TRACE(IO_OP_COPY_FILE_RANGE, copy_file_range(fd_in, &off_in, fd_out, &off_out, want, 0));
+            fd_copy_calls++;
+            if (copied == -1) {
+                if (errno == EINTR) continue;
+                if (off_in == 0 && is_unsupported(errno)) {
+                    *method = FD_SENDFILE;
+                    break;
+                }
+                perror("Error en copy_file_range");
+                return -1;
+            }
+            if (copied == 0) {
+                break;
+            }
+            sampler_add(copied);
+        }
+        if (*method == FD_COPY_FILE_RANGE) {
+            return off_in;
+        }
+    }
+
+    off_t offset = 0;
+    while (offset < file_size) {
+        size_t want = (file_size - offset < chunk) ? (size_t)(file_size - offset) : (size_t)chunk;
+        ssize_t sent = IO_TRACE(IO_OP_SENDFILE, sendfile(fd_out, fd_in, &offset, want));
+        fd_copy_calls++;
+        if (sent == -1) {
+            if (errno == EINTR) continue;
+            perror("Error en sendfile");
+            return -1;
+        }
+        if (sent == 0) {
+            break;
+        }
+        sampler_add(sent);
+    }
+    return offset;
+}
+
+// --recv=fd: recibe el descriptor, materializa la salida y confirma al cliente
+static long long recv_with_fd(int sock, int fd_out, long chunk, enum fd_method *method) {
+    int fd_in = recv_fd(sock);
+    if (fd_in == -1) {
+        return -1;
+    }
+    long long total = materialize_fd(fd_in, fd_out, chunk, method);
+    close(fd_in);
+    if (total < 0) {
+        return -1;
+    }
+
+    uint64_t reply = htobe64((uint64_t)total);
+    if (IO_TRACE(IO_OP_SEND, send(sock, &reply, sizeof(reply), MSG_NOSIGNAL)) != (ssize_t)sizeof(reply)) {
+        perror("Error al confirmar al cliente");
+        return -1;
+    }
+    return total;
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 4) {
+    enum recv_mode mode = RECV_COPY;
+    enum fd_method method = FD_REFLINK;
+    int use_epoll = 0;
+    long max_conns = 0;
+
+    static struct option long_options[] = {
+        {"recv", required_argument, NULL, 'r'},
+        {"fd-method", required_argument, NULL, 'm'},
+        {"epoll", no_argument, NULL, 'e'},
+        {"max-conns", required_argument, NULL, 'k'},
+        REPORT_LONG_OPTIONS,
+        SAMPLER_LONG_OPTIONS,
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'r':
+                if (strcmp(optarg, "splice") == 0) {
+                    mode = RECV_SPLICE;
+                } else if (strcmp(optarg, "direct") == 0) {
+                    mode = RECV_DIRECT;
+                } else if (strcmp(optarg, "fd") == 0) {
+                    mode = RECV_FD;
+                } else {
+                    fprintf(stderr, "Error: Modo de recepción desconocido '%s'.\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'm':
+                if (strcmp(optarg, "reflink") == 0) {
+                    method = FD_REFLINK;
+                } else if (strcmp(optarg, "copy_file_range") == 0) {
+                    method = FD_COPY_FILE_RANGE;
+                } else if (strcmp(optarg, "sendfile") == 0) {
+                    method = FD_SENDFILE;
+                } else {
+                    fprintf(stderr, "Error: Método de materialización desconocido '%s'.\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'e': use_epoll = 1; break;
+            case 'k': max_conns = atol(optarg); break;
+            default:
+                if (report_parse_option(opt, optarg) == 1) break;
+                if (sampler_parse_option(opt, optarg) == 1) break;
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 3) {
         print_usage(argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    const char *socket_path = argv[1];
-    const char *output_path = argv[2];
-    long buffer_size = atol(argv[3]);
+    const char *socket_path = argv[optind];
+    const char *output_path = argv[optind + 1];
+    long buffer_size = atol(argv[optind + 2]);
+    report_path("Output", output_path);
+    report_start(argc, argv);
 
     if (buffer_size <= 0) {
         fprintf(stderr, "Error: El tamaño del buffer debe ser un entero positivo.\n");
         exit(EXIT_FAILURE);
     }
 
+    if (use_epoll && mode != RECV_COPY) {
+        fprintf(stderr, "Error: --epoll solo admite el modo de recepción por defecto.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (max_conns < 0) {
+        fprintf(stderr, "Error: --max-conns debe ser un entero no negativo.\n");
+        exit(EXIT_FAILURE);
+    }
+
     // --- Configuración del socket ---
     int server_sock, client_sock;
     struct sockaddr_un server_addr, client_addr;
@@ -76,78 +350,152 @@ int main(int argc, char *argv[]) {
     }
 
     // Escuchar conexiones entrantes
-    if (listen(server_sock, MAX_PENDING_CONNECTIONS) == -1) {
+    if (listen(server_sock, use_epoll ? EPOLL_BACKLOG : MAX_PENDING_CONNECTIONS) == -1) {
         perror("Error en listen");
         close(server_sock);
         exit(EXIT_FAILURE);
     }
 
-    // printf("Servidor UNIX esperando conexión en %s\n", socket_path);
+    if (use_epoll) {
+        // Sin SA_RESTART, para que epoll_wait vuelva al recibir la señal
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = handle_stop_signal;
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
 
-    // Aceptar una conexión (bloqueante)
-    client_sock = accept(server_sock, (struct sockaddr *)&client_addr, &client_addr_len);
-    if (client_sock == -1) {
-        perror("Error en accept");
+        struct epoll_server srv = {
+            .output_path = output_path,
+            .buffer_size = buffer_size,
+            .max_conns = max_conns,
+            .stop = &stop_requested,
+        };
+        struct epoll_stats st;
+        struct rusage ru_start, ru_end;
+        memset(&st, 0, sizeof(st));
+
+        io_trace_begin();
+        sampler_start();
+        getrusage(RUSAGE_SELF, &ru_start);
+        int ret = epoll_server_run(server_sock, &srv, &st);
+        getrusage(RUSAGE_SELF, &ru_end);
+        io_trace_end();
+        sampler_stop();
         close(server_sock);
-        exit(EXIT_FAILURE);
+        unlink(socket_path);
+
+        if (ret == -1) {
+            free(st.latencies);
+            exit(EXIT_FAILURE);
+        }
+        epoll_stats_print("UNIX Socket Server (epoll)", &srv, &st,
+                          timeval_to_sec(&ru_end.ru_utime) - timeval_to_sec(&ru_start.ru_utime),
+                          timeval_to_sec(&ru_end.ru_stime) - timeval_to_sec(&ru_start.ru_stime));
+        free(st.latencies);
+        return 0;
     }
 
     // --- Abrir archivo de salida ---
-    int fd_out = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    // Antes de aceptar, para rechazar un búfer no alineado sin dejar al cliente a medias
+    int fd_out = open(output_path, O_WRONLY | O_CREAT | O_TRUNC | (mode == RECV_DIRECT ? O_DIRECT : 0), 0644);
     if (fd_out == -1) {
         perror("Error al abrir el archivo de salida");
-        close(client_sock);
         close(server_sock);
+        unlink(socket_path);
         exit(EXIT_FAILURE);
     }
+    struct dio_align align;
+    if (mode == RECV_DIRECT) {
+        if (dio_align_probe(fd_out, &align) == -1) {
+            fprintf(stderr, "Error: El sistema de archivos de la salida no admite O_DIRECT.\n");
+            close(fd_out);
+            close(server_sock);
+            unlink(socket_path);
+            exit(EXIT_FAILURE);
+        }
+        if (buffer_size % align.offset_align != 0) {
+            fprintf(stderr, "Error: Con --recv=direct el tamaño del buffer debe ser múltiplo de %u.\n", align.offset_align);
+            close(fd_out);
+            close(server_sock);
+            unlink(socket_path);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // printf("Servidor UNIX esperando conexión en %s\n", socket_path);
 
-    // --- Asignar búfer y recibir datos ---
-    char *buffer = malloc(buffer_size);
-    if (buffer == NULL) {
-        perror("Error al asignar memoria para el buffer");
+    // Aceptar una conexión (bloqueante)
+    client_sock = accept(server_sock, (struct sockaddr *)&client_addr, &client_addr_len);
+    if (client_sock == -1) {
+        perror("Error en accept");
         close(fd_out);
-        close(client_sock);
         close(server_sock);
         exit(EXIT_FAILURE);
     }
 
+    // --- Recibir datos ---
     struct timespec start, end;
-    long recv_calls = 0;
-    long write_calls = 0;
-    ssize_t bytes_received;
+    struct rusage ru_start, ru_end;
+    long long bytes_received;
+    enum fd_method requested_method = method;
 
+    io_trace_begin();
+    sampler_start();
+    getrusage(RUSAGE_SELF, &ru_start);
     clock_gettime(CLOCK_MONOTONIC, &start);
 
-    while ((bytes_received = recv(client_sock, buffer, buffer_size, 0)) > 0) {
-        recv_calls++;
-        ssize_t bytes_written = write(fd_out, buffer, bytes_received);
-        write_calls++;
-        if (bytes_written != bytes_received) {
-            perror("Error de escritura incompleta en el servidor");
-            break; // Salir del bucle en caso de error
-        }
-    }
-
-    if (bytes_received == -1) {
-        perror("Error en recv del servidor");
+    switch (mode) {
+        case RECV_SPLICE: bytes_received = recv_with_splice(client_sock, fd_out, buffer_size, NULL, &stats); break;
+        case RECV_DIRECT: bytes_received = recv_direct(client_sock, fd_out, buffer_size, &align, NULL, &stats); break;
+        case RECV_FD:     bytes_received = recv_with_fd(client_sock, fd_out, buffer_size, &method); break;
+        default:          bytes_received = recv_copy(client_sock, fd_out, buffer_size, NULL, &stats); break;
     }
 
     clock_gettime(CLOCK_MONOTONIC, &end);
+    getrusage(RUSAGE_SELF, &ru_end);
+    io_trace_end();
+    sampler_stop();
     double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
-    
+    double user_time = timeval_to_sec(&ru_end.ru_utime) - timeval_to_sec(&ru_start.ru_utime);
+    double sys_time = timeval_to_sec(&ru_end.ru_stime) - timeval_to_sec(&ru_start.ru_stime);
+
     // --- Limpieza ---
-    free(buffer);
     close(fd_out);
     close(client_sock);
     close(server_sock);
     unlink(socket_path); // Eliminar el archivo del socket
 
+    if (bytes_received < 0) {
+        exit(EXIT_FAILURE);
+    }
+
     // --- Imprimir resultados para el parser ---
     printf("Mechanism: UNIX Socket Server\n");
     printf("BufferSize: %ld\n", buffer_size);
     printf("TimeTakenServer: %.6f\n", time_taken);
-    printf("RecvCalls: %ld\n", recv_calls);
-    printf("WriteCalls: %ld\n", write_calls);
+    printf("RecvMode: %s\n", recv_mode_names[mode]);
+    printf("BytesReceived: %lld\n", bytes_received);
+    printf("RecvCalls: %ld\n", stats.recv_calls);
+    printf("WriteCalls: %ld\n", stats.write_calls);
+    printf("SpliceCalls: %ld\n", stats.splice_calls);
+    if (mode == RECV_DIRECT) {
+        printf("RecvRingSlots: %d\n", RECV_RING_SLOTS);
+        printf("DioMemAlign: %u\n", align.mem_align);
+        printf("DioOffsetAlign: %u\n", align.offset_align);
+        printf("DioAlignSource: %s\n", align.from_statx ? "statx" : "fallback");
+    }
+    if (mode == RECV_FD) {
+        printf("FdMethod: %s\n", fd_method_names[method]);
+        printf("FdCopyCalls: %ld\n", fd_copy_calls);
+        if (method != requested_method) {
+            printf("FallbackFrom: %s\n", fd_method_names[requested_method]);
+        }
+    }
+    printf("UserTime: %.6f\n", user_time);
+    printf("SysTime: %.6f\n", sys_time);
+    printf("CpuNsPerByte: %.4f\n", bytes_received > 0 ? (user_time + sys_time) * 1e9 / bytes_received : 0.0);
+    sampler_print();
+    io_trace_print();
 
     return 0;
 } 
\ No newline at end of file